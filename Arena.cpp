@@ -1,139 +1,306 @@
 #include "Arena.h"
+#include "Replay.h"
+#include "ConsoleSink.h"
+#include "IsolatedRobot.h"
+#include "MapFile.h"
+#include "TerminalRenderer.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
-#include <ctime>
+#include <algorithm>
+#include <cctype>
 #include <cmath>
-#include <dirent.h>
-#include <dlfcn.h>
+#include <random>
+
+static ConsoleSink console_sink;
+static EventSink silent_sink;
+
+// A fresh seed for arenas nobody asked to be reproducible.
+static std::uint64_t random_seed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) | device();
+}
 
 Arena::Arena()
-    : rows(20),
+    : sink(&console_sink),
+      game_seed(0),
+      rows(20),
       cols(20),
       max_rounds(99),
       num_mounds(10),
       num_pits(5),
       num_flames(5) {
+    set_seed(random_seed());
     init_board();
 }
 
-// Format (one line, 6 ints):
-// rows cols num_mounds num_pits num_flames max_rounds 
-bool Arena::load_config(const std::string& filename) {
+Arena::Arena(int rows_in, int cols_in)
+    : sink(&console_sink),
+      game_seed(0),
+      rows(rows_in),
+      cols(cols_in),
+      max_rounds(99),
+      num_mounds(10),
+      num_pits(5),
+      num_flames(5) {
+    set_seed(random_seed());
+    init_board();
+}
+
+// Fields missing from the file keep their defaults. A field that isn't a
+// number is reported on std::cerr, and it and the ones after it keep their
+// defaults too.
+bool read_config(const std::string& filename, ArenaConfig& config) {
     std::ifstream fin(filename);
     if (!fin) {
-        std::cout << "Config file '" << filename
-                  << "' not found. Using default settings.\n";
         return false;
     }
 
-    fin >> rows >> cols
-        >> num_mounds >> num_pits >> num_flames
-        >> max_rounds >> watch_live;
+    static const char* names[] = { "rows", "cols", "num_mounds", "num_pits", "num_flames",
+                                   "max_rounds", "watch_live" };
+    int values[7];
+    int count = 0;
+    while (count < 7 && fin >> values[count]) ++count;
+    if (count < 7 && !fin.eof()) {
+        std::cerr << filename << ": " << names[count] << " isn't a number; it and the "
+                  << "settings after it keep their defaults.\n";
+    }
+
+    int* fields[] = { &config.rows, &config.cols, &config.num_mounds, &config.num_pits,
+                      &config.num_flames, &config.max_rounds };
+    for (int i = 0; i < count && i < 6; ++i) *fields[i] = values[i];
+    if (count == 7) config.watch_live = values[6] != 0;
+    return true;
+}
+
+bool Arena::load_config(const std::string& filename) {
+    ArenaConfig config;
+    if (!read_config(filename, config)) {
+        sink->config_missing(filename);
+        return false;
+    }
+
+    configure(config);
+    sink->config_loaded(rows, cols, num_mounds, num_pits, num_flames, max_rounds);
+    return true;
+}
+
+void Arena::configure(const ArenaConfig& config) {
+    rows = config.rows;
+    cols = config.cols;
+    num_mounds = config.num_mounds;
+    num_pits = config.num_pits;
+    num_flames = config.num_flames;
+    max_rounds = config.max_rounds;
+    watch_live = config.watch_live;
 
     if (rows < 10) rows = 10;
     if (cols < 10) cols = 10;
 
     init_board();
-    std::cout << "Loaded config: " << rows << "x" << cols
-              << ", Mounds=" << num_mounds
-              << ", Pits=" << num_pits
-              << ", Flames=" << num_flames
-              << ", Rounds=" << max_rounds << "\n";
-    return true;
+}
+
+void Arena::set_seed(std::uint64_t seed) {
+    game_seed = seed;
+    rng.seed(seed);
+}
+
+void Arena::set_event_sink(EventSink* s) {
+    sink = s ? s : &silent_sink;
+}
+
+void Arena::set_phase_timing(bool on) {
+    timings = on ? std::make_unique<PhaseTimes>() : nullptr;
+}
+
+// Isolated robots time their own calls and never go through the watchdog.
+void Arena::set_call_budget(std::chrono::microseconds budget) {
+    call_budget = budget;
+    watchdog = budget.count() > 0 ? std::make_unique<Watchdog>(budget) : nullptr;
+    for (RobotInfo& info : robots) {
+        if (info.isolated) info.isolated->set_budget(budget);
+    }
+}
+
+void Arena::set_simultaneous(bool on, unsigned int threads) {
+    simultaneous = on;
+    if (threads == 0) threads = TaskScheduler::default_thread_count();
+    turn_pool = on && threads > 1 ? std::make_unique<TaskScheduler>(threads) : nullptr;
+}
+
+void Arena::set_isolation(bool on) {
+    isolate = on;
+}
+
+FootprintCache& Arena::footprint_cache() {
+    static thread_local FootprintCache cache;
+    return cache;
+}
+
+const RobotInfo* Arena::winner() const {
+    return winner_index == -1 ? nullptr : &robots[winner_index];
 }
 
 void Arena::init_board() {
-    board.assign(rows, std::vector<char>(cols, '.'));
+    board.assign(rows, cols, '.');
+    radar.reset(rows, cols);
+    planes.reset(rows, cols);
+    map_file.reset();
+    clear_robots();
 }
 
-void Arena::load_obstacles() {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+void Arena::clear_robots() {
+    occupancy.assign(rows, cols, 0);
+    robots.clear();
+    next_symbol_index = 0;
+}
 
-    auto place_some = [&](char ch, int count) {
-        int placed = 0;
-        while (placed < count) {
-            int r = std::rand() % rows;
-            int c = std::rand() % cols;
-            if (board[r][c] == '.') {
-                board[r][c] = ch;
-                placed++;
-            }
-        }
-    };
+// Everything that depends only on the obstacles comes straight from the
+// map; only the occupancy grid and the robot planes start fresh, as zeros.
+bool Arena::load_map(const std::string& path) {
+    std::unique_ptr<MapFile> map = MapFile::open(path);
+    if (!map) return false;
+
+    rows = map->rows();
+    cols = map->cols();
+    board.view(rows, cols, map->cells());
+    radar.view(rows, cols, map->radar_words());
+    planes.view(rows, cols, map->obstacle_words());
+    map_file = std::move(map);
+    clear_robots();
+    return true;
+}
 
-    place_some('M', num_mounds);
-    place_some('P', num_pits);
-    place_some('F', num_flames);
+bool Arena::save_map(const std::string& path) const {
+    return save_map_file(path, board);
 }
 
-void Arena::load_robots() {
-    DIR* dir = opendir(".");
-    if (!dir) {
-        std::cerr << "Could not open current directory.\n";
-        return;
-    }
+// Uniform in [lo, hi].
+int Arena::random_int(int lo, int hi) {
+    return rng.between(lo, hi);
+}
+
+int Arena::free_cells() const {
+    return rows * cols - planes.count_any(CellPlanes::all);
+}
 
-    const char* prefix = "Robot_";
-    const char* suffix = ".cpp";
+// Placements from here on see `free` free cells, the board's count.
+void Arena::start_placement(int free) {
+    placement_free = free;
+    placement.clear();
+}
 
-    dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        std::string filename = entry->d_name;
-        if (filename.rfind(prefix, 0) != 0) {
-            continue; 
-        }
-        if (filename.size() < 9) {
-            continue;
+// While half the board or more is free, a random cell is free at least
+// every other time, so cells are drawn from the whole board until the
+// radar bitset says one is empty: nothing to set up, and no more than two
+// draws a placement on average. Past that the free cells are listed once,
+// in one pass over the planes, and dealt from the shuffle with no draw
+// wasted. Either way a run of placements costs O(count) at any density,
+// plus that one pass on a crowded board. False, with r and c meaningless,
+// if no cell is free.
+bool Arena::take_free_cell(int& r, int& c) {
+    if (placement_free <= 0) return false;
+    const std::uint32_t cells = static_cast<std::uint32_t>(rows * cols);
+    if (static_cast<std::uint32_t>(placement_free) * 2 >= cells) {
+        do {
+            r = random_int(0, rows - 1);
+            c = random_int(0, cols - 1);
+        } while (radar.occupied(r, c));
+    } else {
+        if (placement.remaining() == 0) {
+            placement.reserve(static_cast<std::size_t>(placement_free));
+            planes.for_each_clear(CellPlanes::all, [&](int fr, int fc) {
+                placement.add(static_cast<std::uint32_t>(fr * cols + fc));
+            });
+            if (placement.remaining() == 0) return false;
         }
-        if (filename.substr(filename.size() - 4) != suffix) {
-            continue;
+        std::uint32_t cell = placement.draw(rng);
+        r = static_cast<int>(cell / static_cast<std::uint32_t>(cols));
+        c = static_cast<int>(cell % static_cast<std::uint32_t>(cols));
+    }
+    placement_free--;
+    return true;
+}
+
+bool Arena::load_obstacles() {
+    if (num_mounds < 0 || num_pits < 0 || num_flames < 0) {
+        std::cerr << "Obstacle counts can't be negative (" << num_mounds << " mounds, "
+                  << num_pits << " pits, " << num_flames << " flames).\n";
+        return false;
+    }
+    long long wanted = static_cast<long long>(num_mounds) + num_pits + num_flames;
+    int room = free_cells();
+    if (wanted > room) {
+        std::cerr << "Can't place " << wanted << " obstacles (" << num_mounds << " mounds, "
+                  << num_pits << " pits, " << num_flames << " flames) on a " << rows << "x"
+                  << cols << " board with " << room << " free cells.\n";
+        return false;
+    }
+
+    start_placement(room);
+    auto place_some = [&](char ch, int count) {
+        for (int placed = 0; placed < count; ++placed) {
+            int r, c;
+            if (!take_free_cell(r, c)) return false;
+            board(r, c) = ch;
+            update_cell(r, c);
         }
+        return true;
+    };
 
-        std::string core = filename.substr(6, filename.size() - 6 - 4); 
-        std::string shared_lib = "lib" + core + ".so";
+    if (place_some('M', num_mounds) && place_some('P', num_pits) && place_some('F', num_flames)) {
+        return true;
+    }
+    // Only if free_cells() and the shuffle disagree, which is a bug.
+    std::cerr << "Ran out of free cells placing obstacles on a " << rows << "x" << cols
+              << " board.\n";
+    return false;
+}
 
-        std::string compile_cmd =
-            "g++ -shared -fPIC -o " + shared_lib + " " + filename +
-            " RobotBase.o -I. -std=c++20";
-        std::cout << "Compiling " << filename << " to " << shared_lib << "...\n";
+bool Arena::load_robots(int build_jobs) {
+    return spawn_robots(load_robot_libraries(*sink, build_jobs));
+}
 
-        int result = std::system(compile_cmd.c_str());
-        if (result != 0) {
-            std::cerr << "  Failed to compile " << filename << "\n";
-            continue;
-        }
+bool Arena::has_room_for(std::size_t robot_count) const {
+    int room = free_cells();
+    if (robot_count > static_cast<std::size_t>(room)) {
+        std::cerr << "Can't place " << robot_count << " robots on a " << rows << "x" << cols
+                  << " board with " << room << " free cells.\n";
+        return false;
+    }
+    return true;
+}
 
-        void* handle = dlopen(shared_lib.c_str(), RTLD_LAZY);
-        if (!handle) {
-            std::cerr << "  Failed to load " << shared_lib << ": "
-                      << dlerror() << "\n";
-            continue;
-        }
+// Creates one robot from each library and drops it on a random empty cell.
+bool Arena::spawn_robots(const std::vector<RobotLibrary>& libraries) {
+    static const char symbols[] = { '!', '@', '#', '$', '%', '&', '*', '+', '?', '~' };
 
-        RobotFactory create_robot =
-            (RobotFactory)dlsym(handle, "create_robot");
-        if (!create_robot) {
-            std::cerr << "  Failed to find create_robot in "
-                      << shared_lib << ": " << dlerror() << "\n";
-            dlclose(handle);
-            continue;
-        }
+    if (!has_room_for(libraries.size())) return false;
+    start_placement(free_cells());
 
-        RobotBase* robot = create_robot();
+    for (std::size_t i = 0; i < libraries.size(); ++i) {
+        const RobotLibrary& library = libraries[i];
+        int r, c;
+        if (!take_free_cell(r, c)) {
+            // Only if free_cells() and the shuffle disagree, which is a bug.
+            std::cerr << "Ran out of free cells placing " << library.name << ".\n";
+            return false;
+        }
+        // Only a robot in a process of its own can be stopped mid-call.
+        bool isolated = isolate || call_budget.count() > 0;
+        RobotBase* robot = isolated ? IsolatedRobot::launch(library.create_robot, call_budget,
+                                                            static_cast<unsigned int>(game_seed)).release()
+                                    : library.create_robot();
         if (!robot) {
-            std::cerr << "  create_robot failed.\n";
-            dlclose(handle);
+            std::cerr << "  create_robot failed for " << library.shared_lib << ".\n";
             continue;
         }
+        owned_robots.emplace_back(robot);
 
 		if (robot->m_name == "Blank_Robot" || robot->m_name.empty()) {
-			robot->m_name = core;  
+			robot->m_name = library.name;  
 		}
 
-		static const char symbols[] = { '!', '@', '#', '$', '%', '&', '*', '+', '?', '~' };
-		static int next_symbol_index = 0;
-
 		char symbol;
 		if (next_symbol_index < (int)(sizeof(symbols) / sizeof(symbols[0]))) {
 			symbol = symbols[next_symbol_index++];
@@ -141,125 +308,186 @@ void Arena::load_robots() {
 			symbol = !robot->m_name.empty() ? robot->m_name[0] : '?';
 		}
 
-		if (robot->m_character == '\0') {
+		// RobotBase doesn't initialize m_character, so only a printable
+		// one is taken to be the robot's own choice.
+		if (!std::isgraph(static_cast<unsigned char>(robot->m_character))) {
 			robot->m_character = symbol;
 		}
 
-        int r, c;
-        while (true) {
-            r = std::rand() % rows;
-            c = std::rand() % cols;
-
-            if (board[r][c] != '.') continue;
-            if (find_robot_at(r, c) != -1) continue;
-            break;
-        }
-
-        robot->set_boundaries(rows, cols);
-        robot->move_to(r, c);
-
-        RobotInfo info;
-        info.robot  = robot;
-        info.symbol = robot->m_character; 
-        info.row    = r;
-        info.col    = c;
-        info.alive  = true;
-        info.handle = handle;
-
-        robots.push_back(info);
-
-        std::cout << "Loaded robot: " << robot->m_name
-                  << " at (" << r << "," << c << ")\n";
+        add_robot(robot, r, c, library.handle);
+        robots.back().library = static_cast<int>(i);
+        sink->robot_loaded(robots.back());
     }
+    return true;
+}
 
-    closedir(dir);
+// Places an already-created robot on an empty cell and registers it in the
+// occupancy grid. The caller is responsible for picking a free cell.
+void Arena::add_robot(RobotBase* robot, int r, int c, void* handle) {
+    robot->set_boundaries(rows, cols);
+    robot->move_to(r, c);
+
+    RobotInfo info;
+    info.robot  = robot;
+    info.symbol = robot->m_character; 
+    info.row    = r;
+    info.col    = c;
+    info.alive  = true;
+    info.handle = handle;
+    info.isolated = dynamic_cast<IsolatedRobot*>(robot);
+    if (info.isolated) info.isolated->set_budget(call_budget);
+    info.turns = dynamic_cast<TurnRobot*>(robot);
+
+    occupancy(r, c) = static_cast<int>(robots.size()) + 1;
+    robots.push_back(info);
+    update_cell(r, c);
 }
 
 bool Arena::in_bounds(int r, int c) const {
     return r >= 0 && r < rows && c >= 0 && c < cols;
 }
 
+// Dead robots keep their cell in the occupancy grid, so they still show up
+// here as 'X' and keep blocking movement.
 char Arena::get_cell_type(int r, int c) const {
-    for (const auto& info : robots) {
-        if (info.row == r && info.col == c) {
-            return info.alive ? 'R' : 'X';
-        }
-    }
     if (!in_bounds(r, c)) return '.';
-    return board[r][c];
+    int idx = occupant(r, c);
+    if (idx != -1) {
+        return robots[idx].alive ? 'R' : 'X';
+    }
+    return board(r, c);
 }
 
 int Arena::find_robot_at(int r, int c) const {
-    for (std::size_t i = 0; i < robots.size(); ++i) {
-        if (robots[i].row == r && robots[i].col == c) {
-            return static_cast<int>(i);
-        }
+    if (!in_bounds(r, c)) return -1;
+    return occupant(r, c);
+}
+
+// Every change of a robot's position goes through here so the occupancy
+// grid never disagrees with RobotInfo::row/col.
+void Arena::move_robot(RobotInfo& info, int r, int c) {
+    occupancy(info.row, info.col) = 0;
+    update_cell(info.row, info.col);
+    occupancy(r, c) = static_cast<int>(&info - robots.data()) + 1;
+    update_cell(r, c);
+    info.row = r;
+    info.col = c;
+    info.robot->move_to(r, c);
+}
+
+// Brings the radar index and the cell planes in line with board and
+// occupancy. A cell shows up on radar if it holds an obstacle or any robot,
+// dead or alive.
+void Arena::update_cell(int r, int c) {
+    char cell = board(r, c);
+    int idx = occupant(r, c);
+    radar.set(r, c, cell != '.' || idx != -1);
+    planes.set(CellPlanes::mounds, r, c, cell == 'M');
+    planes.set(CellPlanes::pits, r, c, cell == 'P');
+    planes.set(CellPlanes::flames, r, c, cell == 'F');
+    planes.set(CellPlanes::robots, r, c, idx != -1 && robots[idx].alive);
+    planes.set(CellPlanes::wrecks, r, c, idx != -1 && !robots[idx].alive);
+}
+
+// The wreck stays where it is and keeps blocking the cell.
+void Arena::mark_dead(RobotInfo& info) {
+    info.alive = false;
+    update_cell(info.row, info.col);
+}
+
+// The robot's call has returned, or its process is gone, so the robot is
+// destroyed with the rest when the arena goes.
+void Arena::disqualify(RobotInfo& info, RobotCall call) {
+    if (info.isolated && info.isolated->failure() == RobotFailure::crashed) {
+        info.crashes++;
+        sink->crashed(info, call);
+    } else {
+        info.overruns++;
+        sink->overrun(info, call, call_budget.count() / 1000.0);
     }
-    return -1;
+    info.died_in_round = current_round;
+    mark_dead(info);
+    if (recorder) recorder->death(info);
+    sink->death(info);
 }
 
-void Arena::print_board(int round) const 
-{
+// Live mode redraws only the cells that changed since the last round.
+void Arena::print_board(int round) const {
+    std::string frame = board_frame(round);
     if (watch_live) {
-        std::cout << "\033[H\033[J";
+        TerminalRenderer::screen().draw(frame);
+    } else {
+        std::cout << frame;
     }
+}
+
+std::string Arena::board_frame(int round) const {
+    std::string out;
+    out.reserve(static_cast<std::size_t>(rows) * (6 * cols + 8) + robots.size() * 80 + 128);
 
-    std::cout << "=========== starting round " << round << " ===========\n\n";
+    out += "=========== starting round ";
+    out += std::to_string(round);
+    out += " ===========\n\n";
 
-    std::cout << "    ";
+    out += "    ";
     for (int c = 0; c < cols; ++c) {
-        if (c < 10) std::cout << " " << c << " ";
-        else        std::cout << c << " ";
+        if (c < 10) out += ' ';
+        out += std::to_string(c);
+        out += ' ';
     }
-    std::cout << "\n";
+    out += '\n';
 
     for (int r = 0; r < rows; ++r) {
-        if (r < 10) std::cout << " ";
-        std::cout << r << " ";
+        if (r < 10) out += ' ';
+        out += std::to_string(r);
+        out += ' ';
 
+        const char* board_row = board.row(r);
+        const int* occupancy_row = occupancy.row(r);
         for (int c = 0; c < cols; ++c) {
-            int idx = find_robot_at(r, c);
+            int idx = occupancy_row[c] - 1;
             if (idx != -1) {
                 const RobotInfo& info = robots[idx];
-
-                if (info.alive)
-                    std::cout << "R" << info.symbol << " ";
-                else
-                    std::cout << "X" << info.symbol << " ";
+                out += info.alive ? 'R' : 'X';
+                out += info.symbol;
             } else {
-                std::cout << " " << board[r][c] << " ";
+                out += ' ';
+                out += board_row[c];
             }
+            out += ' ';
         }
-        std::cout << "\n\n";
+        out += "\n\n";
     }
 
     for (const auto& info : robots) {
-        std::cout << info.robot->print_stats();
-        if (!info.alive) std::cout << "  (DEAD)";
-        std::cout << "\n";
+        out += info.robot->print_stats();
+        if (!info.alive) out += "  (DEAD)";
+        out += '\n';
     }
-    std::cout << "\n";
+    out += '\n';
+    return out;
 }
 
 void Arena::update_board() {
 }
 
-bool Arena::check_for_winner() const {
+bool Arena::check_for_winner() {
     int alive_count = 0;
-    const RobotInfo* last = nullptr;
+    int last = -1;
 
-    for (const auto& info : robots) {
-        if (info.alive && info.robot->get_health() > 0) {
+    for (std::size_t i = 0; i < robots.size(); ++i) {
+        if (robots[i].alive && robots[i].robot->get_health() > 0) {
             alive_count++;
-            last = &info;
+            last = static_cast<int>(i);
         }
     }
 
     if (alive_count <= 1) {
-        if (alive_count == 1 && last != nullptr) {
-            std::cout << "Winner: " << last->robot->m_name << "!\n";
+        if (alive_count == 1) {
+            game_result = GameResult::winner;
+            winner_index = last;
         } else {
-            std::cout << "Nobody survived. It's a draw.\n";
+            game_result = GameResult::draw;
         }
         return true;
     }
@@ -267,28 +495,46 @@ bool Arena::check_for_winner() const {
 }
 
 void Arena::run() {
+    game_result = GameResult::none;
+    winner_index = -1;
+    rounds_done = 0;
+
     if (robots.empty()) {
-        std::cout << "No robots loaded. Nothing to do.\n";
+        game_result = GameResult::no_robots;
+        if (recorder) recorder->game_over(game_result, nullptr);
+        sink->game_over(game_result, nullptr);
         return;
     }
 
     for (int round = 0; round < max_rounds; ++round) {
         play_round(round);
+        rounds_done = round + 1;
         if (check_for_winner()) {
+            if (recorder) recorder->game_over(game_result, winner());
+            sink->game_over(game_result, winner());
             return;
         }
     }
-    std::cout << "Reached max rounds with multiple robots alive.\n";
+    game_result = GameResult::round_limit;
+    if (recorder) recorder->game_over(game_result, nullptr);
+    sink->game_over(game_result, nullptr);
 }
 
 void Arena::play_round(int round) {
-    print_board(round);
+    current_round = round;
+    std::uint64_t start = timings ? PhaseTimes::now() : 0;
+    if (recorder) recorder->round_start(*this, round);
+    sink->round_start(*this, round);
+    if (timings) timings->lap(-1, Phase::output, start);
+
+    if (simultaneous) return play_simultaneous_round();
 
     for (std::size_t i = 0; i < robots.size(); ++i) {
         RobotInfo& info = robots[i];
 
-        if (!info.alive || info.robot->get_health() <= 0) {
-            info.alive = false;
+        if (!info.alive) continue;
+        if (info.robot->get_health() <= 0) {
+            mark_dead(info);
             continue;
         }
 
@@ -301,125 +547,277 @@ void Arena::play_round(int round) {
     }
 }
 
-void Arena::handle_robot_turn(RobotInfo& info) {
-    std::cout << info.robot->m_name << " " << info.symbol
-              << " begins turn.\n";
+// An isolated robot's failures show up on the robot itself.
+static bool failed(const RobotInfo& info) {
+    return info.isolated && info.isolated->failure() != RobotFailure::none;
+}
 
-    int radar_dir = 0;
-    info.robot->get_radar_direction(radar_dir);
+// The robot's radar direction, asked directly or through `dog` (nullptr: no
+// call budget). False if the robot is out.
+template <typename Lap>
+bool Arena::choose_radar(RobotInfo& info, const Watchdog* dog, int& radar_dir, Lap&& lap) {
+    radar_dir = 0;
+    if (!dog || info.isolated) {
+        info.robot->get_radar_direction(radar_dir);
+        if (failed(info)) return false;
+    } else if (!dog->get_radar_direction(*info.robot, radar_dir)) {
+        return false;
+    }
+    lap(Phase::get_radar_direction);
 
     if (radar_dir < 0 || radar_dir > 8) radar_dir = 0;
+    return true;
+}
 
-    std::vector<RadarObj> radar_results;
-    do_radar_scan(info, radar_dir, radar_results);
-
-    info.robot->process_radar_results(radar_results);
+// The rest of the robot's decisions, given its radar results. False if the
+// robot is out; `failed_call` then says in which call. Touches nothing but
+// the robot and `action`, so robots can decide side by side. record(phase,
+// ns) takes phases timed somewhere else.
+template <typename Lap, typename Record>
+bool Arena::decide_action(RobotInfo& info, const Watchdog* dog, const std::vector<RadarObj>& results,
+                          TurnAction& action, RobotCall& failed_call, Lap&& lap, Record&& record) {
+    action = TurnAction();
+    // A TurnRobot decides the rest of its turn in one call.
+    if (info.turns) {
+        failed_call = RobotCall::take_turn;
+        if (!dog || info.isolated) {
+            action = info.turns->take_turn(results);
+            if (failed(info)) return false;
+        } else if (!dog->take_turn(*info.turns, results, action)) {
+            return false;
+        }
+        lap(Phase::take_turn);
+        if (info.isolated) {
+            const std::array<std::uint64_t, 3>& ns = info.isolated->turn_call_ns();
+            if (ns[0]) record(Phase::process_radar_results, ns[0]);
+            if (ns[1]) record(Phase::get_shot_location, ns[1]);
+            if (ns[2]) record(Phase::get_move_direction, ns[2]);
+        }
+        return true;
+    }
 
-    int shot_row = 0;
-    int shot_col = 0;
-    bool wants_to_shoot = info.robot->get_shot_location(shot_row, shot_col);
+    failed_call = RobotCall::process_radar_results;
+    if (!dog || info.isolated) {
+        info.robot->process_radar_results(results);
+        if (failed(info)) return false;
+    } else if (!dog->process_radar_results(*info.robot, results)) {
+        return false;
+    }
+    lap(Phase::process_radar_results);
+
+    failed_call = RobotCall::get_shot_location;
+    if (!dog || info.isolated) {
+        action.shoots = info.robot->get_shot_location(action.shot_row, action.shot_col);
+        if (failed(info)) return false;
+    } else if (!dog->get_shot_location(*info.robot, action.shot_row, action.shot_col,
+                                       action.shoots)) {
+        return false;
+    }
+    lap(Phase::get_shot_location);
+    if (action.shoots) return true;
+
+    failed_call = RobotCall::get_move_direction;
+    if (!dog || info.isolated) {
+        info.robot->get_move_direction(action.move_direction, action.move_distance);
+        if (failed(info)) return false;
+    } else if (!dog->get_move_direction(*info.robot, action.move_direction,
+                                        action.move_distance)) {
+        return false;
+    }
+    lap(Phase::get_move_direction);
+    return true;
+}
 
-    if (wants_to_shoot) {
-        handle_shot(info, shot_row, shot_col);
+// Carries out what the robot decided.
+template <typename Lap>
+void Arena::act(RobotInfo& info, const TurnAction& action, Lap&& lap) {
+    if (action.shoots) {
+        handle_shot(info, action.shot_row, action.shot_col);
+        lap(Phase::shot);
     } else {
-        int move_dir = 0;
-        int move_dist = 0;
-        info.robot->get_move_direction(move_dir, move_dist);
-        handle_movement(info, move_dir, move_dist);
+        handle_movement(info, action.move_direction, action.move_distance);
+        lap(Phase::movement);
     }
 
     update_board();
+    lap(Phase::board_update);
 }
 
-void Arena::do_radar_scan(RobotInfo& info,
-                          int radar_dir,
-                          std::vector<RadarObj>& radar_results) {
-    radar_results.clear();
-
-    int r = info.row;
-    int c = info.col;
-
-    if (radar_dir == 0) {
-        for (int dr = -1; dr <= 1; ++dr) {
-            for (int dc = -1; dc <= 1; ++dc) {
-                int rr = r + dr;
-                int cc = c + dc;
-                if (dr == 0 && dc == 0) continue;
-                if (!in_bounds(rr, cc)) continue;
-
-                char t = get_cell_type(rr, cc);
-                if (t != '.' ) {
-                    radar_results.push_back(RadarObj(t, rr, cc));
-                }
+void Arena::handle_robot_turn(RobotInfo& info) {
+    // With timing on, each lap() closes one phase and starts the next.
+    PhaseTimes* timer = timings.get();
+    int index = static_cast<int>(&info - robots.data());
+    std::uint64_t mark = timer ? PhaseTimes::now() : 0;
+    auto lap = [&](Phase phase) {
+        if (timer) mark = timer->lap(index, phase, mark);
+    };
+    auto record = [&](Phase phase, std::uint64_t ns) {
+        if (timer) timer->record(index, phase, ns);
+    };
+
+    sink->turn_start(info);
+    lap(Phase::output);
+
+    int radar_dir;
+    if (!choose_radar(info, watchdog.get(), radar_dir, lap)) {
+        return disqualify(info, RobotCall::get_radar_direction);
+    }
+
+    do_radar_scan(info, radar_dir, radar_results);
+    lap(Phase::radar_scan);
+
+    if (recorder) recorder->radar(info, radar_dir, radar_results.size());
+    sink->radar(info, radar_dir, radar_results);
+    lap(Phase::output);
+
+    TurnAction action;
+    RobotCall failed_call;
+    if (!decide_action(info, watchdog.get(), radar_results, action, failed_call, lap, record)) {
+        return disqualify(info, failed_call);
+    }
+
+    act(info, action, lap);
+}
+
+// Every living robot picks its radar direction, is scanned and decides what
+// to do, all against the board as the round started and side by side on the
+// turn pool. Then the actions are carried out one robot at a time in robot
+// order, with every event and damage roll on this thread, so the game
+// doesn't depend on which robot finished deciding first.
+// True for a robot from a library running in the arena's own process.
+static bool shares_globals(const RobotInfo& info) {
+    return info.library >= 0 && !info.isolated;
+}
+
+void Arena::play_simultaneous_round() {
+    for (RobotInfo& info : robots) {
+        if (info.alive && info.robot->get_health() <= 0) mark_dead(info);
+    }
+    decisions.resize(robots.size());
+
+    TaskScheduler* pool = shared_pool ? shared_pool : turn_pool.get();
+    if (pool) {
+        // Robots loaded in-process from libraries may share globals (the
+        // shipped ones all call std::rand), so they decide here one after
+        // another in robot order while the rest run on the pool. An
+        // isolated robot has its process, and its std::rand, to itself.
+        TaskGroup round;
+        for (std::size_t i = 0; i < robots.size(); ++i) {
+            if (robots[i].alive && !shares_globals(robots[i])) {
+                pool->submit(round, [this, i] { decide(i); });
             }
         }
+        for (std::size_t i = 0; i < robots.size(); ++i) {
+            if (robots[i].alive && shares_globals(robots[i])) decide(i);
+        }
+        pool->wait(round);
     } else {
-        int dr = directions[radar_dir].first;
-        int dc = directions[radar_dir].second;
-
-        int step = 1;
-        while (true) {
-            int base_r = r + dr * step;
-            int base_c = c + dc * step;
-            if (!in_bounds(base_r, base_c)) break;
-
-            if (dr != 0 && dc == 0) {
-                for (int offset = -1; offset <= 1; ++offset) {
-                    int rr = base_r;
-                    int cc = base_c + offset;
-                    if (!in_bounds(rr, cc)) continue;
-                    char t = get_cell_type(rr, cc);
-                    if (t != '.' && !(rr == r && cc == c)) {
-                        radar_results.push_back(RadarObj(t, rr, cc));
-                    }
-                }
-            } else if (dr == 0 && dc != 0) {
-                for (int offset = -1; offset <= 1; ++offset) {
-                    int rr = base_r + offset;
-                    int cc = base_c;
-                    if (!in_bounds(rr, cc)) continue;
-                    char t = get_cell_type(rr, cc);
-                    if (t != '.' && !(rr == r && cc == c)) {
-                        radar_results.push_back(RadarObj(t, rr, cc));
-                    }
-                }
-            } else {
-                int rr = base_r;
-                int cc = base_c;
-                if (in_bounds(rr, cc)) {
-                    char t = get_cell_type(rr, cc);
-                    if (t != '.' && !(rr == r && cc == c)) {
-                        radar_results.push_back(RadarObj(t, rr, cc));
-                    }
-                }
-            }
+        for (std::size_t i = 0; i < robots.size(); ++i) {
+            if (robots[i].alive) decide(i);
+        }
+    }
+
+    for (std::size_t i = 0; i < robots.size(); ++i) {
+        RobotInfo& info = robots[i];
+
+        // Destroyed earlier this round: its decision is void.
+        if (!info.alive) continue;
+        if (info.robot->get_health() <= 0) {
+            mark_dead(info);
+            continue;
+        }
 
-            step++;
+        carry_out(info, decisions[i]);
+
+        if (watch_live) {
+            std::cout << "Press ENTER for next robot...\n";
+            std::cin.get();
         }
     }
+}
 
-    if (radar_results.empty()) {
-        std::cout << "  radar found nothing.\n";
-    } else {
-        std::cout << "  radar found " << radar_results.size() << " objects.\n";
+// Runs on a turn pool thread: reads the board, writes only the robot and
+// its decision. Phase times wait in the decision for carry_out to record.
+void Arena::decide(std::size_t index) {
+    RobotInfo& info = robots[index];
+    Decision& decision = decisions[index];
+    const Watchdog* dog = watchdog.get();
+
+    decision.lap_count = 0;
+    std::uint64_t mark = timings ? PhaseTimes::now() : 0;
+    auto lap = [&](Phase phase) {
+        if (!timings) return;
+        std::uint64_t now = PhaseTimes::now();
+        decision.laps[decision.lap_count++] = { phase, now - mark };
+        mark = now;
+    };
+    auto record = [&](Phase phase, std::uint64_t ns) {
+        if (timings) decision.laps[decision.lap_count++] = { phase, ns };
+    };
+
+    decision.radar.clear();
+    decision.failed_call = RobotCall::get_radar_direction;
+    decision.out = !choose_radar(info, dog, decision.radar_dir, lap);
+    if (decision.out) return;
+
+    do_radar_scan(info, decision.radar_dir, decision.radar);
+    lap(Phase::radar_scan);
+
+    decision.out = !decide_action(info, dog, decision.radar, decision.action,
+                                  decision.failed_call, lap, record);
+}
+
+// The events handle_robot_turn would give, for a turn decided earlier.
+void Arena::carry_out(RobotInfo& info, const Decision& decision) {
+    PhaseTimes* timer = timings.get();
+    int index = static_cast<int>(&info - robots.data());
+    for (int i = 0; timer && i < decision.lap_count; ++i) {
+        timer->record(index, decision.laps[i].first, decision.laps[i].second);
     }
+    std::uint64_t mark = timer ? PhaseTimes::now() : 0;
+    auto lap = [&](Phase phase) {
+        if (timer) mark = timer->lap(index, phase, mark);
+    };
+
+    sink->turn_start(info);
+    if (decision.out && decision.failed_call == RobotCall::get_radar_direction) {
+        return disqualify(info, decision.failed_call);
+    }
+    if (recorder) recorder->radar(info, decision.radar_dir, decision.radar.size());
+    sink->radar(info, decision.radar_dir, decision.radar);
+    lap(Phase::output);
+    if (decision.out) return disqualify(info, decision.failed_call);
+
+    act(info, decision.action, lap);
+}
+
+void Arena::do_radar_scan(RobotInfo& info,
+                          int radar_dir,
+                          std::vector<RadarObj>& results) {
+    results.clear();
+
+    radar.scan(info.row, info.col, radar_dir, [&](int rr, int cc) {
+        results.push_back(RadarObj(get_cell_type(rr, cc), rr, cc));
+    });
 }
 
 void Arena::handle_movement(RobotInfo& mover, int move_dir, int move_dist) {
     int max_speed = mover.robot->get_move_speed();
     if (max_speed <= 0) {
-        std::cout << "  " << mover.robot->m_name
-                  << " is stuck and cannot move.\n";
+        if (recorder) recorder->move_rejected(mover, MoveProblem::stuck);
+        sink->move_rejected(mover, MoveProblem::stuck);
         return;
     }
 
     if (move_dir < 1 || move_dir > 8) {
-        std::cout << "  invalid move direction.\n";
+        if (recorder) recorder->move_rejected(mover, MoveProblem::invalid_direction);
+        sink->move_rejected(mover, MoveProblem::invalid_direction);
         return;
     }
 
     if (move_dist <= 0) {
-        std::cout << "  chose not to move.\n";
+        if (recorder) recorder->move_rejected(mover, MoveProblem::no_move);
+        sink->move_rejected(mover, MoveProblem::no_move);
         return;
     }
 
@@ -440,64 +838,38 @@ void Arena::handle_movement(RobotInfo& mover, int move_dir, int move_dist) {
     if (col_2 < 0) col_2 = 0;
     if (col_2 >= cols) col_2 = cols - 1;
 
-    double delta_r = row_2 - row_1;
-    double delta_c = col_2 - col_1;
-
-    int steps = std::max(std::abs((int)delta_r), std::abs((int)delta_c));
-    if (steps == 0) {
-        std::cout << "  " << mover.robot->m_name
-                  << " ends move at (" << mover.row << "," << mover.col << ").\n";
+    GridLine line(row_1, col_1, row_2, col_2);
+    if (line.length() == 0) {
+        if (recorder) recorder->move_end(mover);
+        sink->move_end(mover);
         return;
     }
 
-    double row_increment = delta_r / steps;
-    double col_increment = delta_c / steps;
-
-    double row_counter = row_1;
-    double col_counter = col_1;
-
-    int last_r = row_1;
-    int last_c = col_1;
-
-    for (int i = 0; i < steps; ++i) {
-        row_counter += row_increment;
-        col_counter += col_increment;
-
-        int r = std::round(row_counter);
-        int c = std::round(col_counter);
-
-        if (r == last_r && c == last_c) {
-            continue;
-        }
-        last_r = r;
-        last_c = c;
+    for (int i = 0; i < line.length(); ++i) {
+        line.advance();
+        int r = line.row();
+        int c = line.col();
 
         if (!in_bounds(r, c)) {
             break;
         }
 
-        char cell = get_cell_type(r, c);
-
-        if (cell == 'R' || cell == 'X' || cell == 'M') {
+        if (planes.test_any(CellPlanes::blocking, r, c)) {
             break;
         }
 
-        if (board[r][c] == 'P') {
-            mover.row = r;
-            mover.col = c;
-            mover.robot->move_to(r, c);
+        if (planes.test(CellPlanes::pits, r, c)) {
+            move_robot(mover, r, c);
             mover.robot->disable_movement();
-            std::cout << "  " << mover.robot->m_name
-                      << " fell into a pit at (" << r << "," << c << ").\n";
+            if (recorder) recorder->move_hazard(mover, 'P', r, c);
+            sink->move_hazard(mover, 'P', r, c);
             return;
         }
 
-        if (board[r][c] == 'F') {
-            mover.row = r;
-            mover.col = c;
-            mover.robot->move_to(r, c);
-            std::cout << "  " << mover.robot->m_name
-                      << " moves through flames at (" << r << "," << c << ").\n";
+        if (planes.test(CellPlanes::flames, r, c)) {
+            move_robot(mover, r, c);
+            if (recorder) recorder->move_hazard(mover, 'F', r, c);
+            sink->move_hazard(mover, 'F', r, c);
             apply_damage(mover, 30, 50);
             if (!mover.alive) {
                 return;
@@ -505,51 +877,49 @@ void Arena::handle_movement(RobotInfo& mover, int move_dir, int move_dist) {
             continue;
         }
 
-        mover.row = r;
-        mover.col = c;
-        mover.robot->move_to(r, c);
+        move_robot(mover, r, c);
     }
 
-    std::cout << "  " << mover.robot->m_name << " ends move at ("
-              << mover.row << "," << mover.col << ").\n";
+    if (recorder) recorder->move_end(mover);
+    sink->move_end(mover);
 }
 
 void Arena::handle_shot(RobotInfo& shooter, int shot_row, int shot_col) {
     if (!in_bounds(shot_row, shot_col)) {
-        std::cout << "  Shot location is out of bounds; ignoring.\n";
+        if (recorder) recorder->shot_rejected(shooter, ShotProblem::out_of_bounds);
+        sink->shot_rejected(shooter, ShotProblem::out_of_bounds);
         return;
     }
 
     WeaponType w = shooter.robot->get_weapon();
 
-    std::cout << "  " << shooter.robot->m_name << " fires ";
+    if (recorder) recorder->shot(shooter, w, shot_row, shot_col);
+    sink->shot(shooter, w, shot_row, shot_col);
 
     if (w == railgun) {
-        std::cout << "railgun.\n";
         railgun_line(shooter, shot_row, shot_col);
     } else if (w == flamethrower) {
-        std::cout << "flamethrower.\n";
         flamethrower_cone(shooter, shot_row, shot_col);
     } else if (w == grenade) {
-        std::cout << "grenade.\n";
         if (shooter.robot->get_grenades() <= 0) {
-            std::cout << "  But has no grenades left!\n";
+            if (recorder) recorder->shot_rejected(shooter, ShotProblem::no_grenades);
+            sink->shot_rejected(shooter, ShotProblem::no_grenades);
             return;
         }
         shooter.robot->decrement_grenades();
 
+        // Live robots in the 3x3 box, row by row, found a word at a time.
+        const unsigned live = CellPlanes::bit(CellPlanes::robots);
         for (int r = shot_row - 1; r <= shot_row + 1; ++r) {
-            for (int c = shot_col - 1; c <= shot_col + 1; ++c) {
-                if (!in_bounds(r, c)) continue;
-                int idx = find_robot_at(r, c);
-                if (idx != -1 && robots[idx].alive &&
-                    robots[idx].robot != shooter.robot) {
-                    apply_damage(robots[idx], 10, 40);
+            for (int c = planes.next_in_row(live, r, shot_col - 1, shot_col + 1); c != -1;
+                 c = planes.next_in_row(live, r, c + 1, shot_col + 1)) {
+                RobotInfo& target = robots[occupant(r, c)];
+                if (target.robot != shooter.robot) {
+                    apply_damage(target, 10, 40);
                 }
             }
         }
     } else if (w == hammer) {
-        std::cout << "hammer.\n";
         if (std::abs(shot_row - shooter.row) <= 1 &&
             std::abs(shot_col - shooter.col) <= 1) {
             int idx = find_robot_at(shot_row, shot_col);
@@ -557,111 +927,104 @@ void Arena::handle_shot(RobotInfo& shooter, int shot_row, int shot_col) {
                 robots[idx].robot != shooter.robot) {
                 apply_damage(robots[idx], 50, 60);
             } else {
-                std::cout << "  Nothing there to hammer.\n";
+                if (recorder) recorder->shot_rejected(shooter, ShotProblem::nothing_to_hammer);
+                sink->shot_rejected(shooter, ShotProblem::nothing_to_hammer);
             }
         } else {
-            std::cout << "  Hammer target not adjacent.\n";
+            if (recorder) recorder->shot_rejected(shooter, ShotProblem::not_adjacent);
+            sink->shot_rejected(shooter, ShotProblem::not_adjacent);
         }
     }
 }
 
+// Calls visit(row, col) for the first max_cells cells of the line from the
+// shooter through the target, stopping at the edge of the arena. The cells
+// are GridLine's; arenas the footprint cache covers look them up instead of
+// walking them.
+template <typename Visit>
+void Arena::walk_shot_path(const RobotInfo& shooter, int target_row, int target_col,
+                           int max_cells, Visit&& visit) {
+    int span = std::max(rows, cols);
+    FootprintCache& cache = footprint_cache();
+    if (cache.covers(span)) {
+        int dr = target_row - shooter.row;
+        int dc = target_col - shooter.col;
+        std::span<const PathCell> path = cache.path(dr, dc, span);
+        // Only read at halves; stepped exactly as GridLine steps it.
+        int steps = std::max(std::abs(dr), std::abs(dc));
+        double row_increment = static_cast<double>(dr) / steps;
+        double col_increment = static_cast<double>(dc) / steps;
+        double stepped_row = shooter.row;
+        double stepped_col = shooter.col;
+        for (int i = 0; i < max_cells; ++i) {
+            stepped_row += row_increment;
+            stepped_col += col_increment;
+            int rr = path[i].row(shooter.row, stepped_row);
+            int cc = path[i].col(shooter.col, stepped_col);
+            if (!in_bounds(rr, cc)) return;
+            visit(rr, cc);
+        }
+        return;
+    }
+
+    GridLine line(shooter.row, shooter.col, target_row, target_col);
+    for (int i = 0; i < max_cells; ++i) {
+        line.advance();
+        if (!in_bounds(line.row(), line.col())) return;
+        visit(line.row(), line.col());
+    }
+}
+
 void Arena::railgun_line(RobotInfo& shooter,
                          int target_row,
                          int target_col) {
-    int start_r = shooter.row;
-    int start_c = shooter.col;
-
-    double delta_r = static_cast<double>(target_row - start_r);
-    double delta_c = static_cast<double>(target_col - start_c);
-
-    int steps = std::max(std::abs(static_cast<int>(delta_r)),
-                         std::abs(static_cast<int>(delta_c)));
-    if (steps == 0) return;
-
-    double row_inc = delta_r / steps;
-    double col_inc = delta_c / steps;
-
-    double row = start_r + row_inc;
-    double col = start_c + col_inc;
-
-    int last_r = -1;
-    int last_c = -1;
-
-    while (true) {
-        int rr = static_cast<int>(std::round(row));
-        int cc = static_cast<int>(std::round(col));
-
-        if (!in_bounds(rr, cc)) break;
-
-        if (rr != last_r || cc != last_c) {
-            int idx = find_robot_at(rr, cc);
-            if (idx != -1 &&
-                robots[idx].alive &&
-                robots[idx].robot != shooter.robot) {
-                apply_damage(robots[idx], 10, 20); 
+    if (target_row == shooter.row && target_col == shooter.col) return;
+
+    // The shot carries on past the target to the edge of the arena, which
+    // is never more than max(rows, cols) cells away.
+    walk_shot_path(shooter, target_row, target_col, std::max(rows, cols), [&](int rr, int cc) {
+        if (planes.test(CellPlanes::robots, rr, cc)) {
+            RobotInfo& target = robots[occupant(rr, cc)];
+            if (target.robot != shooter.robot) {
+                apply_damage(target, 10, 20);
             }
-            last_r = rr;
-            last_c = cc;
         }
-
-        row += row_inc;
-        col += col_inc;
-    }
+    });
 }
 
 void Arena::flamethrower_cone(RobotInfo& shooter,
                               int target_row,
                               int target_col) {
-    int start_r = shooter.row;
-    int start_c = shooter.col;
-
-    double delta_r = static_cast<double>(target_row - start_r);
-    double delta_c = static_cast<double>(target_col - start_c);
-
-    int steps = std::max(std::abs(static_cast<int>(delta_r)),
-                         std::abs(static_cast<int>(delta_c)));
-    if (steps == 0) return;
+    int delta_r = target_row - shooter.row;
+    int delta_c = target_col - shooter.col;
 
-    double row_inc = delta_r / steps;
-    double col_inc = delta_c / steps;
+    if (delta_r == 0 && delta_c == 0) return;
 
-    double row = start_r;
-    double col = start_c;
-
-    for (int i = 0; i < 4; ++i) { 
-        row += row_inc;
-        col += col_inc;
-
-        int rr = static_cast<int>(std::round(row));
-        int cc = static_cast<int>(std::round(col));
-        if (!in_bounds(rr, cc)) break;
+    auto burn = [&](int r2, int c2) {
+        RobotInfo& target = robots[occupant(r2, c2)];
+        if (target.robot != shooter.robot) {
+            apply_damage(target, 30, 50);
+        }
+    };
 
+    // The cone is centred on the first four cells of the railgun's path.
+    walk_shot_path(shooter, target_row, target_col, 4, [&](int rr, int cc) {
+        const unsigned live = CellPlanes::bit(CellPlanes::robots);
         if (std::abs(delta_r) >= std::abs(delta_c)) {
-            for (int offset = -1; offset <= 1; ++offset) {
-                int r2 = rr;
-                int c2 = cc + offset;
-                if (!in_bounds(r2, c2)) continue;
-                int idx = find_robot_at(r2, c2);
-                if (idx != -1 &&
-                    robots[idx].alive &&
-                    robots[idx].robot != shooter.robot) {
-                    apply_damage(robots[idx], 30, 50);
-                }
+            // The cone's cross-section lies along a row: one word search.
+            for (int c2 = planes.next_in_row(live, rr, cc - 1, cc + 1); c2 != -1;
+                 c2 = planes.next_in_row(live, rr, c2 + 1, cc + 1)) {
+                burn(rr, c2);
             }
         } else {
             for (int offset = -1; offset <= 1; ++offset) {
                 int r2 = rr + offset;
-                int c2 = cc;
-                if (!in_bounds(r2, c2)) continue;
-                int idx = find_robot_at(r2, c2);
-                if (idx != -1 &&
-                    robots[idx].alive &&
-                    robots[idx].robot != shooter.robot) {
-                    apply_damage(robots[idx], 30, 50);
+                if (in_bounds(r2, cc) && planes.test(CellPlanes::robots, r2, cc)) {
+                    burn(r2, cc);
                 }
             }
         }
-    }
+    });
 }
 
 void Arena::apply_damage(RobotInfo& target,
@@ -671,7 +1034,7 @@ void Arena::apply_damage(RobotInfo& target,
 
     int base = min_dmg;
     if (max_dmg > min_dmg) {
-        base += std::rand() % (max_dmg - min_dmg + 1);
+        base = random_int(min_dmg, max_dmg);
     }
 
     int armor = target.robot->get_armor();
@@ -686,13 +1049,13 @@ void Arena::apply_damage(RobotInfo& target,
     target.robot->reduce_armor(1);
     int after = target.robot->take_damage(final_dmg);
 
-    std::cout << "  " << target.robot->m_name
-              << " takes " << final_dmg
-              << " damage (health " << before
-              << " -> " << after << ").\n";
+    if (recorder) recorder->damage(target, final_dmg, after);
+    sink->damage(target, final_dmg, before, after);
 
     if (after <= 0) {
-        target.alive = false;
-        std::cout << "  " << target.robot->m_name << " is destroyed!\n";
+        target.died_in_round = current_round;
+        mark_dead(target);
+        if (recorder) recorder->death(target);
+        sink->death(target);
     }
 }
\ No newline at end of file
@@ -1,11 +1,32 @@
 #pragma once
 
+#include <chrono>
 #include <vector>
 #include <string>
 #include <utility>
+#include <memory>
+#include <span>
+#include <cstdint>
 
 #include "RobotBase.h"
 #include "RadarObj.h"
+#include "Grid.h"
+#include "MapFile.h"
+#include "Rng.h"
+#include "RadarEngine.h"
+#include "CellPlanes.h"
+#include "CellShuffle.h"
+#include "GridLine.h"
+#include "FootprintCache.h"
+#include "EventSink.h"
+#include "PhaseTimes.h"
+#include "Watchdog.h"
+#include "TurnRobot.h"
+#include "TaskScheduler.h"
+#include "RobotLibrary.h"
+
+class IsolatedRobot;
+class ReplayRecorder;
 
 struct RobotInfo {
     RobotBase* robot;   
@@ -13,26 +34,172 @@ struct RobotInfo {
     int row;
     int col;
     bool alive;
+    int died_in_round;  // -1 while alive
+    int library;        // index into the libraries given to spawn_robots, -1 if added directly
+    int overruns;       // callbacks that ran past the call budget
+    int crashes;        // robot processes that died (isolation only)
     void* handle;       
+    IsolatedRobot* isolated;   // the same robot, if it runs in a child process
+    TurnRobot* turns;          // the same robot, if it takes whole turns (TurnRobot.h)
 
     RobotInfo()
-        : robot(nullptr), symbol('!'), row(0), col(0), alive(true), handle(nullptr) {}
+        : robot(nullptr), symbol('!'), row(0), col(0), alive(true),
+          died_in_round(-1), library(-1), overruns(0), crashes(0), handle(nullptr),
+          isolated(nullptr), turns(nullptr) {}
+};
+
+// The game settings from config.txt.
+// Format (one line): rows cols num_mounds num_pits num_flames max_rounds watch_live
+// For many settings at once, see the sweep files in Sweep.h.
+struct ArenaConfig {
+    int rows = 20;
+    int cols = 20;
+    int num_mounds = 10;
+    int num_pits = 5;
+    int num_flames = 5;
+    int max_rounds = 99;
+    bool watch_live = false;
 };
 
+bool read_config(const std::string& filename, ArenaConfig& config);
+
 class Arena {
+    friend class TestArena;
+    friend class BenchArena;
+    friend class ReplayPlayer;
+
 public:
     Arena();
+    Arena(int rows_in, int cols_in);
     bool load_config(const std::string& filename);
-    void load_obstacles();
-    void load_robots();
+    void configure(const ArenaConfig& config);
+    // The same seed gives the same obstacles, placement and damage rolls.
+    void set_seed(std::uint64_t seed);
+    std::uint64_t seed() const { return game_seed; }
+    // Places num_mounds, num_pits and num_flames obstacles on free cells.
+    // If they can't all fit, says so on std::cerr and places none.
+    bool load_obstacles();
+    // Play on a map file (MapFile.h) instead: the board takes the map's
+    // size and obstacles, and uses the mapped file as its storage, so even
+    // a huge map is never parsed or copied; only its checksum is worked
+    // out. Call after configure / load_config, which start a fresh board.
+    // Reports problems on std::cerr and returns false.
+    bool load_map(const std::string& path);
+    // Saves the board's obstacles (not its robots) as a map file.
+    bool save_map(const std::string& path) const;
+    bool load_robots(int build_jobs = 0);
+    // One robot per library, each on a free cell. If there are more
+    // libraries than free cells, says so on std::cerr and places none.
+    bool spawn_robots(const std::vector<RobotLibrary>& libraries);
+    // Cells with no obstacle and no robot, dead or alive.
+    int free_cells() const;
+    // Whether robot_count more robots fit; if not, says so on std::cerr.
+    bool has_room_for(std::size_t robot_count) const;
     void run();
+    void add_robot(RobotBase* robot, int r, int c, void* handle = nullptr);
 	void set_watch_live(bool v) { watch_live = v; }
 	void set_fast_mode(bool v) { fast_mode = v; }
 
+    // nullptr silences the arena completely (headless runs).
+    void set_event_sink(EventSink* s);
+    // Records the game next to whatever the sink does (nullptr: stop). The
+    // arena calls it directly, so recording costs no virtual calls.
+    void set_replay_recorder(ReplayRecorder* r) { recorder = r; }
+
+    // Time every phase of every turn (off by default; when off, each phase
+    // costs one untaken branch). Turning it on starts from zero. An isolated
+    // robot always takes whole turns, and take_turn is timed as the round
+    // trip to its process. For a robot without a take_turn of its own, the
+    // three calls it stands for are timed in that process as well and show
+    // up under their own phases, inside the take_turn time.
+    void set_phase_timing(bool on);
+    const PhaseTimes* phase_times() const { return timings.get(); }
+
+    // Give every robot callback at most `budget` (0: no limit, the default);
+    // a robot whose call overruns is out of the game. With a budget,
+    // spawn_robots runs every robot isolated (see set_isolation), where a
+    // call that never returns is killed. A robot added with add_robot is
+    // timed in-process: it's caught once its late call returns, and one
+    // that never returns hangs the game.
+    void set_call_budget(std::chrono::microseconds budget);
+
+    // Run each robot spawn_robots makes in a child process of its own (off by
+    // default), so a robot that crashes is out of the game instead of taking
+    // the arena down. Calls go through shared memory, a few microseconds
+    // each; the call budget then applies to the child, which is killed when
+    // it overruns. Always on when there is a call budget. Set before
+    // spawn_robots.
+    void set_isolation(bool on);
+
+    // Simultaneous turns (off by default). Each round every living robot
+    // picks its radar direction, is scanned and decides what to do against
+    // the board as the round started, all at once on `threads` threads (0:
+    // one per core). The actions are then carried out one robot at a time
+    // in robot order: a robot can be shot before its own action comes up
+    // (and then does nothing), and shoots where its target was. Robots from
+    // libraries that aren't isolated decide on the game thread in robot
+    // order, since they may share globals such as std::rand; robots added
+    // directly must keep to themselves. Then the same seed gives the same
+    // game whatever the thread count.
+    void set_simultaneous(bool on, unsigned int threads = 0);
+    // Decide simultaneous turns on a scheduler shared with other work (a
+    // tournament's) rather than the arena's own threads; nullptr goes back
+    // to those. It must outlive the games played on it.
+    void set_scheduler(TaskScheduler* scheduler) { shared_pool = scheduler; }
+
+    void print_board(int round) const;
+    // The text print_board shows: the grid, then every robot's stats.
+    std::string board_frame(int round) const;
+
+    GameResult result() const { return game_result; }
+    const RobotInfo* winner() const;
+    int rounds_played() const { return rounds_done; }
+    const std::vector<RobotInfo>& robot_infos() const { return robots; }
+    int board_rows() const { return rows; }
+    int board_cols() const { return cols; }
+    int round_limit() const { return max_rounds; }
+    // The obstacle at a cell ('M', 'P', 'F'), or '.'; robots are not included.
+    char obstacle_at(int r, int c) const { return board(r, c); }
+
+    // Shot paths for the calling thread. Every arena on a thread shares it,
+    // so a tournament worker keeps its paths from one game to the next.
+    static FootprintCache& footprint_cache();
+
 private:
 	bool watch_live = false;
 	bool fast_mode = false;
 
+    EventSink* sink;
+    ReplayRecorder* recorder = nullptr;
+    std::unique_ptr<PhaseTimes> timings;   // nullptr: not timing
+    std::unique_ptr<Watchdog> watchdog;    // nullptr: no call budget
+    std::chrono::microseconds call_budget{0};
+    bool isolate = false;
+
+    // One robot's turn as decided in a simultaneous round.
+    struct Decision {
+        int radar_dir = 0;
+        std::vector<RadarObj> radar;
+        TurnAction action;
+        bool out = false;                 // a call failed; the robot is out
+        RobotCall failed_call = RobotCall::get_radar_direction;
+        std::pair<Phase, std::uint64_t> laps[8];   // with timing on, recorded by carry_out
+        int lap_count = 0;
+    };
+
+    bool simultaneous = false;
+    std::unique_ptr<TaskScheduler> turn_pool;   // nullptr: decide on the game thread
+    TaskScheduler* shared_pool = nullptr;       // set_scheduler; wins over turn_pool
+    std::vector<Decision> decisions;         // per robot, reused round to round
+    GameResult game_result = GameResult::none;
+    int winner_index = -1;
+    int rounds_done = 0;
+    int current_round = 0;
+
+    // Each arena has its own generator so several can run side by side.
+    Rng rng;
+    std::uint64_t game_seed;
+
     int rows;
     int cols;
     int max_rounds;
@@ -41,26 +208,65 @@ private:
     int num_pits;
     int num_flames;
 
-    std::vector<std::vector<char>> board;  
+    std::unique_ptr<MapFile> map_file;   // behind board, radar and planes after load_map
+    Grid<char> board;  
+    // Index into robots plus one, 0 if no robot: a fresh grid is all zeros,
+    // which costs nothing until a robot lands on a page of it.
+    Grid<int> occupancy;
+    RadarEngine radar;    // which cells are non-empty, for radar scans
+    CellPlanes planes;    // one bitset per cell type, for weapon and movement checks
+    // The cells obstacles and robots are placed on: how many are free for
+    // the placements under way, and once the board is crowded, which.
+    int placement_free = 0;
+    CellShuffle placement;
+
+    // Reused by every turn; keeps its capacity so steady-state turns don't
+    // allocate.
+    std::vector<RadarObj> radar_results;
 
     std::vector<RobotInfo> robots;
+    std::vector<std::unique_ptr<RobotBase>> owned_robots;  // made by spawn_robots
+    int next_symbol_index = 0;
 
     void init_board();
-    void print_board(int round) const;
+    void clear_robots();
+    void start_placement(int free);
+    bool take_free_cell(int& r, int& c);
+    int random_int(int lo, int hi);
     void update_board();   
 
-    bool check_for_winner() const;
+    bool check_for_winner();
 
     void play_round(int round);
     void handle_robot_turn(RobotInfo& info);
+    void play_simultaneous_round();
+    void decide(std::size_t index);
+    void carry_out(RobotInfo& info, const Decision& decision);
+
+    template <typename Lap>
+    bool choose_radar(RobotInfo& info, const Watchdog* dog, int& radar_dir, Lap&& lap);
+    template <typename Lap, typename Record>
+    bool decide_action(RobotInfo& info, const Watchdog* dog, const std::vector<RadarObj>& results,
+                       TurnAction& action, RobotCall& failed_call, Lap&& lap, Record&& record);
+    template <typename Lap>
+    void act(RobotInfo& info, const TurnAction& action, Lap&& lap);
 
-    void do_radar_scan(RobotInfo& info, int radar_dir, std::vector<RadarObj>& radar_results);
+    void do_radar_scan(RobotInfo& info, int radar_dir, std::vector<RadarObj>& results);
     char get_cell_type(int r, int c) const; 
     int find_robot_at(int r, int c) const;  
+    // find_robot_at for a cell known to be on the board.
+    int occupant(int r, int c) const { return occupancy(r, c) - 1; }
     bool in_bounds(int r, int c) const;
+    void move_robot(RobotInfo& info, int r, int c);
+    void update_cell(int r, int c);
+    void mark_dead(RobotInfo& info);
+    void disqualify(RobotInfo& info, RobotCall call);
     void handle_movement(RobotInfo& mover, int move_dir, int move_dist);
     void handle_shot(RobotInfo& shooter, int shot_row, int shot_col);
     void apply_damage(RobotInfo& target, int min_dmg, int max_dmg);
     void railgun_line(RobotInfo& shooter, int target_row, int target_col);
     void flamethrower_cone(RobotInfo& shooter, int target_row, int target_col);
+    template <typename Visit>
+    void walk_shot_path(const RobotInfo& shooter, int target_row, int target_col,
+                        int max_cells, Visit&& visit);
 };
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Appends text to a file from a thread of its own.
+//
+// The caller fills a block in memory; a full block is handed to the writer
+// thread and the caller carries on with a fresh one, so it only waits for
+// the disk when max_waiting blocks are already queued for it. Blocks come
+// back to be reused once written.
+class BackgroundWriter {
+public:
+    static constexpr std::size_t block_size = 64 * 1024;
+    // Full blocks queued for the disk before the caller has to wait: a slow
+    // disk holds the game back instead of filling memory.
+    static constexpr std::size_t max_waiting = 16;
+    static constexpr std::size_t spare_blocks = 2;
+
+    BackgroundWriter() = default;
+    ~BackgroundWriter() { close(); }
+
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+    // Reports problems on std::cerr and returns false.
+    bool open(const std::string& path) {
+        close();
+        m_out.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_out) {
+            std::cerr << "Could not open " << path << " for writing.\n";
+            return false;
+        }
+        m_path = path;
+        m_failed = false;
+        m_stopping = false;
+        m_written = 0;
+        m_block.reserve(block_size + 1024);
+        // Blocks ready to be filled, their pages already touched, so the
+        // first few hand-overs don't stop the caller for page faults.
+        while (m_spare.size() < spare_blocks) m_spare.emplace_back(block_size + 1024, '\0');
+        m_thread = std::thread([this] { work(); });
+        return true;
+    }
+
+    bool is_open() const { return m_thread.joinable(); }
+
+    // The block being filled; call done_appending() after adding to it.
+    std::string& block() { return m_block; }
+
+    void done_appending() {
+        if (m_block.size() >= block_size) hand_over();
+    }
+
+    // For callers that fill a buffer of their own instead of block():
+    // queues the first `size` bytes of `buffer` and swaps in a written one
+    // at least as big, so nothing is copied. Its old contents are garbage.
+    void swap_out(std::string& buffer, std::size_t size) {
+        hand_over();   // anything appended to block() goes first
+        std::size_t capacity = buffer.size();
+        buffer.resize(size);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            wait_for_room(lock);
+            m_full.push_back(std::move(buffer));
+            buffer = take_spare();
+        }
+        m_wake.notify_one();
+        if (buffer.size() < capacity) buffer.resize(capacity);
+    }
+
+    // Writes everything still waiting and closes the file.
+    void close() {
+        if (!m_thread.joinable()) return;
+        hand_over();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        m_out.close();
+        if (m_failed || !m_out) std::cerr << "Writing " << m_path << " failed.\n";
+    }
+
+    // Bytes the writer thread has written so far.
+    std::uint64_t bytes_written() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_written;
+    }
+
+private:
+    std::ofstream m_out;
+    std::string m_path;
+    std::string m_block;                 // being filled by the caller
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;      // the writer thread: a block is waiting
+    std::condition_variable m_room;      // the caller: a block was taken
+    std::deque<std::string> m_full;      // waiting for the writer thread
+    std::vector<std::string> m_spare;    // written, ready to be filled again
+    std::uint64_t m_written = 0;
+    bool m_stopping = false;
+    bool m_failed = false;
+
+    void hand_over() {
+        if (m_block.empty()) return;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            wait_for_room(lock);
+            m_full.push_back(std::move(m_block));
+            m_block = take_spare();
+        }
+        m_block.clear();
+        m_block.reserve(block_size + 1024);
+        m_wake.notify_one();
+    }
+
+    void wait_for_room(std::unique_lock<std::mutex>& lock) {
+        m_room.wait(lock, [this] { return m_full.size() < max_waiting; });
+    }
+
+    // A written block, still holding its old bytes, or an empty one.
+    std::string take_spare() {
+        if (m_spare.empty()) return std::string();
+        std::string spare = std::move(m_spare.back());
+        m_spare.pop_back();
+        return spare;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this] { return m_stopping || !m_full.empty(); });
+            if (m_full.empty()) return;
+
+            std::string text = std::move(m_full.front());
+            m_full.pop_front();
+            lock.unlock();
+            m_room.notify_one();
+            m_out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            bool ok = static_cast<bool>(m_out);
+            std::size_t size = text.size();
+            lock.lock();
+
+            if (ok) m_written += size;
+            else    m_failed = true;
+            m_spare.push_back(std::move(text));
+        }
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "CellStore.h"
+
+// One bitset per kind of cell content, laid out row by row over the whole
+// arena. Queries that used to look at cells one at a time ("is anything in
+// this grenade box?", "is the next cell blocked?") become a few word-wide
+// ORs, ANDs and bit searches.
+//
+// Arena keeps these in step with board, occupancy and RobotInfo::alive; the
+// char grid stays the source of truth for printing.
+class CellPlanes {
+public:
+    enum Plane { mounds, pits, flames, robots, wrecks, plane_count };
+
+    // Several planes at once, e.g. bit(mounds) | bit(robots).
+    static constexpr unsigned bit(Plane p) { return 1u << p; }
+
+    // Everything: a cell set in none of these is empty.
+    static constexpr unsigned all = (1u << plane_count) - 1;
+
+    // Cells a moving robot can't enter.
+    static constexpr unsigned blocking = (1u << mounds) | (1u << robots) | (1u << wrecks);
+
+    // The obstacle planes come first, then the ones that change during a
+    // game.
+    static constexpr int obstacle_planes = robots;
+
+    CellPlanes() = default;
+    CellPlanes(const CellPlanes& other)
+        : m_rows(other.m_rows), m_cols(other.m_cols), m_row_words(other.m_row_words),
+          m_obstacles(other.m_obstacles), m_units(other.m_units) {
+        bind();
+    }
+    CellPlanes& operator=(const CellPlanes& other) {
+        if (this != &other) {
+            m_rows = other.m_rows;
+            m_cols = other.m_cols;
+            m_row_words = other.m_row_words;
+            m_obstacles = other.m_obstacles;
+            m_units = other.m_units;
+            bind();
+        }
+        return *this;
+    }
+
+    void reset(int rows, int cols) {
+        layout(rows, cols);
+        m_obstacles.zeroed(obstacle_planes * plane_words());
+        m_units.zeroed((plane_count - obstacle_planes) * plane_words());
+        bind();
+    }
+
+    // Use the obstacle planes at `words` as they are (obstacle_word_count
+    // words, laid out as obstacle_words() has them, e.g. saved in a map
+    // file); robots and wrecks start empty.
+    void view(int rows, int cols, std::uint64_t* words) {
+        layout(rows, cols);
+        m_obstacles.view(words, obstacle_planes * plane_words());
+        m_units.zeroed((plane_count - obstacle_planes) * plane_words());
+        bind();
+    }
+
+    const std::uint64_t* obstacle_words() const { return m_obstacles.data(); }
+    std::size_t obstacle_word_count() const { return m_obstacles.size(); }
+    static std::size_t obstacle_word_count(int rows, int cols) {
+        return obstacle_planes * static_cast<std::size_t>(rows) * ((cols + 63) / 64);
+    }
+
+    void set(Plane p, int r, int c, bool value) {
+        std::uint64_t& word = m_planes[p][line(r) + (c >> 6)];
+        std::uint64_t mask = std::uint64_t(1) << (c & 63);
+        if (value) word |= mask;
+        else       word &= ~mask;
+    }
+
+    bool test(Plane p, int r, int c) const {
+        return (m_planes[p][line(r) + (c >> 6)] >> (c & 63)) & 1;
+    }
+
+    // True if (r, c) is set in any of the given planes.
+    bool test_any(unsigned planes, int r, int c) const {
+        return (span(planes, line(r) + (c >> 6)) >> (c & 63)) & 1;
+    }
+
+    // Lowest column in [lo, hi] of row r that is set in any of the given
+    // planes, or -1. The range is clipped to the board.
+    int next_in_row(unsigned planes, int r, int lo, int hi) const {
+        if (r < 0 || r >= m_rows) return -1;
+        if (lo < 0) lo = 0;
+        if (hi >= m_cols) hi = m_cols - 1;
+        if (lo > hi) return -1;
+
+        std::size_t base = line(r);
+        int w = lo >> 6;
+        int last_w = hi >> 6;
+        std::uint64_t word = span(planes, base + w) & (~std::uint64_t(0) << (lo & 63));
+        while (true) {
+            if (word) {
+                int c = (w << 6) + std::countr_zero(word);
+                return c <= hi ? c : -1;
+            }
+            if (++w > last_w) return -1;
+            word = span(planes, base + w);
+        }
+    }
+
+    // Calls f(r, c) for every cell set in none of the given planes, row by
+    // row.
+    template <class F>
+    void for_each_clear(unsigned planes, F f) const {
+        std::uint64_t last_mask = (m_cols & 63) ? (std::uint64_t(1) << (m_cols & 63)) - 1
+                                                : ~std::uint64_t(0);
+        for (int r = 0; r < m_rows; ++r) {
+            std::size_t base = line(r);
+            for (int w = 0; w < m_row_words; ++w) {
+                std::uint64_t word = ~span(planes, base + w);
+                if (w == m_row_words - 1) word &= last_mask;
+                for (; word; word &= word - 1) f(r, (w << 6) + std::countr_zero(word));
+            }
+        }
+    }
+
+    // Number of cells set in any of the given planes.
+    int count_any(unsigned planes) const {
+        int total = 0;
+        for (std::size_t i = 0; i < plane_words(); ++i) total += std::popcount(span(planes, i));
+        return total;
+    }
+
+    // Number of cells set in one plane.
+    int count(Plane p) const {
+        int total = 0;
+        for (std::size_t i = 0; i < plane_words(); ++i) total += std::popcount(m_planes[p][i]);
+        return total;
+    }
+
+private:
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_row_words = 0;
+    CellStore<std::uint64_t> m_obstacles;   // mounds, pits, flames
+    CellStore<std::uint64_t> m_units;       // robots, wrecks
+    std::uint64_t* m_planes[plane_count] = {};   // word r * m_row_words + c / 64, bit c % 64
+
+    void layout(int rows, int cols) {
+        m_rows = rows;
+        m_cols = cols;
+        m_row_words = (cols + 63) / 64;
+    }
+
+    std::size_t plane_words() const { return static_cast<std::size_t>(m_rows) * m_row_words; }
+
+    void bind() {
+        for (int p = 0; p < plane_count; ++p) {
+            m_planes[p] = p < obstacle_planes
+                              ? m_obstacles.data() + p * plane_words()
+                              : m_units.data() + (p - obstacle_planes) * plane_words();
+        }
+    }
+
+    std::size_t line(int r) const { return static_cast<std::size_t>(r) * m_row_words; }
+
+    std::uint64_t span(unsigned planes, std::size_t word) const {
+        std::uint64_t bits = 0;
+        for (; planes; planes &= planes - 1) {
+            bits |= m_planes[std::countr_zero(planes)][word];
+        }
+        return bits;
+    }
+};
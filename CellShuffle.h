@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Rng.h"
+
+// Deals a set of cells in random order, one at a time, without repeats: a
+// Fisher-Yates shuffle run only as far as it is drawn. Each draw takes a
+// random cell out and moves the last one into its slot, so a draw is O(1)
+// and the array only ever holds cells still to be dealt.
+//
+// Arena fills one with the free cells of a crowded board, so obstacles and
+// robots never land on each other and no draw is thrown away, however full
+// the board gets.
+class CellShuffle {
+public:
+    void clear() { m_cells.clear(); }
+    void reserve(std::size_t cells) { m_cells.reserve(cells); }
+    void add(std::uint32_t cell) { m_cells.push_back(cell); }
+
+    std::size_t remaining() const { return m_cells.size(); }
+
+    // Only while remaining() > 0.
+    std::uint32_t draw(Rng& rng) {
+        std::uint32_t pick = rng.below(static_cast<std::uint32_t>(m_cells.size()));
+        std::uint32_t cell = m_cells[pick];
+        m_cells[pick] = m_cells.back();
+        m_cells.pop_back();
+        return cell;
+    }
+
+private:
+    std::vector<std::uint32_t> m_cells;
+};
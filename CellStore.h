@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// The memory behind a board-sized array: either its own, from calloc, or a
+// view of memory someone else owns (a mapped map file, see MapFile.h).
+//
+// A fresh zeroed store of any size costs next to nothing: calloc hands big
+// blocks straight over from the OS, and their pages only turn into memory
+// once written. That is why Arena's per-cell arrays use zero for "nothing
+// here".
+template <typename T>
+class CellStore {
+    static_assert(std::is_trivially_copyable_v<T>, "cells are copied as bytes");
+
+public:
+    CellStore() = default;
+    ~CellStore() { release(); }
+
+    CellStore(const CellStore& other) { copy_from(other); }
+    CellStore& operator=(const CellStore& other) {
+        if (this != &other) {
+            release();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    CellStore(CellStore&& other) noexcept { take(other); }
+    CellStore& operator=(CellStore&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    // n cells, all bytes zero.
+    void zeroed(std::size_t n) {
+        release();
+        if (n == 0) return;
+        m_data = static_cast<T*>(std::calloc(n, sizeof(T)));
+        if (!m_data) throw std::bad_alloc();
+        m_size = n;
+        m_owned = true;
+    }
+
+    // n cells of `value`.
+    void filled(std::size_t n, const T& value) {
+        zeroed(n);
+        if (!is_zero(value)) std::fill(m_data, m_data + n, value);
+    }
+
+    // Use n cells at `cells`, which must outlive this store (or the next
+    // zeroed/filled call).
+    void view(T* cells, std::size_t n) {
+        release();
+        m_data = cells;
+        m_size = n;
+    }
+
+    bool is_view() const { return m_data && !m_owned; }
+
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+    T& operator[](std::size_t i) { return m_data[i]; }
+    const T& operator[](std::size_t i) const { return m_data[i]; }
+
+private:
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_owned = false;
+
+    static bool is_zero(const T& value) {
+        static const T zero{};
+        return std::memcmp(&value, &zero, sizeof(T)) == 0;
+    }
+
+    void release() {
+        if (m_owned) std::free(m_data);
+        m_data = nullptr;
+        m_size = 0;
+        m_owned = false;
+    }
+
+    // Copies are always stores of their own.
+    void copy_from(const CellStore& other) {
+        zeroed(other.m_size);
+        if (m_size) std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+    }
+
+    void take(CellStore& other) {
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_owned = other.m_owned;
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_owned = false;
+    }
+};
@@ -0,0 +1,157 @@
+#include "ConsoleSink.h"
+#include "Arena.h"
+
+static const char* weapon_name(WeaponType weapon) {
+    switch (weapon) {
+        case flamethrower: return "flamethrower";
+        case railgun:      return "railgun";
+        case grenade:      return "grenade";
+        case hammer:       return "hammer";
+    }
+    return "unknown";
+}
+
+void ConsoleSink::config_missing(const std::string& filename) {
+    std::cout << "Config file '" << filename
+              << "' not found. Using default settings.\n";
+}
+
+void ConsoleSink::config_loaded(int rows, int cols, int mounds, int pits,
+                                int flames, int max_rounds) {
+    std::cout << "Loaded config: " << rows << "x" << cols
+              << ", Mounds=" << mounds
+              << ", Pits=" << pits
+              << ", Flames=" << flames
+              << ", Rounds=" << max_rounds << "\n";
+}
+
+void ConsoleSink::robot_compiling(const std::string& source, const std::string& shared_lib) {
+    std::cout << "Compiling " << source << " to " << shared_lib << "...\n";
+}
+
+void ConsoleSink::robot_cached(const std::string& source, const std::string& shared_lib) {
+    std::cout << "Using cached " << shared_lib << " for " << source << "\n";
+}
+
+void ConsoleSink::libraries_loaded(int count, int cached, double elapsed_ms) {
+    std::cout << "Loaded " << count << " robot libraries in "
+              << elapsed_ms << " ms (" << cached << " from cache).\n";
+}
+
+void ConsoleSink::robot_loaded(const RobotInfo& info) {
+    std::cout << "Loaded robot: " << info.robot->m_name
+              << " at (" << info.row << "," << info.col << ")\n";
+}
+
+void ConsoleSink::round_start(const Arena& arena, int round) {
+    arena.print_board(round);
+}
+
+void ConsoleSink::turn_start(const RobotInfo& info) {
+    std::cout << info.robot->m_name << " " << info.symbol
+              << " begins turn.\n";
+}
+
+void ConsoleSink::radar(const RobotInfo&, int, const std::vector<RadarObj>& results) {
+    if (results.empty()) {
+        std::cout << "  radar found nothing.\n";
+    } else {
+        std::cout << "  radar found " << results.size() << " objects.\n";
+    }
+}
+
+void ConsoleSink::move_rejected(const RobotInfo& info, MoveProblem problem) {
+    switch (problem) {
+        case MoveProblem::stuck:
+            std::cout << "  " << info.robot->m_name
+                      << " is stuck and cannot move.\n";
+            break;
+        case MoveProblem::invalid_direction:
+            std::cout << "  invalid move direction.\n";
+            break;
+        case MoveProblem::no_move:
+            std::cout << "  chose not to move.\n";
+            break;
+    }
+}
+
+void ConsoleSink::move_hazard(const RobotInfo& info, char cell, int row, int col) {
+    if (cell == 'P') {
+        std::cout << "  " << info.robot->m_name
+                  << " fell into a pit at (" << row << "," << col << ").\n";
+    } else {
+        std::cout << "  " << info.robot->m_name
+                  << " moves through flames at (" << row << "," << col << ").\n";
+    }
+}
+
+void ConsoleSink::move_end(const RobotInfo& info) {
+    std::cout << "  " << info.robot->m_name << " ends move at ("
+              << info.row << "," << info.col << ").\n";
+}
+
+void ConsoleSink::shot(const RobotInfo& info, WeaponType weapon, int, int) {
+    std::cout << "  " << info.robot->m_name << " fires "
+              << weapon_name(weapon) << ".\n";
+}
+
+void ConsoleSink::shot_rejected(const RobotInfo&, ShotProblem problem) {
+    switch (problem) {
+        case ShotProblem::out_of_bounds:
+            std::cout << "  Shot location is out of bounds; ignoring.\n";
+            break;
+        case ShotProblem::no_grenades:
+            std::cout << "  But has no grenades left!\n";
+            break;
+        case ShotProblem::nothing_to_hammer:
+            std::cout << "  Nothing there to hammer.\n";
+            break;
+        case ShotProblem::not_adjacent:
+            std::cout << "  Hammer target not adjacent.\n";
+            break;
+    }
+}
+
+void ConsoleSink::damage(const RobotInfo& info, int amount, int health_before, int health_after) {
+    std::cout << "  " << info.robot->m_name
+              << " takes " << amount
+              << " damage (health " << health_before
+              << " -> " << health_after << ").\n";
+}
+
+void ConsoleSink::death(const RobotInfo& info) {
+    std::cout << "  " << info.robot->m_name << " is destroyed!\n";
+}
+
+void ConsoleSink::overrun(const RobotInfo& info, RobotCall call, double budget_ms) {
+    std::cout << "  " << info.robot->m_name << " took longer than " << budget_ms
+              << " ms in " << robot_call_name(call) << " and is out of the game.\n";
+}
+
+void ConsoleSink::crashed(const RobotInfo& info, RobotCall call) {
+    std::cout << "  " << info.robot->m_name << " crashed in " << robot_call_name(call)
+              << " and is out of the game.\n";
+}
+
+void ConsoleSink::game_over(GameResult result, const RobotInfo* winner) {
+    print_game_result(std::cout, result, winner);
+}
+
+void print_game_result(std::ostream& out, GameResult result, const RobotInfo* winner) {
+    switch (result) {
+        case GameResult::winner:
+            out << "Winner: " << winner->robot->m_name << "!\n";
+            break;
+        case GameResult::draw:
+            out << "Nobody survived. It's a draw.\n";
+            break;
+        case GameResult::round_limit:
+            out << "Reached max rounds with multiple robots alive.\n";
+            break;
+        case GameResult::no_robots:
+            out << "No robots loaded. Nothing to do.\n";
+            break;
+        case GameResult::none:
+            break;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "EventSink.h"
+
+// Prints the running commentary of a game to std::cout - the text the arena
+// has always produced.
+class ConsoleSink : public EventSink {
+public:
+    void config_missing(const std::string& filename) override;
+    void config_loaded(int rows, int cols, int mounds, int pits,
+                       int flames, int max_rounds) override;
+    void robot_compiling(const std::string& source, const std::string& shared_lib) override;
+    void robot_cached(const std::string& source, const std::string& shared_lib) override;
+    void libraries_loaded(int count, int cached, double elapsed_ms) override;
+    void robot_loaded(const RobotInfo& info) override;
+
+    void round_start(const Arena& arena, int round) override;
+    void turn_start(const RobotInfo& info) override;
+    void radar(const RobotInfo& info, int radar_dir, const std::vector<RadarObj>& results) override;
+    void move_rejected(const RobotInfo& info, MoveProblem problem) override;
+    void move_hazard(const RobotInfo& info, char cell, int row, int col) override;
+    void move_end(const RobotInfo& info) override;
+    void shot(const RobotInfo& info, WeaponType weapon, int row, int col) override;
+    void shot_rejected(const RobotInfo& info, ShotProblem problem) override;
+    void damage(const RobotInfo& info, int amount, int health_before, int health_after) override;
+    void death(const RobotInfo& info) override;
+    void overrun(const RobotInfo& info, RobotCall call, double budget_ms) override;
+    void crashed(const RobotInfo& info, RobotCall call) override;
+    void game_over(GameResult result, const RobotInfo* winner) override;
+};
+
+// The one-line end-of-game message ("Winner: ...!" etc). Headless runs
+// print only this.
+void print_game_result(std::ostream& out, GameResult result, const RobotInfo* winner);
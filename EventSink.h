@@ -0,0 +1,158 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "RobotBase.h"
+#include "RadarObj.h"
+
+class Arena;
+struct RobotInfo;
+
+// How a game ended.
+enum class GameResult { none, winner, draw, round_limit, no_robots };
+
+// Why a move request did not (fully) happen.
+enum class MoveProblem { stuck, invalid_direction, no_move };
+
+// Why a shot did not do anything.
+enum class ShotProblem { out_of_bounds, no_grenades, nothing_to_hammer, not_adjacent };
+
+// The robot callbacks a turn is made of (take_turn: see TurnRobot.h).
+enum class RobotCall { get_radar_direction, process_radar_results, get_shot_location, get_move_direction,
+                       take_turn };
+
+inline const char* robot_call_name(RobotCall call) {
+    switch (call) {
+        case RobotCall::get_radar_direction:   return "get_radar_direction";
+        case RobotCall::process_radar_results: return "process_radar_results";
+        case RobotCall::get_shot_location:     return "get_shot_location";
+        case RobotCall::get_move_direction:    return "get_move_direction";
+        case RobotCall::take_turn:             return "take_turn";
+    }
+    return "unknown";
+}
+
+// Everything the arena reports while it sets up and plays a game goes
+// through one of these calls instead of straight to std::cout. The base
+// class ignores every event, so it doubles as the sink for headless runs:
+// the game loop then does no formatting work at all.
+class EventSink {
+public:
+    virtual ~EventSink() = default;
+
+    // setup
+    virtual void config_missing(const std::string&) {}
+    virtual void config_loaded(int /*rows*/, int /*cols*/, int /*mounds*/, int /*pits*/,
+                               int /*flames*/, int /*max_rounds*/) {}
+    virtual void robot_compiling(const std::string& /*source*/, const std::string& /*shared_lib*/) {}
+    virtual void robot_cached(const std::string& /*source*/, const std::string& /*shared_lib*/) {}
+    virtual void libraries_loaded(int /*count*/, int /*cached*/, double /*elapsed_ms*/) {}
+    virtual void robot_loaded(const RobotInfo&) {}
+
+    // game loop
+    virtual void round_start(const Arena&, int /*round*/) {}
+    virtual void turn_start(const RobotInfo&) {}
+    virtual void radar(const RobotInfo&, int /*radar_dir*/, const std::vector<RadarObj>&) {}
+    virtual void move_rejected(const RobotInfo&, MoveProblem) {}
+    virtual void move_hazard(const RobotInfo&, char /*cell*/, int /*row*/, int /*col*/) {}
+    virtual void move_end(const RobotInfo&) {}
+    virtual void shot(const RobotInfo&, WeaponType, int /*row*/, int /*col*/) {}
+    virtual void shot_rejected(const RobotInfo&, ShotProblem) {}
+    virtual void damage(const RobotInfo&, int /*amount*/, int /*health_before*/, int /*health_after*/) {}
+    virtual void death(const RobotInfo&) {}
+    // A callback ran past the call budget; death() follows, the robot is out.
+    virtual void overrun(const RobotInfo&, RobotCall, double /*budget_ms*/) {}
+    // An isolated robot's process died during a callback; death() follows.
+    virtual void crashed(const RobotInfo&, RobotCall) {}
+    virtual void game_over(GameResult, const RobotInfo* /*winner*/) {}
+};
+
+// Passes every event on to two sinks, e.g. the console and an event
+// stream.
+class TeeSink : public EventSink {
+public:
+    TeeSink(EventSink& first, EventSink& second) : m_first(first), m_second(second) {}
+
+    void config_missing(const std::string& filename) override {
+        m_first.config_missing(filename);
+        m_second.config_missing(filename);
+    }
+    void config_loaded(int rows, int cols, int mounds, int pits, int flames, int max_rounds) override {
+        m_first.config_loaded(rows, cols, mounds, pits, flames, max_rounds);
+        m_second.config_loaded(rows, cols, mounds, pits, flames, max_rounds);
+    }
+    void robot_compiling(const std::string& source, const std::string& shared_lib) override {
+        m_first.robot_compiling(source, shared_lib);
+        m_second.robot_compiling(source, shared_lib);
+    }
+    void robot_cached(const std::string& source, const std::string& shared_lib) override {
+        m_first.robot_cached(source, shared_lib);
+        m_second.robot_cached(source, shared_lib);
+    }
+    void libraries_loaded(int count, int cached, double elapsed_ms) override {
+        m_first.libraries_loaded(count, cached, elapsed_ms);
+        m_second.libraries_loaded(count, cached, elapsed_ms);
+    }
+    void robot_loaded(const RobotInfo& info) override {
+        m_first.robot_loaded(info);
+        m_second.robot_loaded(info);
+    }
+
+    void round_start(const Arena& arena, int round) override {
+        m_first.round_start(arena, round);
+        m_second.round_start(arena, round);
+    }
+    void turn_start(const RobotInfo& info) override {
+        m_first.turn_start(info);
+        m_second.turn_start(info);
+    }
+    void radar(const RobotInfo& info, int radar_dir, const std::vector<RadarObj>& results) override {
+        m_first.radar(info, radar_dir, results);
+        m_second.radar(info, radar_dir, results);
+    }
+    void move_rejected(const RobotInfo& info, MoveProblem problem) override {
+        m_first.move_rejected(info, problem);
+        m_second.move_rejected(info, problem);
+    }
+    void move_hazard(const RobotInfo& info, char cell, int row, int col) override {
+        m_first.move_hazard(info, cell, row, col);
+        m_second.move_hazard(info, cell, row, col);
+    }
+    void move_end(const RobotInfo& info) override {
+        m_first.move_end(info);
+        m_second.move_end(info);
+    }
+    void shot(const RobotInfo& info, WeaponType weapon, int row, int col) override {
+        m_first.shot(info, weapon, row, col);
+        m_second.shot(info, weapon, row, col);
+    }
+    void shot_rejected(const RobotInfo& info, ShotProblem problem) override {
+        m_first.shot_rejected(info, problem);
+        m_second.shot_rejected(info, problem);
+    }
+    void damage(const RobotInfo& info, int amount, int health_before, int health_after) override {
+        m_first.damage(info, amount, health_before, health_after);
+        m_second.damage(info, amount, health_before, health_after);
+    }
+    void death(const RobotInfo& info) override {
+        m_first.death(info);
+        m_second.death(info);
+    }
+    void overrun(const RobotInfo& info, RobotCall call, double budget_ms) override {
+        m_first.overrun(info, call, budget_ms);
+        m_second.overrun(info, call, budget_ms);
+    }
+    void crashed(const RobotInfo& info, RobotCall call) override {
+        m_first.crashed(info, call);
+        m_second.crashed(info, call);
+    }
+    void game_over(GameResult result, const RobotInfo* winner) override {
+        m_first.game_over(result, winner);
+        m_second.game_over(result, winner);
+    }
+
+private:
+    EventSink& m_first;
+    EventSink& m_second;
+};
@@ -0,0 +1,317 @@
+#include "EventStream.h"
+#include "Arena.h"
+#include "Csv.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+static const char* type_names[] = {
+    "turn_start", "radar", "move", "shot", "damage", "death", "overrun", "crashed", "winner",
+};
+
+static const char* weapon_name(WeaponType weapon) {
+    switch (weapon) {
+        case flamethrower: return "flamethrower";
+        case railgun:      return "railgun";
+        case grenade:      return "grenade";
+        case hammer:       return "hammer";
+    }
+    return "unknown";
+}
+
+static const char* move_problem_name(MoveProblem problem) {
+    switch (problem) {
+        case MoveProblem::stuck:             return "stuck";
+        case MoveProblem::invalid_direction: return "invalid_direction";
+        case MoveProblem::no_move:           return "no_move";
+    }
+    return "unknown";
+}
+
+static const char* shot_problem_name(ShotProblem problem) {
+    switch (problem) {
+        case ShotProblem::out_of_bounds:     return "out_of_bounds";
+        case ShotProblem::no_grenades:       return "no_grenades";
+        case ShotProblem::nothing_to_hammer: return "nothing_to_hammer";
+        case ShotProblem::not_adjacent:      return "not_adjacent";
+    }
+    return "unknown";
+}
+
+static const char* result_name(GameResult result) {
+    switch (result) {
+        case GameResult::none:        return "none";
+        case GameResult::winner:      return "winner";
+        case GameResult::draw:        return "draw";
+        case GameResult::round_limit: return "round_limit";
+        case GameResult::no_robots:   return "no_robots";
+    }
+    return "unknown";
+}
+
+bool parse_event_format(const std::string& text, EventFormat& out) {
+    if (text == "jsonl") out = EventFormat::jsonl;
+    else if (text == "csv") out = EventFormat::csv;
+    else return false;
+    return true;
+}
+
+// Collects one line on the stack and appends it to the block in one go;
+// appending a character at a time costs more than the formatting.
+class LineBuffer {
+public:
+    explicit LineBuffer(std::string& out) : m_out(out) {}
+    ~LineBuffer() { flush(); }
+
+    void put(char c) {
+        if (m_used == sizeof m_buf) flush();
+        m_buf[m_used++] = c;
+    }
+
+    void put(std::string_view text) {
+        if (m_used + text.size() > sizeof m_buf) flush();
+        if (text.size() > sizeof m_buf) {
+            m_out.append(text.data(), text.size());
+            return;
+        }
+        std::memcpy(m_buf + m_used, text.data(), text.size());
+        m_used += text.size();
+    }
+
+    void number(int value) {
+        if (m_used + 12 > sizeof m_buf) flush();
+        m_used = static_cast<std::size_t>(
+            std::to_chars(m_buf + m_used, m_buf + sizeof m_buf, value).ptr - m_buf);
+    }
+
+    void json_string(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        put('"');
+        for (char ch : text) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(ch);
+            } else if (c < 0x20) {
+                put("\\u00");
+                put(hex[c >> 4]);
+                put(hex[c & 15]);
+            } else {
+                put(ch);
+            }
+        }
+        put('"');
+    }
+
+    void csv_field(std::string_view text) {
+        flush();
+        append_csv_field(m_out, text);
+    }
+
+private:
+    std::string& m_out;
+    char m_buf[256];
+    std::size_t m_used = 0;
+
+    void flush() {
+        m_out.append(m_buf, m_used);
+        m_used = 0;
+    }
+};
+
+const char* EventStream::csv_header() {
+    return "event,round,robot,symbol,row,col,health,direction,found,weapon,amount,outcome\n";
+}
+
+void EventStream::format(EventFormat format, const StreamEvent& e, std::string& out) {
+    LineBuffer line(out);
+    std::string_view name;
+    std::string_view symbol;
+    if (e.robot) {
+        name = e.robot->robot->m_name;
+        symbol = std::string_view(&e.robot->symbol, 1);
+    }
+
+    if (format == EventFormat::csv) {
+        auto number = [&](int value) {
+            line.put(',');
+            if (value != StreamEvent::unset) line.number(value);
+        };
+        auto text = [&](const char* value) {
+            line.put(',');
+            if (value) line.put(value);
+        };
+
+        line.put(type_names[e.type]);
+        number(e.round);
+        line.put(',');
+        if (e.robot) line.csv_field(name);
+        line.put(',');
+        if (e.robot) line.csv_field(symbol);
+        number(e.row);
+        number(e.col);
+        number(e.health);
+        number(e.direction);
+        number(e.found);
+        text(e.weapon);
+        number(e.amount);
+        text(e.outcome);
+        line.put('\n');
+        return;
+    }
+
+    auto number = [&](std::string_view key, int value) {
+        if (value == StreamEvent::unset) return;
+        line.put(key);
+        line.number(value);
+    };
+    auto text = [&](std::string_view key, const char* value) {
+        if (!value) return;
+        line.put(key);
+        line.put(value);
+        line.put('"');
+    };
+
+    line.put("{\"event\":\"");
+    line.put(type_names[e.type]);
+    line.put("\",\"round\":");
+    line.number(e.round);
+    if (e.robot) {
+        line.put(",\"robot\":");
+        line.json_string(name);
+        line.put(",\"symbol\":");
+        line.json_string(symbol);
+    }
+    number(",\"row\":", e.row);
+    number(",\"col\":", e.col);
+    number(",\"health\":", e.health);
+    number(",\"direction\":", e.direction);
+    number(",\"found\":", e.found);
+    text(",\"weapon\":\"", e.weapon);
+    number(",\"amount\":", e.amount);
+    text(",\"outcome\":\"", e.outcome);
+    line.put("}\n");
+}
+
+bool EventStream::open(const std::string& path) {
+    if (!m_writer.open(path)) return false;
+    m_round = 0;
+    m_rounds_played = 0;
+    m_events = 0;
+    if (m_format == EventFormat::csv) {
+        m_writer.block() += csv_header();
+        m_writer.done_appending();
+    }
+    return true;
+}
+
+StreamEvent EventStream::event(StreamEvent::Type type, const RobotInfo& info) const {
+    StreamEvent e;
+    e.type = type;
+    e.round = m_round;
+    e.robot = &info;
+    return e;
+}
+
+void EventStream::emit(const StreamEvent& event) {
+    if (!m_writer.is_open()) return;
+    format(m_format, event, m_writer.block());
+    m_writer.done_appending();
+    ++m_events;
+}
+
+void EventStream::round_start(const Arena&, int round) {
+    m_round = round;
+    m_rounds_played = round + 1;
+}
+
+void EventStream::turn_start(const RobotInfo& info) {
+    StreamEvent e = event(StreamEvent::turn_start, info);
+    e.row = info.row;
+    e.col = info.col;
+    e.health = info.robot->get_health();
+    emit(e);
+}
+
+void EventStream::radar(const RobotInfo& info, int radar_dir, const std::vector<RadarObj>& results) {
+    StreamEvent e = event(StreamEvent::radar, info);
+    e.direction = radar_dir;
+    e.found = static_cast<int>(results.size());
+    emit(e);
+}
+
+void EventStream::move_rejected(const RobotInfo& info, MoveProblem problem) {
+    StreamEvent e = event(StreamEvent::move, info);
+    e.row = info.row;
+    e.col = info.col;
+    e.outcome = move_problem_name(problem);
+    emit(e);
+}
+
+void EventStream::move_hazard(const RobotInfo& info, char cell, int row, int col) {
+    StreamEvent e = event(StreamEvent::move, info);
+    e.row = row;
+    e.col = col;
+    e.outcome = cell == 'P' ? "pit" : "flame";
+    emit(e);
+}
+
+void EventStream::move_end(const RobotInfo& info) {
+    StreamEvent e = event(StreamEvent::move, info);
+    e.row = info.row;
+    e.col = info.col;
+    e.outcome = "moved";
+    emit(e);
+}
+
+void EventStream::shot(const RobotInfo& info, WeaponType weapon, int row, int col) {
+    StreamEvent e = event(StreamEvent::shot, info);
+    e.weapon = weapon_name(weapon);
+    e.row = row;
+    e.col = col;
+    e.outcome = "fired";
+    emit(e);
+}
+
+void EventStream::shot_rejected(const RobotInfo& info, ShotProblem problem) {
+    StreamEvent e = event(StreamEvent::shot, info);
+    e.weapon = weapon_name(info.robot->get_weapon());
+    e.outcome = shot_problem_name(problem);
+    emit(e);
+}
+
+void EventStream::damage(const RobotInfo& info, int amount, int, int health_after) {
+    StreamEvent e = event(StreamEvent::damage, info);
+    e.amount = amount;
+    e.health = health_after < 0 ? 0 : health_after;
+    emit(e);
+}
+
+void EventStream::death(const RobotInfo& info) {
+    StreamEvent e = event(StreamEvent::death, info);
+    e.row = info.row;
+    e.col = info.col;
+    emit(e);
+}
+
+void EventStream::overrun(const RobotInfo& info, RobotCall call, double) {
+    StreamEvent e = event(StreamEvent::overrun, info);
+    e.outcome = robot_call_name(call);
+    emit(e);
+}
+
+void EventStream::crashed(const RobotInfo& info, RobotCall call) {
+    StreamEvent e = event(StreamEvent::crashed, info);
+    e.outcome = robot_call_name(call);
+    emit(e);
+}
+
+void EventStream::game_over(GameResult result, const RobotInfo* winner) {
+    StreamEvent e;
+    e.type = StreamEvent::winner;
+    e.round = m_rounds_played;
+    e.robot = winner;
+    e.outcome = result_name(result);
+    emit(e);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BackgroundWriter.h"
+#include "EventSink.h"
+
+enum class EventFormat { jsonl, csv };
+
+// Reads "jsonl" or "csv"; false for anything else.
+bool parse_event_format(const std::string& text, EventFormat& out);
+
+// One game event as it appears in an event stream. Fields an event type
+// doesn't use are left at `unset` and not written.
+struct StreamEvent {
+    enum Type { turn_start, radar, move, shot, damage, death, overrun, crashed, winner };
+
+    static constexpr int unset = -1;
+
+    Type type;
+    int round = 0;
+    const RobotInfo* robot = nullptr;
+    int row = unset;
+    int col = unset;
+    int health = unset;
+    int direction = unset;
+    int found = unset;        // radar: objects seen
+    int amount = unset;       // damage: points taken
+    const char* weapon = nullptr;
+    const char* outcome = nullptr;
+};
+
+// Writes the game as a stream of typed events, one per line:
+//
+//   turn_start  robot, row, col, health
+//   radar       robot, direction, found
+//   move        robot, row, col, outcome (moved, pit, flame, stuck,
+//               invalid_direction, no_move)
+//   shot        robot, weapon, row, col, outcome (fired, or why it failed:
+//               out_of_bounds, no_grenades, nothing_to_hammer, not_adjacent)
+//   damage      robot, amount, health (after the hit)
+//   death       robot, row, col
+//   overrun     robot, outcome (the callback that ran past the call budget;
+//               a death follows)
+//   crashed     robot, outcome (the callback its process died in; a death
+//               follows)
+//   winner      round (rounds played), outcome (winner, draw, round_limit,
+//               no_robots), robot (only when there is a winner)
+//
+// Every event also carries the round and the robot's symbol. JSONL writes
+// one object per line with only the fields the event uses; CSV writes a
+// header and the same columns for every event, leaving unused ones empty.
+//
+// Lines are formatted on the game thread into a BackgroundWriter block, so
+// the game never waits for the disk.
+class EventStream : public EventSink {
+public:
+    explicit EventStream(EventFormat format = EventFormat::jsonl) : m_format(format) {}
+
+    // Reports problems on std::cerr and returns false.
+    bool open(const std::string& path);
+    // Writes out whatever is still waiting and closes the file.
+    void close() { m_writer.close(); }
+
+    std::uint64_t events_written() const { return m_events; }
+
+    void round_start(const Arena& arena, int round) override;
+    void turn_start(const RobotInfo& info) override;
+    void radar(const RobotInfo& info, int radar_dir, const std::vector<RadarObj>& results) override;
+    void move_rejected(const RobotInfo& info, MoveProblem problem) override;
+    void move_hazard(const RobotInfo& info, char cell, int row, int col) override;
+    void move_end(const RobotInfo& info) override;
+    void shot(const RobotInfo& info, WeaponType weapon, int row, int col) override;
+    void shot_rejected(const RobotInfo& info, ShotProblem problem) override;
+    void damage(const RobotInfo& info, int amount, int health_before, int health_after) override;
+    void death(const RobotInfo& info) override;
+    void overrun(const RobotInfo& info, RobotCall call, double budget_ms) override;
+    void crashed(const RobotInfo& info, RobotCall call) override;
+    void game_over(GameResult result, const RobotInfo* winner) override;
+
+    // Appends one event, formatted, to `out` (without going near a file).
+    static void format(EventFormat format, const StreamEvent& event, std::string& out);
+    static const char* csv_header();
+
+private:
+    EventFormat m_format;
+    BackgroundWriter m_writer;
+    int m_round = 0;
+    int m_rounds_played = 0;
+    std::uint64_t m_events = 0;
+
+    StreamEvent event(StreamEvent::Type type, const RobotInfo& info) const;
+    void emit(const StreamEvent& event);
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// One cell of a precomputed shot path, relative to the shooter.
+//
+// The path only depends on the direction of the shot, except where it
+// passes exactly half way between two cells: there GridLine goes the way
+// the old double stepping rounded, which depends on where the shooter
+// stands. So each offset is stored doubled, rounded down, plus one if it
+// is a half, and row()/col() take the shooter's position and, for halves,
+// the stepped double (see GridLine).
+struct PathCell {
+    int dr2;
+    int dc2;
+
+    int row(int shooter_row, double stepped_row) const { return place(shooter_row, dr2, stepped_row); }
+    int col(int shooter_col, double stepped_col) const { return place(shooter_col, dc2, stepped_col); }
+
+private:
+    static int place(int start, int offset2, double stepped) {
+        if (offset2 & 1) return static_cast<int>(std::round(stepped));
+        return start + offset2 / 2;
+    }
+};
+
+// Shot paths by direction, built on first use. A railgun shot walks the
+// whole path until it leaves the arena; a flamethrower cone is centred on
+// its first four cells. Shots towards (2,3), (4,6) and (-6,-9) from the
+// shooter follow the same line, so they share one stored path.
+//
+// Every offset (dr, dc) a shot on the arena can have gets a slot that
+// remembers its path once seen, so a repeat lookup is one array read. Paths
+// live back to back in one buffer.
+//
+// Memory is bounded by max_cells: the cache only takes arenas where a path
+// for every possible offset would fit (up to about 79x79 by default, which
+// covers tournament-sized boards). On bigger arenas the table would mostly
+// miss and walking GridLine is faster anyway.
+class FootprintCache {
+public:
+    explicit FootprintCache(std::size_t max_cells = std::size_t(1) << 21)
+        : m_max_cells(max_cells) {}
+
+    // Whether paths for an arena whose longer side is `span` cells fit.
+    bool covers(int span) const {
+        std::size_t width = 2 * static_cast<std::size_t>(span) - 1;
+        return width * width * std::max(span, 4) <= m_max_cells;
+    }
+
+    // The path from the shooter towards a target (dr, dc) away, for an
+    // arena whose longer side is `span` cells; covers(span) must hold.
+    // (dr, dc) must not be (0, 0) and both must be less than span in size.
+    // The cells stay valid until the next miss.
+    std::span<const PathCell> path(int dr, int dc, int span) {
+        if (span != m_span) resize(span);
+
+        std::int32_t& slot = m_slots[slot_index(dr, dc)];
+        if (slot >= 0) {
+            m_hits++;
+            return stored(slot);
+        }
+
+        // A parallel shot may have stored the path already.
+        int g = std::gcd(std::abs(dr), std::abs(dc));
+        std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(dr / g)) << 32) |
+                            static_cast<std::uint32_t>(dc / g);
+        auto it = m_by_direction.find(key);
+        if (it != m_by_direction.end()) {
+            m_hits++;
+            slot = it->second;
+            return stored(slot);
+        }
+
+        m_misses++;
+        slot = static_cast<std::int32_t>(m_cells.size() / m_length);
+        m_by_direction.emplace(key, slot);
+        build(dr / g, dc / g);
+        return stored(slot);
+    }
+
+    std::uint64_t hits() const { return m_hits; }
+    std::uint64_t misses() const { return m_misses; }
+    std::size_t cells() const { return m_cells.size(); }
+    std::size_t paths() const { return m_by_direction.size(); }
+
+private:
+    std::size_t m_max_cells;
+    int m_span = 0;
+    int m_length = 0;   // cells per path: enough to cross the arena
+    std::uint64_t m_hits = 0;
+    std::uint64_t m_misses = 0;
+    std::vector<std::int32_t> m_slots;   // by (dr, dc), index of the stored path or -1
+    std::unordered_map<std::uint64_t, std::int32_t> m_by_direction;
+    std::vector<PathCell> m_cells;       // stored paths, m_length cells each
+
+    // A different arena size: start over.
+    void resize(int span) {
+        m_span = span;
+        m_length = std::max(span, 4);
+        std::size_t width = 2 * static_cast<std::size_t>(span) - 1;
+        m_slots.assign(width * width, -1);
+        m_by_direction.clear();
+        m_cells.clear();
+    }
+
+    std::size_t slot_index(int dr, int dc) const {
+        return static_cast<std::size_t>(dr + m_span - 1) * (2 * m_span - 1) + (dc + m_span - 1);
+    }
+
+    std::span<const PathCell> stored(std::int32_t index) const {
+        return { m_cells.data() + static_cast<std::size_t>(index) * m_length,
+                 static_cast<std::size_t>(m_length) };
+    }
+
+    // Stores the cells GridLine(0, 0, dr, dc) walks, halves left unrounded.
+    void build(int dr, int dc) {
+        int steps = std::max(std::abs(dr), std::abs(dc));
+        for (int i = 1; i <= m_length; ++i) {
+            m_cells.push_back({ doubled(i * dr, steps), doubled(i * dc, steps) });
+        }
+    }
+
+    // 2 * num / steps, rounded to the nearest whole of num / steps when
+    // that is unambiguous, or odd when num / steps is exactly a half.
+    static int doubled(int num, int steps) {
+        int whole = num / steps;
+        int rem = num % steps;
+        if (rem < 0) {
+            rem += steps;
+            whole--;
+        }
+        if (2 * rem == steps) return 2 * whole + 1;
+        return 2 * (2 * rem > steps ? whole + 1 : whole);
+    }
+};
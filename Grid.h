@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "CellStore.h"
+
+// A rows x cols grid stored row-major in one contiguous buffer, its own or
+// (after view()) someone else's, such as a mapped map file.
+// operator() does no bounds checking and is what the game loop uses once it
+// has called in_bounds(); at() checks and throws std::out_of_range.
+template <typename T>
+class Grid {
+public:
+    Grid() : m_rows(0), m_cols(0) {}
+    Grid(int rows, int cols, const T& value) { assign(rows, cols, value); }
+
+    void assign(int rows, int cols, const T& value) {
+        m_rows = rows;
+        m_cols = cols;
+        m_cells.filled(static_cast<std::size_t>(rows) * cols, value);
+    }
+
+    // Use rows * cols cells at `cells` as they are; they must outlive the
+    // grid (or its next assign).
+    void view(int rows, int cols, T* cells) {
+        m_rows = rows;
+        m_cols = cols;
+        m_cells.view(cells, static_cast<std::size_t>(rows) * cols);
+    }
+
+    void fill(const T& value) { std::fill(data(), data() + size(), value); }
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    std::size_t size() const { return m_cells.size(); }
+
+    bool in_bounds(int r, int c) const {
+        return r >= 0 && r < m_rows && c >= 0 && c < m_cols;
+    }
+
+    std::size_t index(int r, int c) const {
+        return static_cast<std::size_t>(r) * m_cols + c;
+    }
+
+    T& operator()(int r, int c) { return m_cells[index(r, c)]; }
+    const T& operator()(int r, int c) const { return m_cells[index(r, c)]; }
+
+    T& at(int r, int c) {
+        check(r, c);
+        return m_cells[index(r, c)];
+    }
+    const T& at(int r, int c) const {
+        check(r, c);
+        return m_cells[index(r, c)];
+    }
+
+    // Start of row r; the row's cols() cells follow contiguously.
+    T* row(int r) { return m_cells.data() + index(r, 0); }
+    const T* row(int r) const { return m_cells.data() + index(r, 0); }
+
+    T* data() { return m_cells.data(); }
+    const T* data() const { return m_cells.data(); }
+
+private:
+    int m_rows;
+    int m_cols;
+    CellStore<T> m_cells;
+
+    void check(int r, int c) const {
+        if (!in_bounds(r, c)) {
+            throw std::out_of_range("Grid cell (" + std::to_string(r) + "," +
+                                    std::to_string(c) + ") is outside " +
+                                    std::to_string(m_rows) + "x" +
+                                    std::to_string(m_cols));
+        }
+    }
+};
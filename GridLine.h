@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Steps cell by cell along the straight line from one cell through another,
+// using integers only.
+//
+// The line takes max(|dr|, |dc|) steps to reach its end point, so the long
+// axis moves exactly one cell per step. The short axis is at the exact
+// position start + step * d / steps, rounded to the nearest cell. These are
+// the cells the arena's old code visited by adding d / steps as a double
+// each step and calling std::round, except exactly half way between two
+// cells: there the old code went whichever way its rounding error tipped
+// it. To keep every game the same, each axis steps that double alongside
+// and asks it at halves.
+//
+// The line carries on past its end point for as long as advance() is called:
+//
+//     GridLine line(2, 2, 4, 5);
+//     line.advance();   // (3,3), then (3,4), (4,5), (5,6), (5,7), ...
+class GridLine {
+public:
+    GridLine(int from_row, int from_col, int to_row, int to_col)
+        : m_steps(std::max(std::abs(to_row - from_row), std::abs(to_col - from_col))),
+          m_row(from_row, to_row - from_row, m_steps),
+          m_col(from_col, to_col - from_col, m_steps) {}
+
+    // Steps from the start to the end point; 0 if they are the same cell and
+    // the line has no direction (don't advance it then).
+    int length() const { return m_steps; }
+
+    void advance() {
+        m_row.advance(m_steps);
+        m_col.advance(m_steps);
+    }
+
+    int row() const { return m_row.cell(m_steps); }
+    int col() const { return m_col.cell(m_steps); }
+
+private:
+    // Position along one axis as whole + frac / steps, with 0 <= frac < steps,
+    // and as the old code's double.
+    struct Axis {
+        int whole;
+        int frac;
+        int delta;
+        double stepped;
+        double increment;
+
+        Axis(int start, int d, int steps)
+            : whole(start), frac(0), delta(d), stepped(start),
+              increment(steps > 0 ? static_cast<double>(d) / steps : 0.0) {}
+
+        void advance(int steps) {
+            stepped += increment;
+            frac += delta;
+            if (frac >= steps) {
+                frac -= steps;
+                whole++;
+            } else if (frac < 0) {
+                frac += steps;
+                whole--;
+            }
+        }
+
+        int cell(int steps) const {
+            if (frac == 0) return whole;
+            if (2 * frac > steps) return whole + 1;
+            if (2 * frac < steps) return whole;
+            return static_cast<int>(std::round(stepped));   // exactly half way
+        }
+    };
+
+    int m_steps;
+    Axis m_row;
+    Axis m_col;
+};
@@ -0,0 +1,602 @@
+#include "IsolatedRobot.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <iostream>
+#include <link.h>
+#include <mutex>
+#include <new>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "SharedRing.h"
+
+using Clock = std::chrono::steady_clock;
+
+// The robot as the arena sees it; goes along with every call.
+struct RobotState {
+    std::int32_t health, armor, move, grenades;
+    std::int32_t row, col, row_max, col_max;
+};
+
+enum class MessageKind : std::uint32_t { call, radar, reply, hello, quit };
+
+constexpr std::uint32_t radar_chunk = 32;
+
+struct RobotMessage {
+    MessageKind kind;
+    RobotCall call;
+    RobotState state;          // call: arena's copy; hello: the robot as made
+    std::int32_t out_1;        // reply: the call's outputs
+    std::int32_t out_2;
+    std::int32_t flag;         // reply: get_shot_location's result; hello: weapon, -1 if none
+    TurnAction action;         // reply: take_turn's result
+    std::uint64_t call_ns[3];  // reply: a legacy robot's calls within take_turn, timed
+    std::uint32_t count;       // call: radar objects to follow; radar: objects in this chunk
+    struct {
+        std::int32_t row, col;
+        char type;
+    } radar[radar_chunk];
+};
+
+struct RobotChannel {
+    SharedRing<RobotMessage, 16> requests;   // arena to robot
+    SharedRing<RobotMessage, 16> replies;    // robot to arena
+    char name[64];                           // sent with hello
+    char symbol;
+};
+
+static RobotState state_of(RobotBase& robot) {
+    RobotState state;
+    state.health = robot.get_health();
+    state.armor = robot.get_armor();
+    state.move = robot.get_move_speed();
+    state.grenades = robot.get_grenades();
+    int row, col;
+    robot.get_current_location(row, col);
+    state.row = row;
+    state.col = col;
+    state.row_max = robot.m_board_row_max;
+    state.col_max = robot.m_board_col_max;
+    return state;
+}
+
+// Brings `robot` up to `state` using only what RobotBase lets anyone do;
+// the arena only ever lowers health, armor, speed and grenades.
+static void catch_up(RobotBase& robot, const RobotState& state) {
+    if (robot.get_health() > state.health) robot.take_damage(robot.get_health() - state.health);
+    if (robot.get_armor() > state.armor) robot.reduce_armor(robot.get_armor() - state.armor);
+    if (state.move == 0 && robot.get_move_speed() != 0) robot.disable_movement();
+    while (robot.get_grenades() > state.grenades) robot.decrement_grenades();
+    int row, col;
+    robot.get_current_location(row, col);
+    if (row != state.row || col != state.col) robot.move_to(state.row, state.col);
+    if (robot.m_board_row_max != state.row_max || robot.m_board_col_max != state.col_max)
+        robot.set_boundaries(state.row_max, state.col_max);
+}
+
+static timespec timeout_of(Clock::duration wait) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    timespec timeout;
+    timeout.tv_sec = ns / 1000000000;
+    timeout.tv_nsec = ns % 1000000000;
+    return timeout;
+}
+
+// ----- the child -----
+
+static void push(SharedRing<RobotMessage, 16>& ring, const RobotMessage& message) {
+    while (!ring.try_push(message)) ring.wait_for_room(nullptr);
+}
+
+static void pop(SharedRing<RobotMessage, 16>& ring, RobotMessage& message) {
+    while (!ring.try_pop(message)) ring.wait_for_item(nullptr);
+}
+
+[[noreturn]] static void serve(RobotChannel& channel, RobotFactory factory,
+                               unsigned int rand_seed) {
+    RobotMessage message{};
+    message.kind = MessageKind::hello;
+    message.flag = -1;
+    RobotBase* robot = factory();
+    if (robot) {
+        // RobotBase leaves the bounds unset; the arena's come with the
+        // first turn.
+        robot->set_boundaries(0, 0);
+        std::snprintf(channel.name, sizeof(channel.name), "%s", robot->m_name.c_str());
+        channel.symbol = robot->m_character;
+        message.state = state_of(*robot);
+        message.flag = robot->get_weapon();
+    }
+    push(channel.replies, message);
+    if (!robot) _exit(1);
+    std::srand(rand_seed);
+
+    // Legacy robots take whole turns through the adapter.
+    LegacyTurns legacy(*robot);
+    TurnRobot* turns = dynamic_cast<TurnRobot*>(robot);
+    if (!turns) turns = &legacy;
+
+    std::vector<RadarObj> radar;
+    auto read_radar = [&](std::uint32_t expected) {
+        radar.clear();
+        while (radar.size() < expected) {
+            pop(channel.requests, message);
+            for (std::uint32_t i = 0; i < message.count; i++)
+                radar.emplace_back(message.radar[i].type, message.radar[i].row,
+                                   message.radar[i].col);
+        }
+    };
+    while (true) {
+        pop(channel.requests, message);
+        if (message.kind == MessageKind::quit) break;
+
+        catch_up(*robot, message.state);
+        RobotMessage reply{};
+        reply.kind = MessageKind::reply;
+        switch (message.call) {
+        case RobotCall::get_radar_direction:
+            robot->get_radar_direction(reply.out_1);
+            break;
+        case RobotCall::process_radar_results:
+            read_radar(message.count);
+            robot->process_radar_results(radar);
+            break;
+        case RobotCall::get_shot_location:
+            reply.flag = robot->get_shot_location(reply.out_1, reply.out_2);
+            break;
+        case RobotCall::get_move_direction:
+            robot->get_move_direction(reply.out_1, reply.out_2);
+            break;
+        case RobotCall::take_turn:
+            read_radar(message.count);
+            reply.action = turns->take_turn(radar);
+            if (turns == &legacy) {
+                std::copy(legacy.call_ns().begin(), legacy.call_ns().end(), reply.call_ns);
+            }
+            break;
+        }
+        // Whatever the robot printed shows up now, not when the child is killed.
+        std::cout.flush();
+        push(channel.replies, reply);
+    }
+    std::cout.flush();
+    _exit(0);
+}
+
+// ----- the launcher -----
+
+// What launch() asks the launcher for. The channel's memory goes along as a
+// file descriptor, and the robot process's pidfd comes back the same way.
+struct LaunchRequest {
+    RobotFactory factory;      // code the launcher has too; or nullptr and
+    char library[1024];        // the robot process loads this library
+    char symbol[128];          // and calls this
+    unsigned int rand_seed;
+};
+
+struct LaunchReply {
+    pid_t pid;                 // -1 if there's no robot process
+    int error;                 // then: why
+};
+
+// Sends `size` bytes, with `fd` attached unless it is -1.
+static bool send_with_fd(int socket, const void* message, std::size_t size, int fd) {
+    iovec data{const_cast<void*>(message), size};
+    msghdr header{};
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        cmsghdr* attached = CMSG_FIRSTHDR(&header);
+        attached->cmsg_level = SOL_SOCKET;
+        attached->cmsg_type = SCM_RIGHTS;
+        attached->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(attached), &fd, sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = sendmsg(socket, &header, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == static_cast<ssize_t>(size);
+}
+
+// Receives exactly `size` bytes; `fd` gets the attached file descriptor, or
+// -1. False at end of file or on error.
+static bool receive_with_fd(int socket, void* message, std::size_t size, int& fd) {
+    iovec data{message, size};
+    msghdr header{};
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    ssize_t got;
+    do {
+        got = recvmsg(socket, &header, MSG_CMSG_CLOEXEC);
+    } while (got < 0 && errno == EINTR);
+
+    fd = -1;
+    cmsghdr* attached = got > 0 ? CMSG_FIRSTHDR(&header) : nullptr;
+    if (attached && attached->cmsg_level == SOL_SOCKET && attached->cmsg_type == SCM_RIGHTS)
+        std::memcpy(&fd, CMSG_DATA(attached), sizeof(int));
+    if (got == static_cast<ssize_t>(size)) return true;
+    if (fd >= 0) close(fd);
+    fd = -1;
+    return false;
+}
+
+// Runs in the robot process, just forked from the launcher.
+[[noreturn]] static void start_robot(const LaunchRequest& request, RobotChannel& channel,
+                                     pid_t launcher) {
+    // Die with the launcher, even if it went before prctl took effect.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != launcher) _exit(1);
+
+    RobotFactory factory = request.factory;
+    if (!factory) {
+        void* handle = dlopen(request.library, RTLD_LAZY);
+        if (handle) factory = (RobotFactory)dlsym(handle, request.symbol);
+        if (!factory) {
+            std::cerr << "Robot process could not load " << request.symbol << " from "
+                      << request.library << ": " << dlerror() << "\n";
+            _exit(1);
+        }
+    }
+    serve(channel, factory, request.rand_seed);
+}
+
+// The launcher is forked from the arena's process before the arena starts
+// any thread, and never starts one itself. Robot processes are forked from
+// it, so none of them starts life with a lock held by a thread that didn't
+// come along, and each can make its robot and use iostreams safely. It
+// exits when the arena closes its end of the socket, and dies with the
+// arena otherwise; robot processes die with it.
+[[noreturn]] static void run_launcher(int socket, pid_t arena) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != arena) _exit(0);
+    pid_t launcher = getpid();
+
+    LaunchRequest request;
+    int memory_fd;
+    while (receive_with_fd(socket, &request, sizeof(request), memory_fd)) {
+        // Robot processes that have exited; the arena watched them through
+        // their pidfds, which outlive them.
+        while (waitpid(-1, nullptr, WNOHANG) > 0) {}
+
+        LaunchReply reply{-1, 0};
+        int pidfd = -1;
+        void* memory = memory_fd < 0 ? MAP_FAILED
+                                     : mmap(nullptr, sizeof(RobotChannel), PROT_READ | PROT_WRITE,
+                                            MAP_SHARED, memory_fd, 0);
+        if (memory == MAP_FAILED) {
+            reply.error = memory_fd < 0 ? EBADF : errno;
+        } else {
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(socket);
+                close(memory_fd);
+                start_robot(request, *static_cast<RobotChannel*>(memory), launcher);
+            }
+            // Not reaped before this, so the pid is still the robot's.
+            if (pid > 0) pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+            if (pidfd >= 0) {
+                reply.pid = pid;
+            } else {
+                reply.error = errno;
+                if (pid > 0) kill(pid, SIGKILL);
+            }
+            munmap(memory, sizeof(RobotChannel));
+        }
+        if (memory_fd >= 0) close(memory_fd);
+        send_with_fd(socket, &reply, sizeof(reply), pidfd);
+        if (pidfd >= 0) close(pidfd);
+    }
+    _exit(0);
+}
+
+// ----- the arena's side -----
+
+// The arena's end of the launcher. `code` is the executable code the
+// launcher was forked with: factories in it work there as they are.
+static std::mutex launcher_mutex;
+static int launcher_socket = -1;
+static std::vector<std::pair<std::uintptr_t, std::uintptr_t>> launcher_code;
+
+static int note_code(dl_phdr_info* info, std::size_t, void* data) {
+    auto& code = *static_cast<std::vector<std::pair<std::uintptr_t, std::uintptr_t>>*>(data);
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& segment = info->dlpi_phdr[i];
+        if (segment.p_type != PT_LOAD || !(segment.p_flags & PF_X)) continue;
+        std::uintptr_t begin = info->dlpi_addr + segment.p_vaddr;
+        code.emplace_back(begin, begin + segment.p_memsz);
+    }
+    return 0;
+}
+
+// With launcher_mutex held.
+static bool start_launcher_locked() {
+    if (launcher_socket >= 0) return true;
+    int ends[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, ends) != 0) {
+        std::cerr << "Could not start the robot launcher: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    launcher_code.clear();
+    dl_iterate_phdr(note_code, &launcher_code);
+
+    // Otherwise the launcher inherits, and robots later print, anything
+    // still buffered.
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    pid_t arena = getpid();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Could not start the robot launcher: " << std::strerror(errno) << "\n";
+        close(ends[0]);
+        close(ends[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(ends[0]);
+        run_launcher(ends[1], arena);
+    }
+    close(ends[1]);
+    launcher_socket = ends[0];
+    return true;
+}
+
+bool IsolatedRobot::start_launcher() {
+    std::lock_guard<std::mutex> lock(launcher_mutex);
+    return start_launcher_locked();
+}
+
+// Says how the launcher finds `factory`: as it is if the launcher has its
+// code, otherwise by the library and symbol it was loaded from.
+static bool locate(RobotFactory factory, LaunchRequest& request) {
+    auto address = reinterpret_cast<std::uintptr_t>(factory);
+    for (const auto& range : launcher_code) {
+        if (address >= range.first && address < range.second) {
+            request.factory = factory;
+            return true;
+        }
+    }
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(factory), &info) && info.dli_sname &&
+        info.dli_saddr == reinterpret_cast<void*>(factory) &&
+        std::strlen(info.dli_fname) < sizeof(request.library) &&
+        std::strlen(info.dli_sname) < sizeof(request.symbol)) {
+        request.factory = nullptr;
+        std::strcpy(request.library, info.dli_fname);
+        std::strcpy(request.symbol, info.dli_sname);
+        return true;
+    }
+    std::cerr << "A robot factory has to be a library's exported function, or be loaded "
+                 "before the robot launcher started.\n";
+    return false;
+}
+
+static void kill_process(int pidfd) {
+    syscall(SYS_pidfd_send_signal, pidfd, SIGKILL, nullptr, 0);
+}
+
+// True once the process behind `pidfd` has exited.
+static bool exited(int pidfd) {
+    pollfd watch{pidfd, POLLIN, 0};
+    return poll(&watch, 1, 0) > 0;
+}
+
+static void wait_for_exit(int pidfd) {
+    pollfd watch{pidfd, POLLIN, 0};
+    while (poll(&watch, 1, -1) < 0 && errno == EINTR) {}
+}
+
+// Waits in short slices so a child that died is noticed even though it
+// never wakes us. On failure says why in `failure`.
+template <typename Try, typename Wait>
+static bool wait_on(int pidfd, Clock::time_point deadline, RobotFailure& failure,
+                    Try try_once, Wait wait) {
+    constexpr Clock::duration slice = std::chrono::milliseconds(10);
+    while (!try_once()) {
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            failure = RobotFailure::overrun;
+            return false;
+        }
+        timespec timeout = timeout_of(std::min(slice, deadline - now));
+        wait(&timeout);
+        if (try_once()) return true;
+        if (exited(pidfd)) {
+            failure = RobotFailure::crashed;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<IsolatedRobot> IsolatedRobot::launch(RobotFactory factory,
+                                                     std::chrono::microseconds budget,
+                                                     unsigned int rand_seed) {
+    int memory_fd = memfd_create("robot channel", MFD_CLOEXEC);
+    void* memory = MAP_FAILED;
+    if (memory_fd >= 0 && ftruncate(memory_fd, sizeof(RobotChannel)) == 0) {
+        memory = mmap(nullptr, sizeof(RobotChannel), PROT_READ | PROT_WRITE, MAP_SHARED,
+                      memory_fd, 0);
+    }
+    if (memory == MAP_FAILED) {
+        std::cerr << "Could not map memory for a robot process: " << std::strerror(errno) << "\n";
+        if (memory_fd >= 0) close(memory_fd);
+        return nullptr;
+    }
+    RobotChannel* channel = new (memory) RobotChannel();
+
+    LaunchRequest request{};
+    request.rand_seed = rand_seed;
+    LaunchReply reply{-1, EPIPE};
+    int pidfd = -1;
+    {
+        // Robots are launched from any thread, one at a time.
+        std::lock_guard<std::mutex> lock(launcher_mutex);
+        if (start_launcher_locked() && locate(factory, request)) {
+            errno = 0;
+            if (!send_with_fd(launcher_socket, &request, sizeof(request), memory_fd) ||
+                !receive_with_fd(launcher_socket, &reply, sizeof(reply), pidfd)) {
+                reply = LaunchReply{-1, errno ? errno : EPIPE};
+            }
+        } else {
+            reply.error = 0;
+        }
+    }
+    close(memory_fd);
+    if (reply.pid < 0 || pidfd < 0) {
+        if (reply.error != 0)
+            std::cerr << "Could not start a robot process: " << std::strerror(reply.error) << "\n";
+        if (pidfd >= 0) close(pidfd);
+        munmap(memory, sizeof(RobotChannel));
+        return nullptr;
+    }
+    pid_t pid = reply.pid;
+
+    // Making the robot is not a callback; the budget doesn't cover it.
+    RobotMessage hello;
+    RobotFailure failure = RobotFailure::none;
+    bool said_hello = wait_on(
+        pidfd, Clock::now() + std::chrono::seconds(10), failure,
+        [&] { return channel->replies.try_pop(hello); },
+        [&](const timespec* timeout) { channel->replies.wait_for_item(timeout); });
+    if (!said_hello || hello.flag < 0) {
+        std::cerr << "Robot process " << pid << " did not make a robot.\n";
+        if (!said_hello && failure == RobotFailure::overrun) kill_process(pidfd);
+        wait_for_exit(pidfd);
+        close(pidfd);
+        munmap(memory, sizeof(RobotChannel));
+        return nullptr;
+    }
+
+    std::unique_ptr<IsolatedRobot> robot(new IsolatedRobot(
+        hello.state.move, hello.state.armor, static_cast<WeaponType>(hello.flag), channel, pid,
+        pidfd));
+    robot->m_name = channel->name;
+    robot->m_character = channel->symbol;
+    catch_up(*robot, hello.state);
+    robot->set_budget(budget);
+    return robot;
+}
+
+IsolatedRobot::IsolatedRobot(int move, int armor, WeaponType weapon,
+                             RobotChannel* channel, pid_t pid, int pidfd)
+    : RobotBase(move, armor, weapon), m_channel(channel), m_pid(pid), m_pidfd(pidfd) {}
+
+IsolatedRobot::~IsolatedRobot() {
+    if (!m_gone) {
+        RobotMessage quit{};
+        quit.kind = MessageKind::quit;
+        // Between calls the child is waiting for a request; if there's no
+        // room for one something is wrong, so don't wait.
+        if (!m_channel->requests.try_push(quit)) kill_process(m_pidfd);
+        wait_for_exit(m_pidfd);
+    }
+    close(m_pidfd);
+    munmap(m_channel, sizeof(RobotChannel));
+}
+
+void IsolatedRobot::fail(RobotFailure failure) {
+    m_failure = failure;
+    if (!m_gone && failure == RobotFailure::overrun) {
+        kill_process(m_pidfd);
+        wait_for_exit(m_pidfd);
+    }
+    m_gone = true;
+}
+
+bool IsolatedRobot::call(RobotCall call, const std::vector<RadarObj>* radar, RobotMessage& reply) {
+    if (m_failure != RobotFailure::none) return false;
+
+    Clock::time_point deadline =
+        m_budget.count() > 0 ? Clock::now() + m_budget : Clock::time_point::max();
+    RobotFailure failure = RobotFailure::none;
+    // The child is woken once, by the last message of the call.
+    auto send = [&](const RobotMessage& message, bool last) {
+        return wait_on(
+            m_pidfd, deadline, failure,
+            [&] { return m_channel->requests.try_push(message, last); },
+            [&](const timespec* timeout) { m_channel->requests.wait_for_room(timeout); });
+    };
+
+    RobotMessage message;
+    message.kind = MessageKind::call;
+    message.call = call;
+    message.state = state_of(*this);
+    message.count = radar ? radar->size() : 0;
+    bool sent = send(message, message.count == 0);
+
+    for (std::size_t first = 0; sent && radar && first < radar->size(); first += radar_chunk) {
+        message.kind = MessageKind::radar;
+        message.count = std::min<std::size_t>(radar_chunk, radar->size() - first);
+        for (std::uint32_t i = 0; i < message.count; i++) {
+            const RadarObj& object = (*radar)[first + i];
+            message.radar[i].row = object.m_row;
+            message.radar[i].col = object.m_col;
+            message.radar[i].type = object.m_type;
+        }
+        sent = send(message, first + radar_chunk >= radar->size());
+    }
+
+    if (sent && wait_on(
+                    m_pidfd, deadline, failure, [&] { return m_channel->replies.try_pop(reply); },
+                    [&](const timespec* timeout) { m_channel->replies.wait_for_item(timeout); }))
+        return true;
+    fail(failure);
+    return false;
+}
+
+void IsolatedRobot::get_radar_direction(int& radar_direction) {
+    RobotMessage reply;
+    radar_direction = call(RobotCall::get_radar_direction, nullptr, reply) ? reply.out_1 : 0;
+}
+
+void IsolatedRobot::process_radar_results(const std::vector<RadarObj>& radar_results) {
+    RobotMessage reply;
+    call(RobotCall::process_radar_results, &radar_results, reply);
+}
+
+bool IsolatedRobot::get_shot_location(int& shot_row, int& shot_col) {
+    RobotMessage reply;
+    if (!call(RobotCall::get_shot_location, nullptr, reply)) return false;
+    shot_row = reply.out_1;
+    shot_col = reply.out_2;
+    return reply.flag != 0;
+}
+
+void IsolatedRobot::get_move_direction(int& direction, int& distance) {
+    RobotMessage reply;
+    if (call(RobotCall::get_move_direction, nullptr, reply)) {
+        direction = reply.out_1;
+        distance = reply.out_2;
+    } else {
+        direction = 0;
+        distance = 0;
+    }
+}
+
+TurnAction IsolatedRobot::take_turn(const std::vector<RadarObj>& radar_results) {
+    RobotMessage reply;
+    m_call_ns = {};
+    if (!call(RobotCall::take_turn, &radar_results, reply)) return TurnAction();
+    std::copy(reply.call_ns, reply.call_ns + 3, m_call_ns.begin());
+    return reply.action;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+#include "EventSink.h"
+#include "RobotBase.h"
+#include "TurnRobot.h"
+
+struct RobotChannel;
+struct RobotMessage;
+
+// What happened to an isolated robot's process.
+enum class RobotFailure { none, overrun, crashed };
+
+// A robot that lives in a child process of its own, so a crash in its
+// library takes out the robot instead of the arena.
+//
+// launch() has the robot launcher fork a child, which makes the robot with
+// the library's factory and then serves callbacks. The launcher is a
+// process forked from this one while it still has a single thread, so a
+// child never starts out with locks held by threads it doesn't have.
+//
+// The arena only sees this object, a RobotBase like any other: it keeps
+// the authoritative health, armor, location and so on, and every callback
+// sends them along so the child can bring its copy of the robot up to date
+// before calling it. Requests and replies are fixed-size messages in two
+// SharedRings in memory shared with the child; radar results follow a
+// process_radar_results or take_turn request in chunks, and the child is
+// woken once the last of them is in. It is a TurnRobot whatever the robot
+// in the child is (a legacy robot is driven there through LegacyTurns), so
+// the arena needs two round trips a turn rather than four.
+//
+// If the child dies, or (with a call budget) takes too long and is killed,
+// failure() says so and every callback from then on returns at once,
+// asking for nothing: radar direction 0, no shot, no move.
+class IsolatedRobot : public RobotBase, public TurnRobot {
+public:
+    // Starts the robot launcher, if it isn't running yet. Call it before
+    // starting any thread; launch() starts it otherwise, which is only safe
+    // while there is one. Reports problems on std::cerr and returns false.
+    static bool start_launcher();
+
+    // Reports problems on std::cerr and returns nullptr. `factory` has to
+    // be code the launcher has - loaded before it started - or a library's
+    // exported function, which the child loads itself. The child reseeds
+    // std::rand with `rand_seed` once the robot is made, so robots that seed
+    // it from the clock still replay (each with a generator of its own).
+    static std::unique_ptr<IsolatedRobot> launch(RobotFactory factory,
+                                                 std::chrono::microseconds budget,
+                                                 unsigned int rand_seed = 1);
+    ~IsolatedRobot() override;
+
+    IsolatedRobot(const IsolatedRobot&) = delete;
+    IsolatedRobot& operator=(const IsolatedRobot&) = delete;
+
+    // 0: wait as long as the robot takes.
+    void set_budget(std::chrono::microseconds budget) { m_budget = budget; }
+    RobotFailure failure() const { return m_failure; }
+    pid_t pid() const { return m_pid; }
+
+    void get_radar_direction(int& radar_direction) override;
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override;
+    bool get_shot_location(int& shot_row, int& shot_col) override;
+    void get_move_direction(int& direction, int& distance) override;
+    TurnAction take_turn(const std::vector<RadarObj>& radar_results) override;
+
+    // After take_turn, how long a legacy robot spent in each call it stands
+    // for, timed in the child: LegacyTurns::call_ns(). All 0 for a robot
+    // that takes turns itself.
+    const std::array<std::uint64_t, 3>& turn_call_ns() const { return m_call_ns; }
+
+private:
+    IsolatedRobot(int move, int armor, WeaponType weapon, RobotChannel* channel, pid_t pid,
+                  int pidfd);
+
+    RobotChannel* m_channel;
+    pid_t m_pid;
+    int m_pidfd;               // the child is the launcher's; this is how we watch and kill it
+    std::chrono::microseconds m_budget{0};
+    RobotFailure m_failure = RobotFailure::none;
+
+    bool m_gone = false;       // the child has exited, and we know it
+    std::array<std::uint64_t, 3> m_call_ns{};
+
+    bool call(RobotCall call, const std::vector<RadarObj>* radar, RobotMessage& reply);
+    void fail(RobotFailure failure);
+};
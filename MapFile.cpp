@@ -0,0 +1,208 @@
+#include "MapFile.h"
+#include "CellPlanes.h"
+#include "RadarEngine.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const char map_magic[8] = { 'R', 'W', 'Z', 'M', 'A', 'P', '2', '\n' };
+// The magic without its version digit.
+static const std::size_t map_magic_name = 6;
+static const std::uint32_t map_byte_order = 0x01020304;
+static const std::uint64_t section_alignment = 4096;
+// Keeps every offset and size well inside 64 bits and int.
+static const std::uint32_t max_side = 1 << 15;
+
+static std::uint64_t align_up(std::uint64_t n) {
+    return (n + section_alignment - 1) / section_alignment * section_alignment;
+}
+
+// Where everything goes in a map of rows x cols.
+static MapHeader layout(std::uint32_t rows, std::uint32_t cols) {
+    MapHeader header;
+    std::memcpy(header.magic, map_magic, sizeof map_magic);
+    header.byte_order = map_byte_order;
+    header.rows = rows;
+    header.cols = cols;
+    header.reserved = 0;
+
+    std::uint64_t cells = std::uint64_t(rows) * cols;
+    std::uint64_t planes = CellPlanes::obstacle_word_count(rows, cols) * sizeof(std::uint64_t);
+    std::uint64_t radar = RadarEngine::word_count(rows, cols) * sizeof(std::uint64_t);
+    header.cells_offset = align_up(sizeof(MapHeader));
+    header.planes_offset = align_up(header.cells_offset + cells);
+    header.radar_offset = align_up(header.planes_offset + planes);
+    header.file_size = header.radar_offset + radar;
+    header.checksum = 0;
+    return header;
+}
+
+// Four independent lanes so the multiplies overlap. Each step is a
+// bijection of the lane, so a changed word can't be absorbed later on.
+std::uint64_t map_checksum(const std::uint64_t* words, std::size_t count) {
+    const std::uint64_t k = 0x9E3779B97F4A7C15ULL;
+    std::uint64_t lane[4] = { 1, 2, 3, 4 };
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (int j = 0; j < 4; ++j) lane[j] = (lane[j] ^ words[i + j]) * k;
+    }
+    for (; i < count; ++i) lane[0] = (lane[0] ^ words[i]) * k;
+    auto rotate = [](std::uint64_t x, int n) { return (x << n) | (x >> (64 - n)); };
+    return lane[0] ^ rotate(lane[1], 16) ^ rotate(lane[2], 32) ^ rotate(lane[3], 48) ^ count;
+}
+
+// The obstacle planes and radar bitsets for a board of obstacles. False if
+// a cell holds anything but '.', 'M', 'P' or 'F'.
+static bool build_bitsets(const char* cells, int rows, int cols, CellPlanes& planes, RadarEngine& radar) {
+    planes.reset(rows, cols);
+    radar.reset(rows, cols);
+    for (int r = 0; r < rows; ++r) {
+        const char* row = cells + static_cast<std::size_t>(r) * cols;
+        for (int c = 0; c < cols; ++c) {
+            // Most cells are empty: step over them eight at a time.
+            while (c + 8 <= cols) {
+                std::uint64_t eight;
+                std::memcpy(&eight, row + c, sizeof eight);
+                if (eight != 0x2E2E2E2E2E2E2E2EULL) break;
+                c += 8;
+            }
+            if (c == cols) break;
+            switch (row[c]) {
+                case '.': continue;
+                case 'M': planes.set(CellPlanes::mounds, r, c, true); break;
+                case 'P': planes.set(CellPlanes::pits, r, c, true); break;
+                case 'F': planes.set(CellPlanes::flames, r, c, true); break;
+                default: return false;
+            }
+            radar.set(r, c, true);
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<MapFile> MapFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Can't open map " << path << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    struct stat st;
+    MapHeader header;
+    bool ok = fstat(fd, &st) == 0 &&
+              st.st_size >= static_cast<off_t>(sizeof header) &&
+              pread(fd, &header, sizeof header, 0) == static_cast<ssize_t>(sizeof header);
+    if (!ok) {
+        std::cerr << path << " is too short to be a map.\n";
+        close(fd);
+        return nullptr;
+    }
+    if (std::memcmp(header.magic, map_magic, map_magic_name) != 0) {
+        std::cerr << path << " is not a map file.\n";
+        close(fd);
+        return nullptr;
+    }
+    if (std::memcmp(header.magic, map_magic, sizeof map_magic) != 0) {
+        std::cerr << path << " is a map from another version; save it again.\n";
+        close(fd);
+        return nullptr;
+    }
+    if (header.byte_order != map_byte_order) {
+        std::cerr << path << " was written on a machine of the other byte order.\n";
+        close(fd);
+        return nullptr;
+    }
+    if (header.rows == 0 || header.cols == 0 || header.rows > max_side || header.cols > max_side) {
+        std::cerr << path << " has a " << header.rows << "x" << header.cols
+                  << " board; sides go from 1 to " << max_side << ".\n";
+        close(fd);
+        return nullptr;
+    }
+    MapHeader expected = layout(header.rows, header.cols);
+    if (header.cells_offset != expected.cells_offset ||
+        header.planes_offset != expected.planes_offset ||
+        header.radar_offset != expected.radar_offset ||
+        header.file_size != expected.file_size ||
+        static_cast<std::uint64_t>(st.st_size) != expected.file_size) {
+        std::cerr << path << " is damaged: its sections don't add up.\n";
+        close(fd);
+        return nullptr;
+    }
+
+    // Private and writable: the arena writes robots into the radar bitsets,
+    // and those pages get copied instead of changing the file.
+    void* base = mmap(nullptr, expected.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Can't map " << path << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+    std::unique_ptr<MapFile> map(new MapFile(base, expected.file_size, header));
+
+    // The arena plays on the bitsets as they are; the checksum is what
+    // vouches that they are the ones save_map_file worked out.
+    const std::uint64_t* body = map->section<std::uint64_t>(header.cells_offset);
+    if (map_checksum(body, (header.file_size - header.cells_offset) / sizeof(std::uint64_t)) !=
+        header.checksum) {
+        std::cerr << path << " is damaged: its checksum doesn't match.\n";
+        return nullptr;
+    }
+    return map;
+}
+
+MapFile::~MapFile() {
+    munmap(m_base, m_size);
+}
+
+bool save_map_file(const std::string& path, const Grid<char>& board) {
+    if (board.rows() <= 0 || board.cols() <= 0 ||
+        board.rows() > static_cast<int>(max_side) || board.cols() > static_cast<int>(max_side)) {
+        std::cerr << "Can't save a " << board.rows() << "x" << board.cols() << " board as a map.\n";
+        return false;
+    }
+
+    CellPlanes planes;
+    RadarEngine radar;
+    if (!build_bitsets(board.data(), board.rows(), board.cols(), planes, radar)) {
+        std::cerr << "Can't save a board with robots or other marks on it as a map.\n";
+        return false;
+    }
+
+    MapHeader header = layout(static_cast<std::uint32_t>(board.rows()),
+                              static_cast<std::uint32_t>(board.cols()));
+
+    // Everything after the header, sections and padding, laid out in
+    // memory first so it can be checksummed before the header is written.
+    std::vector<std::uint64_t> body((header.file_size - header.cells_offset) / sizeof(std::uint64_t));
+    char* bytes = reinterpret_cast<char*>(body.data());
+    std::memcpy(bytes, board.data(), board.size());
+    std::memcpy(bytes + (header.planes_offset - header.cells_offset), planes.obstacle_words(),
+                planes.obstacle_word_count() * sizeof(std::uint64_t));
+    std::memcpy(bytes + (header.radar_offset - header.cells_offset), radar.words(),
+                radar.word_count() * sizeof(std::uint64_t));
+    header.checksum = map_checksum(body.data(), body.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Can't write map " << path << ".\n";
+        return false;
+    }
+    static const char zeros[section_alignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+    out.write(zeros, static_cast<std::streamsize>(header.cells_offset - sizeof header));
+    out.write(bytes, static_cast<std::streamsize>(body.size() * sizeof(std::uint64_t)));
+
+    out.close();
+    if (!out) {
+        std::cerr << "Writing map " << path << " failed.\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Grid.h"
+
+// Binary arena maps, made to be mapped into memory and played on as they
+// are, with nothing to parse however big the board.
+//
+// After a fixed header come three sections, each starting on a page
+// boundary: the cells (rows * cols chars, row by row, as Arena's board
+// holds them), the mound, pit and flame bitsets (CellPlanes' obstacle
+// planes) and the radar bitsets (RadarEngine's words) for those obstacles.
+// The header carries a checksum of everything after it, so a damaged file
+// is caught without working the bitsets out again. Numbers are in the byte
+// order of the machine that wrote the file; a file from the other byte
+// order is turned down.
+struct MapHeader {
+    char magic[8];                 // "RWZMAP2\n"; the digit is the version
+    std::uint32_t byte_order;      // 0x01020304 as the writer saw it
+    std::uint32_t rows;
+    std::uint32_t cols;
+    std::uint32_t reserved;
+    std::uint64_t cells_offset;
+    std::uint64_t planes_offset;
+    std::uint64_t radar_offset;
+    std::uint64_t file_size;
+    std::uint64_t checksum;        // map_checksum of bytes cells_offset to file_size
+};
+
+// A map file mapped into memory. The mapping is private: writes to it (a
+// robot moving on the radar bitsets, say) stay in this process and never
+// reach the file.
+class MapFile {
+public:
+    // Turns down files whose header doesn't match their size or whose
+    // checksum doesn't match their contents. Reports problems on std::cerr
+    // and returns nullptr.
+    static std::unique_ptr<MapFile> open(const std::string& path);
+    ~MapFile();
+
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+
+    int rows() const { return static_cast<int>(m_header.rows); }
+    int cols() const { return static_cast<int>(m_header.cols); }
+
+    char* cells() { return section<char>(m_header.cells_offset); }
+    std::uint64_t* obstacle_words() { return section<std::uint64_t>(m_header.planes_offset); }
+    std::uint64_t* radar_words() { return section<std::uint64_t>(m_header.radar_offset); }
+
+private:
+    MapFile(void* base, std::size_t size, const MapHeader& header)
+        : m_base(base), m_size(size), m_header(header) {}
+
+    void* m_base;
+    std::size_t m_size;
+    MapHeader m_header;
+
+    template <typename T>
+    T* section(std::uint64_t offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(m_base) + offset);
+    }
+};
+
+// A checksum of `count` words, for catching damaged maps: any one word
+// changed changes it. Several gigabytes a second.
+std::uint64_t map_checksum(const std::uint64_t* words, std::size_t count);
+
+// Writes `board` (obstacles only: '.', 'M', 'P' or 'F' per cell) as a map
+// file, with its bitsets worked out from the cells. Reports problems on
+// std::cerr and returns false.
+bool save_map_file(const std::string& path, const Grid<char>& board);
@@ -0,0 +1,128 @@
+#include "PhaseTimes.h"
+#include "Arena.h"
+
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+const char* phase_name(Phase phase) {
+    switch (phase) {
+        case Phase::get_radar_direction:   return "get_radar_direction";
+        case Phase::radar_scan:            return "radar scan";
+        case Phase::process_radar_results: return "process_radar_results";
+        case Phase::get_shot_location:     return "get_shot_location";
+        case Phase::get_move_direction:    return "get_move_direction";
+        case Phase::take_turn:             return "take_turn";
+        case Phase::shot:                  return "shot";
+        case Phase::movement:              return "movement";
+        case Phase::board_update:          return "board update";
+        case Phase::output:                return "output";
+        case Phase::count:                 break;
+    }
+    return "unknown";
+}
+
+int DurationHistogram::bucket(std::uint64_t ns) {
+    if (ns < 16) return static_cast<int>(ns);
+    int exponent = std::bit_width(ns) - 1;
+    int sub = static_cast<int>((ns >> (exponent - 3)) & 7);
+    return 16 + (exponent - 4) * 8 + sub;
+}
+
+std::uint64_t DurationHistogram::bucket_top(int bucket) {
+    if (bucket < 16) return static_cast<std::uint64_t>(bucket);
+    int exponent = (bucket - 16) / 8 + 4;
+    std::uint64_t sub = static_cast<std::uint64_t>((bucket - 16) % 8);
+    std::uint64_t width = std::uint64_t{1} << (exponent - 3);
+    return (8 + sub) * width + width - 1;
+}
+
+void DurationHistogram::add(std::uint64_t ns) {
+    std::size_t b = static_cast<std::size_t>(bucket(ns));
+    if (b >= m_buckets.size()) m_buckets.resize(b + 1, 0);
+    m_buckets[b]++;
+    m_count++;
+    m_total += ns;
+    if (ns > m_max) m_max = ns;
+}
+
+std::uint64_t DurationHistogram::percentile(double fraction) const {
+    if (m_count == 0) return 0;
+    // Rounded up, so p99 of fewer than 100 samples is the largest.
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(m_count)));
+    if (rank < 1) rank = 1;
+    if (rank > m_count) rank = m_count;
+
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < m_buckets.size(); ++b) {
+        seen += m_buckets[b];
+        if (seen >= rank) {
+            std::uint64_t top = bucket_top(static_cast<int>(b));
+            return top < m_max ? top : m_max;
+        }
+    }
+    return m_max;
+}
+
+void DurationHistogram::merge(const DurationHistogram& other) {
+    if (other.m_buckets.size() > m_buckets.size()) m_buckets.resize(other.m_buckets.size(), 0);
+    for (std::size_t b = 0; b < other.m_buckets.size(); ++b) m_buckets[b] += other.m_buckets[b];
+    m_count += other.m_count;
+    m_total += other.m_total;
+    if (other.m_max > m_max) m_max = other.m_max;
+}
+
+void PhaseTimes::record(int robot, Phase phase, std::uint64_t ns) {
+    std::size_t slot = static_cast<std::size_t>(robot + 1);
+    if (slot >= m_robots.size()) m_robots.resize(slot + 1);
+    m_robots[slot][static_cast<std::size_t>(phase)].add(ns);
+}
+
+const DurationHistogram& PhaseTimes::of(int robot, Phase phase) const {
+    static const DurationHistogram empty;
+    std::size_t slot = static_cast<std::size_t>(robot + 1);
+    if (slot >= m_robots.size()) return empty;
+    return m_robots[slot][static_cast<std::size_t>(phase)];
+}
+
+void PhaseTimes::print(std::ostream& out, const std::vector<RobotInfo>& robots) const {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    auto row = [&](const std::string& who, Phase phase, const DurationHistogram& h) {
+        out << "  " << std::left << std::setw(20) << who.substr(0, 19)
+            << std::setw(23) << phase_name(phase) << std::right
+            << std::setw(9) << h.count()
+            << std::setw(12) << std::fixed << std::setprecision(3) << h.total() / 1e6
+            << std::setw(11) << std::setprecision(2) << h.mean() / 1e3
+            << std::setw(11) << h.percentile(0.99) / 1e3 << "\n";
+    };
+
+    out << "\nPhase timing:\n"
+        << "  " << std::left << std::setw(20) << "robot" << std::setw(23) << "phase" << std::right
+        << std::setw(9) << "calls" << std::setw(12) << "total ms"
+        << std::setw(11) << "mean us" << std::setw(11) << "p99 us" << "\n";
+
+    const int phases = static_cast<int>(Phase::count);
+    for (int robot = -1; robot < static_cast<int>(robots.size()); ++robot) {
+        std::string who = "(arena)";
+        if (robot >= 0) {
+            who = robots[robot].robot->m_name + " " + robots[robot].symbol;
+        }
+        for (int p = 0; p < phases; ++p) {
+            const DurationHistogram& h = of(robot, static_cast<Phase>(p));
+            if (h.count() > 0) row(who, static_cast<Phase>(p), h);
+        }
+    }
+
+    for (int p = 0; p < phases; ++p) {
+        DurationHistogram all;
+        for (int robot = 0; robot < static_cast<int>(robots.size()); ++robot) {
+            all.merge(of(robot, static_cast<Phase>(p)));
+        }
+        if (all.count() > 0) row("all robots", static_cast<Phase>(p), all);
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+struct RobotInfo;
+
+// The parts of a game the arena can time. A turn runs them in this order
+// (shot or movement, not both); output is the event sink's share of the turn.
+enum class Phase : std::uint8_t {
+    get_radar_direction,
+    radar_scan,
+    process_radar_results,
+    get_shot_location,
+    get_move_direction,
+    take_turn,
+    shot,
+    movement,
+    board_update,
+    output,
+    count
+};
+
+const char* phase_name(Phase phase);
+
+// Durations in nanoseconds, bucketed: exact below 16 ns, then eight
+// buckets per power of two, so a percentile read back is at most 12.5% high.
+// Buckets are only allocated up to the largest duration seen.
+class DurationHistogram {
+public:
+    void add(std::uint64_t ns);
+
+    std::uint64_t count() const { return m_count; }
+    std::uint64_t total() const { return m_total; }
+    std::uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? static_cast<double>(m_total) / m_count : 0.0; }
+    // The duration that `fraction` of the samples are at or under.
+    std::uint64_t percentile(double fraction) const;
+
+    void merge(const DurationHistogram& other);
+
+    static int bucket(std::uint64_t ns);
+    static std::uint64_t bucket_top(int bucket);
+
+private:
+    std::vector<std::uint32_t> m_buckets;
+    std::uint64_t m_count = 0;
+    std::uint64_t m_total = 0;
+    std::uint64_t m_max = 0;
+};
+
+// Time spent in each phase, per robot. Robot -1 is the arena itself: the
+// board printed at the start of every round.
+class PhaseTimes {
+public:
+    static std::uint64_t now() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void record(int robot, Phase phase, std::uint64_t ns);
+
+    // Records the time since `start` and returns now, the start of the next
+    // phase.
+    std::uint64_t lap(int robot, Phase phase, std::uint64_t start) {
+        std::uint64_t end = now();
+        record(robot, phase, end - start);
+        return end;
+    }
+
+    // An empty histogram for robots or phases never recorded.
+    const DurationHistogram& of(int robot, Phase phase) const;
+
+    // One line per robot and phase that ran, then each phase over all
+    // robots: calls, total, mean and p99.
+    void print(std::ostream& out, const std::vector<RobotInfo>& robots) const;
+
+private:
+    using PerPhase = std::array<DurationHistogram, static_cast<std::size_t>(Phase::count)>;
+    std::vector<PerPhase> m_robots;   // robot + 1
+};
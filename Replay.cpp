@@ -0,0 +1,490 @@
+#include "Replay.h"
+#include "Arena.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+// Records are gathered until this much is waiting, then written in one go.
+static const std::size_t flush_size = 64 * 1024;
+
+// The most an event record can take: kind, length and up to 4 ten-byte
+// varints. Anything under 128 bytes has a one-byte length varint.
+static const std::size_t record_max = 2 + 4 * 10;
+
+static unsigned char* write_varint(unsigned char* out, std::uint64_t value) {
+    if (value < 0x80) {   // nearly every value in a record
+        *out = static_cast<unsigned char>(value);
+        return out + 1;
+    }
+    while (value >= 0x80) {
+        *out++ = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(value);
+    return out;
+}
+
+ReplayRecorder::ReplayRecorder(int keyframe_every)
+    : m_buffer(flush_size + record_max, '\0'), m_keyframe_every(keyframe_every) {
+    m_out = begin_of_buffer();
+    m_flush_at = m_out + flush_size;
+}
+
+bool ReplayRecorder::open(const std::string& path) {
+    close();
+    if (!m_writer.open(path)) return false;
+    m_out = begin_of_buffer();
+    m_written = 0;
+    return true;
+}
+
+void ReplayRecorder::begin(const Arena& arena) {
+    const std::vector<RobotInfo>& robots = arena.robot_infos();
+    m_roster = robots.data();
+
+    put_bytes(replay_magic, sizeof(replay_magic));
+    put_byte(replay_version);
+    put_varint(arena.board_rows());
+    put_varint(arena.board_cols());
+    put_varint(arena.round_limit());
+    std::uint64_t seed = arena.seed();
+    for (int i = 0; i < 8; ++i) {
+        put_byte(static_cast<unsigned char>(seed >> (8 * i)));
+    }
+
+    put_varint(robots.size());
+    for (const RobotInfo& info : robots) {
+        RobotBase* robot = info.robot;
+        put_varint(robot->m_name.size());
+        put_bytes(robot->m_name.data(), robot->m_name.size());
+        put_byte(static_cast<unsigned char>(info.symbol));
+        put_varint(info.row);
+        put_varint(info.col);
+        put_varint(robot->get_health());
+        put_varint(robot->get_armor());
+        put_varint(robot->get_move_speed());
+        put_varint(robot->get_weapon());
+    }
+
+    int obstacles = 0;
+    for (int r = 0; r < arena.board_rows(); ++r) {
+        for (int c = 0; c < arena.board_cols(); ++c) {
+            obstacles += (arena.obstacle_at(r, c) != '.');
+        }
+    }
+    put_varint(obstacles);
+    for (int r = 0; r < arena.board_rows(); ++r) {
+        for (int c = 0; c < arena.board_cols(); ++c) {
+            char cell = arena.obstacle_at(r, c);
+            if (cell == '.') continue;
+            put_varint(r);
+            put_varint(c);
+            put_byte(static_cast<unsigned char>(cell));
+        }
+    }
+}
+
+void ReplayRecorder::close() {
+    if (!m_writer.is_open()) return;
+    flush();
+    m_writer.close();
+}
+
+// The header and keyframes go through these a byte or field at a time.
+void ReplayRecorder::put_varint(std::uint64_t value) {
+    m_out = write_varint(m_out, value);
+    flush_if_full();
+}
+
+void ReplayRecorder::put_byte(unsigned char value) {
+    *m_out++ = value;
+    flush_if_full();
+}
+
+void ReplayRecorder::put_bytes(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    while (size > 0) {
+        std::size_t chunk = std::min<std::size_t>(size, m_flush_at - m_out);
+        std::memcpy(m_out, bytes, chunk);
+        m_out += chunk;
+        bytes += chunk;
+        size -= chunk;
+        flush_if_full();
+    }
+}
+
+// A record with a value of 128 or more, written as varints; the length
+// goes in front once they are.
+void ReplayRecorder::add_wide(ReplayRecord kind, std::uint8_t count, std::uint32_t a,
+                              std::uint32_t b, std::uint32_t c, std::uint32_t d) {
+    const std::uint32_t values[4] = { a, b, c, d };
+    unsigned char* start = m_out;
+    unsigned char* out = start + 2;
+    for (std::uint8_t v = 0; v < count; ++v) out = write_varint(out, values[v]);
+    start[0] = static_cast<unsigned char>(kind);
+    start[1] = static_cast<unsigned char>(out - start - 2);
+    m_out = out;
+    flush_if_full();
+}
+
+// There is always room for one more record after this. Without an open
+// file, records are simply dropped.
+void ReplayRecorder::flush_if_full() {
+    if (m_out >= m_flush_at) flush();
+}
+
+// Hands the whole buffer to the writer thread and takes an empty one back;
+// the disk is never waited for here unless the writer is far behind.
+void ReplayRecorder::flush() {
+    std::size_t used = m_out - begin_of_buffer();
+    if (used > 0 && m_writer.is_open()) {
+        m_writer.swap_out(m_buffer, used);
+        m_written += used;
+    }
+    m_out = begin_of_buffer();
+    m_flush_at = m_out + flush_size;
+}
+
+void ReplayRecorder::round_start(const Arena& arena, int round) {
+    add(ReplayRecord::round, 1, static_cast<std::uint32_t>(round));
+    if (m_keyframe_every > 0 && round > 0 && round % m_keyframe_every == 0) {
+        keyframe(arena, round);
+    }
+}
+
+// Built on the side first, since its length goes in front of it, into
+// room for the longest one; then copied into the buffer.
+void ReplayRecorder::keyframe(const Arena& arena, int round) {
+    const std::vector<RobotInfo>& robots = arena.robot_infos();
+    std::size_t longest = 10 * (1 + 6 * robots.size());
+    if (m_keyframe.size() < longest) m_keyframe.resize(longest);
+    unsigned char* out = write_varint(m_keyframe.data(), static_cast<std::uint64_t>(round));
+    for (const RobotInfo& info : robots) {
+        out = write_varint(out, static_cast<std::uint64_t>(info.row));
+        out = write_varint(out, static_cast<std::uint64_t>(info.col));
+        out = write_varint(out, static_cast<std::uint64_t>(info.robot->get_health()));
+        out = write_varint(out, static_cast<std::uint64_t>(info.robot->get_armor()));
+        out = write_varint(out, static_cast<std::uint64_t>(info.robot->get_move_speed()));
+        *out++ = info.alive ? 1 : 0;
+    }
+    std::size_t size = out - m_keyframe.data();
+    put_byte(static_cast<unsigned char>(ReplayRecord::keyframe));
+    put_varint(size);
+    put_bytes(m_keyframe.data(), size);
+}
+
+void ReplayRecorder::game_over(GameResult result, const RobotInfo* winner) {
+    add(ReplayRecord::game_over, 2, static_cast<std::uint32_t>(result),
+        winner ? robot_id(*winner) + 1 : 0);
+    flush();
+}
+
+// Reads a loaded file. Reading past the end gives zeros and clears ok.
+struct ReplayCursor {
+    const unsigned char* data;
+    std::size_t pos;
+    std::size_t end;
+    bool ok = true;
+
+    unsigned byte() {
+        if (pos >= end) {
+            ok = false;
+            return 0;
+        }
+        return data[pos++];
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            unsigned b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        ok = false;
+        return value;
+    }
+
+    // Board coordinates, stats and counts; anything bigger is damage.
+    int number() {
+        std::uint64_t value = varint();
+        if (value > 1000000000) ok = false;
+        return static_cast<int>(value);
+    }
+};
+
+// Stands in for a recorded robot: it has the robot's name and stats and
+// never does anything.
+class ReplayRobot : public RobotBase {
+public:
+    ReplayRobot(const std::string& name, char symbol, int move, int armor, WeaponType weapon)
+        : RobotBase(move, armor, weapon) {
+        m_name = name;
+        m_character = symbol;
+    }
+
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+    void process_radar_results(const std::vector<RadarObj>&) override {}
+    bool get_shot_location(int&, int&) override { return false; }
+    void get_move_direction(int& direction, int& distance) override {
+        direction = 0;
+        distance = 0;
+    }
+};
+
+ReplayPlayer::ReplayPlayer() = default;
+ReplayPlayer::~ReplayPlayer() = default;
+
+bool ReplayPlayer::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open replay file " << path << ".\n";
+        return false;
+    }
+    m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    ReplayCursor file{ m_data.data(), 0, m_data.size() };
+    bool magic = true;
+    for (char m : replay_magic) magic &= (file.byte() == static_cast<unsigned char>(m));
+    if (!magic) {
+        std::cerr << path << " is not a replay file.\n";
+        return false;
+    }
+    unsigned version = file.byte();
+    if (version != replay_version) {
+        std::cerr << path << " is a version " << version << " replay; this build reads version "
+                  << static_cast<unsigned>(replay_version) << ".\n";
+        return false;
+    }
+
+    m_rows = file.number();
+    m_cols = file.number();
+    file.varint();                      // max rounds
+    for (int i = 0; i < 8; ++i) file.byte();   // seed
+    bool header_ok = m_rows > 0 && m_cols > 0;
+    auto on_board = [&](int r, int c) { return r >= 0 && r < m_rows && c >= 0 && c < m_cols; };
+
+    m_roster.assign(static_cast<std::size_t>(file.number()), RosterEntry());
+    for (RosterEntry& entry : m_roster) {
+        for (int n = file.number(); n > 0 && file.ok; --n) {
+            entry.name += static_cast<char>(file.byte());
+        }
+        entry.symbol = static_cast<char>(file.byte());
+        entry.start.row = file.number();
+        entry.start.col = file.number();
+        entry.start.health = file.number();
+        entry.start.armor = file.number();
+        entry.start.move = file.number();
+        entry.weapon = file.number();
+        header_ok &= on_board(entry.start.row, entry.start.col) && entry.weapon <= hammer;
+    }
+
+    m_obstacle_cells.clear();
+    m_obstacle_types.clear();
+    for (int n = file.number(); n > 0 && file.ok; --n) {
+        int r = file.number();
+        int c = file.number();
+        char type = static_cast<char>(file.byte());
+        header_ok &= on_board(r, c);
+        m_obstacle_cells.emplace_back(r, c);
+        m_obstacle_types.push_back(type);
+    }
+
+    if (!file.ok || !header_ok) {
+        std::cerr << path << " has a damaged header.\n";
+        return false;
+    }
+
+    // Index the rounds and keyframes; the events are only read by seek().
+    m_records_at = file.pos;
+    m_round_at.clear();
+    m_keyframes.clear();
+    m_result = GameResult::none;
+    m_winner = -1;
+    m_end = m_data.size();
+    std::vector<RobotState> states;
+    while (file.pos < file.end) {
+        std::size_t at = file.pos;
+        unsigned kind = file.byte();
+        std::uint64_t length = file.varint();
+        if (!file.ok || length > file.end - file.pos) {
+            std::cerr << path << " ends in the middle of a record; showing the game up to there.\n";
+            file.pos = at;
+            break;
+        }
+        ReplayCursor payload{ m_data.data(), file.pos, file.pos + length };
+        if (kind == static_cast<unsigned>(ReplayRecord::round)) {
+            m_round_at.push_back(at);
+        } else if (kind == static_cast<unsigned>(ReplayRecord::keyframe)) {
+            if (read_keyframe(at, states)) {
+                m_keyframes.push_back({ static_cast<int>(m_round_at.size()) - 1, at });
+            }
+        } else if (kind == static_cast<unsigned>(ReplayRecord::game_over)) {
+            m_result = static_cast<GameResult>(payload.number());
+            m_winner = payload.number() - 1;
+        }
+        file.pos += length;
+    }
+    m_end = file.pos;
+    if (m_result == GameResult::winner && winner() == nullptr) m_result = GameResult::none;
+
+    m_arena.reset();
+    seek(0);
+    return true;
+}
+
+// A keyframe written for the roster we have, with every robot on the board.
+bool ReplayPlayer::read_keyframe(std::size_t at, std::vector<RobotState>& states) const {
+    ReplayCursor record{ m_data.data(), at, m_end };
+    record.byte();
+    std::uint64_t length = record.varint();
+    ReplayCursor payload{ m_data.data(), record.pos, record.pos + length };
+    payload.number();   // round; where the record sits says the same
+
+    states.assign(m_roster.size(), RobotState());
+    for (RobotState& state : states) {
+        state.row = payload.number();
+        state.col = payload.number();
+        state.health = payload.number();
+        state.armor = payload.number();
+        state.move = payload.number();
+        state.alive = payload.number() != 0;
+        if (state.row >= m_rows || state.col >= m_cols) return false;
+    }
+    return payload.ok;
+}
+
+void ReplayPlayer::seek(int round) {
+    round = std::clamp(round, 0, rounds());
+    std::size_t to = round < rounds() ? m_round_at[round] : m_end;
+
+    auto later = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), round,
+                                  [](int r, const Keyframe& k) { return r < k.round; });
+    const Keyframe* key = later == m_keyframes.begin() ? nullptr : &*(later - 1);
+    int key_round = key ? key->round : 0;
+
+    // Stepping forward carries on from the board we have, unless a keyframe
+    // gets closer.
+    if (!m_arena || m_round > round || m_round < key_round) {
+        std::vector<RobotState> states;
+        if (key) {
+            read_keyframe(key->at, states);
+            ReplayCursor record{ m_data.data(), key->at, m_end };
+            record.byte();
+            std::uint64_t length = record.varint();
+            m_pos = record.pos + length;
+        } else {
+            for (const RosterEntry& entry : m_roster) states.push_back(entry.start);
+            m_pos = m_records_at;
+        }
+        rebuild(states);
+        m_applying_round = key_round;
+    }
+
+    apply(to);
+    m_round = round;
+}
+
+void ReplayPlayer::rebuild(const std::vector<RobotState>& states) {
+    m_arena = std::make_unique<Arena>(m_rows, m_cols);
+    m_arena->set_event_sink(nullptr);
+    m_arena->set_watch_live(m_clear_screen);
+
+    for (std::size_t i = 0; i < m_obstacle_cells.size(); ++i) {
+        auto [r, c] = m_obstacle_cells[i];
+        m_arena->board(r, c) = m_obstacle_types[i];
+        m_arena->update_cell(r, c);
+    }
+
+    m_robots.clear();
+    for (std::size_t i = 0; i < m_roster.size(); ++i) {
+        const RosterEntry& entry = m_roster[i];
+        const RobotState& state = states[i];
+        auto robot = std::make_unique<ReplayRobot>(entry.name, entry.symbol, entry.start.move,
+                                                   entry.start.armor,
+                                                   static_cast<WeaponType>(entry.weapon));
+        robot->take_damage(robot->get_health() - state.health);
+        robot->reduce_armor(robot->get_armor() - state.armor);
+        if (state.move == 0) robot->disable_movement();
+
+        m_arena->add_robot(robot.get(), state.row, state.col);
+        if (!state.alive) m_arena->mark_dead(m_arena->robots.back());
+        m_robots.push_back(std::move(robot));
+    }
+}
+
+// Applies the records from m_pos up to the one starting at `to`.
+void ReplayPlayer::apply(std::size_t to) {
+    std::vector<RobotInfo>& robots = m_arena->robots;
+    auto robot_at = [&](ReplayCursor& payload) -> RobotInfo* {
+        std::uint64_t id = payload.varint();
+        return id < robots.size() ? &robots[id] : nullptr;
+    };
+    auto place = [&](RobotInfo& info, int r, int c) {
+        if (m_arena->in_bounds(r, c) && (r != info.row || c != info.col)) {
+            m_arena->move_robot(info, r, c);
+        }
+    };
+
+    while (m_pos < to) {
+        ReplayCursor record{ m_data.data(), m_pos, m_end };
+        unsigned kind = record.byte();
+        std::uint64_t length = record.varint();
+        ReplayCursor payload{ m_data.data(), record.pos, record.pos + length };
+        m_pos = record.pos + length;
+        m_applied++;
+
+        switch (static_cast<ReplayRecord>(kind)) {
+            case ReplayRecord::round:
+                m_applying_round = payload.number();
+                break;
+            case ReplayRecord::move:
+                if (RobotInfo* info = robot_at(payload)) {
+                    int r = payload.number();
+                    int c = payload.number();
+                    place(*info, r, c);
+                }
+                break;
+            case ReplayRecord::hazard:
+                if (RobotInfo* info = robot_at(payload)) {
+                    char cell = static_cast<char>(payload.number());
+                    int r = payload.number();
+                    int c = payload.number();
+                    place(*info, r, c);
+                    if (cell == 'P') info->robot->disable_movement();
+                }
+                break;
+            case ReplayRecord::damage:
+                if (RobotInfo* info = robot_at(payload)) {
+                    payload.number();   // amount
+                    int after = payload.number();
+                    info->robot->reduce_armor(1);
+                    info->robot->take_damage(info->robot->get_health() - after);
+                }
+                break;
+            case ReplayRecord::death:
+                if (RobotInfo* info = robot_at(payload)) {
+                    info->died_in_round = m_applying_round;
+                    m_arena->mark_dead(*info);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void ReplayPlayer::print() const {
+    m_arena->print_board(m_round);
+}
+
+void ReplayPlayer::set_clear_screen(bool v) {
+    m_clear_screen = v;
+    if (m_arena) m_arena->set_watch_live(v);
+}
+
+const RobotInfo* ReplayPlayer::winner() const {
+    if (!m_arena || m_winner < 0 || m_winner >= static_cast<int>(m_roster.size())) return nullptr;
+    return &m_arena->robot_infos()[m_winner];
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arena.h"
+#include "BackgroundWriter.h"
+
+// Binary replay files.
+//
+// Every number is an unsigned LEB128 varint (7 bits per byte, high bit set
+// on all but the last byte) unless noted. The file starts with a header:
+//
+//   "RWRP" version(1 byte)
+//   rows cols max_rounds seed(8 bytes, little-endian)
+//   robot count, then for each robot:
+//       name length, name bytes, symbol(1 byte), row, col,
+//       health, armor, move, weapon
+//   obstacle count, then for each obstacle: row, col, type(1 byte: M, P, F)
+//
+// followed by one record per game event:
+//
+//   kind(1 byte) payload length payload(varints)
+//
+// Robots are numbered in roster order. Event payloads are a few varints,
+// so their length is a single byte; keyframes can be longer. A reader can
+// skip kinds it doesn't know by their length.
+enum class ReplayRecord : std::uint8_t {
+    round = 1,       // round
+    radar,           // robot, direction, objects found; starts the robot's turn
+    move,            // robot, row, col (where the move ended)
+    move_rejected,   // robot, MoveProblem
+    hazard,          // robot, cell, row, col
+    shot,            // robot, weapon, row, col
+    shot_rejected,   // robot, ShotProblem
+    damage,          // robot, amount, health after (clamped at 0)
+    death,           // robot
+    game_over,       // GameResult, winner + 1 (0 for none)
+    keyframe,        // round, then per robot: row, col, health, armor, move, alive
+};
+
+constexpr char replay_magic[4] = { 'R', 'W', 'R', 'P' };
+constexpr std::uint8_t replay_version = 2;
+
+// Writes a game to a replay file as it is played. Hand it to the arena with
+// set_replay_recorder(), call begin() once the robots are placed, and run
+// the game.
+//
+// The arena calls the recorder directly, not through a virtual sink. Each
+// call writes its record straight into a 64 KB buffer, which is handed
+// whole to a BackgroundWriter thread when full, without being copied.
+//
+// Every keyframe_every rounds (0 for never) the state of every robot is
+// written right after the round record, so a player can start there
+// instead of at the beginning of the game.
+class ReplayRecorder {
+public:
+    explicit ReplayRecorder(int keyframe_every = 32);
+    ~ReplayRecorder() { close(); }
+
+    // Reports problems on std::cerr and returns false.
+    bool open(const std::string& path);
+
+    // Writes the header: size, seed, robots and obstacles as they are now.
+    void begin(const Arena& arena);
+
+    // Writes out whatever is still buffered and closes the file.
+    void close();
+
+    // Bytes encoded so far; every byte once closed.
+    std::uint64_t bytes_written() const { return m_written + (m_out - begin_of_buffer()); }
+
+    // The game as the arena plays it.
+    void round_start(const Arena& arena, int round);
+    void radar(const RobotInfo& info, int radar_dir, std::size_t found) {
+        add(ReplayRecord::radar, 3, robot_id(info), radar_dir, static_cast<std::uint32_t>(found));
+    }
+    void move_rejected(const RobotInfo& info, MoveProblem problem) {
+        add(ReplayRecord::move_rejected, 2, robot_id(info), static_cast<std::uint32_t>(problem));
+    }
+    void move_hazard(const RobotInfo& info, char cell, int row, int col) {
+        add(ReplayRecord::hazard, 4, robot_id(info), static_cast<unsigned char>(cell), row, col);
+    }
+    void move_end(const RobotInfo& info) {
+        add(ReplayRecord::move, 3, robot_id(info), info.row, info.col);
+    }
+    void shot(const RobotInfo& info, WeaponType weapon, int row, int col) {
+        add(ReplayRecord::shot, 4, robot_id(info), weapon, row, col);
+    }
+    void shot_rejected(const RobotInfo& info, ShotProblem problem) {
+        add(ReplayRecord::shot_rejected, 2, robot_id(info), static_cast<std::uint32_t>(problem));
+    }
+    void damage(const RobotInfo& info, int amount, int health_after) {
+        add(ReplayRecord::damage, 3, robot_id(info), amount, health_after);
+    }
+    void death(const RobotInfo& info) { add(ReplayRecord::death, 1, robot_id(info)); }
+    void game_over(GameResult result, const RobotInfo* winner);
+
+private:
+    BackgroundWriter m_writer;
+    std::string m_buffer;                  // fixed size; the bytes before m_out are waiting
+    unsigned char* m_out;
+    unsigned char* m_flush_at;             // past this, the buffer goes to the writer
+    std::uint64_t m_written = 0;
+    int m_keyframe_every;
+    const RobotInfo* m_roster = nullptr;   // the arena's robots, for numbering
+    std::vector<unsigned char> m_keyframe; // payload of the keyframe being written
+
+    std::uint32_t robot_id(const RobotInfo& info) const {
+        return static_cast<std::uint32_t>(&info - m_roster);
+    }
+    unsigned char* begin_of_buffer() { return reinterpret_cast<unsigned char*>(m_buffer.data()); }
+    const unsigned char* begin_of_buffer() const {
+        return reinterpret_cast<const unsigned char*>(m_buffer.data());
+    }
+
+    // A record of `count` values. Nearly every value is under 128, a
+    // one-byte varint, and then the record is six byte stores at fixed
+    // places (the buffer has room past its end for the unused ones);
+    // anything bigger takes the out-of-line path.
+    void add(ReplayRecord kind, std::uint8_t count, std::uint32_t a, std::uint32_t b = 0,
+             std::uint32_t c = 0, std::uint32_t d = 0) {
+        if ((a | b | c | d) >= 0x80) {
+            add_wide(kind, count, a, b, c, d);
+            return;
+        }
+        unsigned char* out = m_out;
+        out[0] = static_cast<unsigned char>(kind);
+        out[1] = count;
+        out[2] = static_cast<unsigned char>(a);
+        out[3] = static_cast<unsigned char>(b);
+        out[4] = static_cast<unsigned char>(c);
+        out[5] = static_cast<unsigned char>(d);
+        m_out = out + 2 + count;
+        if (m_out >= m_flush_at) flush();
+    }
+    void add_wide(ReplayRecord kind, std::uint8_t count, std::uint32_t a, std::uint32_t b,
+                  std::uint32_t c, std::uint32_t d);
+    void put_varint(std::uint64_t value);
+    void put_byte(unsigned char value);
+    void put_bytes(const void* data, std::size_t size);
+    void keyframe(const Arena& arena, int round);
+    void flush_if_full();
+    void flush();
+};
+
+// Shows a recorded game at any round without running the robots.
+//
+// load() reads the whole file and notes where every round and keyframe
+// starts. seek() rebuilds the board from the last keyframe at or before the
+// round (or from the header) and applies the recorded moves, damage and
+// deaths from there; stepping forward just carries on from where the last
+// seek stopped. The board lives in an Arena, so print() is the arena's own
+// print_board.
+class ReplayPlayer {
+public:
+    ReplayPlayer();
+    ~ReplayPlayer();
+
+    // Reports problems on std::cerr and returns false. A file that ends in
+    // the middle of a record (a game that crashed) loads up to that point.
+    bool load(const std::string& path);
+
+    // Rounds recorded. seek(rounds()) shows the board after the last one.
+    int rounds() const { return static_cast<int>(m_round_at.size()); }
+    int round() const { return m_round; }
+
+    // The board at the start of a round; out of range rounds are clamped.
+    void seek(int round);
+
+    void print() const;
+    // Clear the terminal before each print, like --manual does.
+    void set_clear_screen(bool v);
+
+    const Arena& arena() const { return *m_arena; }
+    // How the game ended (none if the file stops before the end).
+    GameResult result() const { return m_result; }
+    const RobotInfo* winner() const;
+    std::size_t keyframes() const { return m_keyframes.size(); }
+    // Records walked by seeks so far.
+    std::uint64_t records_applied() const { return m_applied; }
+
+private:
+    struct RobotState {
+        int row = 0;
+        int col = 0;
+        int health = 0;
+        int armor = 0;
+        int move = 0;
+        bool alive = true;
+    };
+
+    struct RosterEntry {
+        std::string name;
+        char symbol = '?';
+        int weapon = 0;
+        RobotState start;
+    };
+
+    struct Keyframe {
+        int round;
+        std::size_t at;   // offset of the keyframe record
+    };
+
+    std::vector<unsigned char> m_data;
+    int m_rows = 0;
+    int m_cols = 0;
+    std::vector<RosterEntry> m_roster;
+    std::vector<std::pair<int, int>> m_obstacle_cells;
+    std::vector<char> m_obstacle_types;
+    std::size_t m_records_at = 0;           // first record after the header
+    std::size_t m_end = 0;                  // end of the last complete record
+    std::vector<std::size_t> m_round_at;    // offset of each round record
+    std::vector<Keyframe> m_keyframes;
+    GameResult m_result = GameResult::none;
+    int m_winner = -1;
+
+    std::unique_ptr<Arena> m_arena;
+    std::vector<std::unique_ptr<RobotBase>> m_robots;
+    bool m_clear_screen = false;
+    int m_round = 0;
+    int m_applying_round = 0;
+    std::size_t m_pos = 0;                  // records before this are applied
+    std::uint64_t m_applied = 0;
+
+    bool read_keyframe(std::size_t at, std::vector<RobotState>& states) const;
+    void rebuild(const std::vector<RobotState>& states);
+    void apply(std::size_t to);
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** (Blackman & Vigna) seeded through splitmix64. Small, fast and
+// fully determined by its seed, so an arena seeded with the same number
+// replays the same game. Also usable as a standard UniformRandomBitGenerator.
+class Rng {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Rng(std::uint64_t seed_in = 0) { seed(seed_in); }
+
+    void seed(std::uint64_t seed_in) {
+        std::uint64_t x = seed_in;
+        for (std::uint64_t& word : m_state) {
+            word = splitmix64(x);
+        }
+    }
+
+    std::uint64_t operator()() {
+        const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+        const std::uint64_t t = m_state[1] << 17;
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+
+        return result;
+    }
+
+    // Uniform in [0, n) with no modulo bias (Lemire's multiply-and-reject;
+    // the division only happens on the rare rejection path).
+    std::uint32_t below(std::uint32_t n) {
+        std::uint64_t m = static_cast<std::uint64_t>(next32()) * n;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < n) {
+            std::uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = static_cast<std::uint64_t>(next32()) * n;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
+
+    // Uniform in [lo, hi].
+    int between(int lo, int hi) {
+        return lo + static_cast<int>(below(static_cast<std::uint32_t>(hi - lo) + 1));
+    }
+
+    static constexpr std::uint64_t min() { return 0; }
+    static constexpr std::uint64_t max() { return std::numeric_limits<std::uint64_t>::max(); }
+
+private:
+    std::uint64_t m_state[4];
+
+    std::uint32_t next32() { return static_cast<std::uint32_t>((*this)() >> 32); }
+
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t splitmix64(std::uint64_t& x) {
+        std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
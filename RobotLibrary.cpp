@@ -0,0 +1,276 @@
+#include "RobotLibrary.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// Compiled robots live here as lib<Name>-<key>.so, where the key hashes
+// everything that goes into the build. The directory survives restarts, so
+// an unchanged robot is only ever compiled once.
+static const std::string cache_dir = ".robot_cache";
+static const std::string compile_flags = "-shared -fPIC -I. -std=c++20";
+
+// Files every robot build depends on besides its own source.
+static const char* shared_inputs[] = { "RobotBase.o", "RobotBase.h", "RadarObj.h" };
+
+// FNV-1a, folded over the bytes of a file. Returns false if it can't be read.
+static bool hash_file(const std::string& path, std::uint64_t& hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    char buffer[8192];
+    while (in) {
+        in.read(buffer, sizeof(buffer));
+        std::streamsize n = in.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 0x100000001B3ULL;
+        }
+    }
+    return true;
+}
+
+static void hash_text(const std::string& text, std::uint64_t& hash) {
+    for (char ch : text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 0x100000001B3ULL;
+    }
+}
+
+static std::string to_hex(std::uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        out[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+// Removes older builds of the same robot once a new one is in place.
+static void remove_stale_builds(const std::string& core, const std::string& keep) {
+    DIR* dir = opendir(cache_dir.c_str());
+    if (!dir) return;
+
+    std::string prefix = "lib" + core + "-";
+    dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.rfind(prefix, 0) == 0 && name.size() == prefix.size() + 16 + 3 &&
+            cache_dir + "/" + name != keep) {
+            std::remove((cache_dir + "/" + name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+// Robot_*.cpp files in the current directory, sorted so that robot order
+// (and with it symbol assignment) doesn't depend on readdir().
+static std::vector<std::string> find_robot_sources() {
+    std::vector<std::string> sources;
+
+    DIR* dir = opendir(".");
+    if (!dir) {
+        std::cerr << "Could not open current directory.\n";
+        return sources;
+    }
+
+    const char* prefix = "Robot_";
+    const char* suffix = ".cpp";
+
+    dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string filename = entry->d_name;
+        if (filename.rfind(prefix, 0) != 0) {
+            continue;
+        }
+        if (filename.size() < 9) {
+            continue;
+        }
+        if (filename.substr(filename.size() - 4) != suffix) {
+            continue;
+        }
+        sources.push_back(filename);
+    }
+
+    closedir(dir);
+    std::sort(sources.begin(), sources.end());
+    return sources;
+}
+
+// One robot on its way from source to loaded library.
+struct RobotBuild {
+    std::string source;
+    std::string core;
+    std::string shared_lib;
+    std::string temp_lib;
+    bool needs_compile = false;
+    bool ok = true;
+};
+
+static pid_t start_compile(const RobotBuild& build) {
+    std::string compile_cmd =
+        "g++ " + compile_flags + " -o " + build.temp_lib + " " + build.source +
+        " RobotBase.o";
+    const char* argv[] = { "sh", "-c", compile_cmd.c_str(), nullptr };
+
+    pid_t pid = -1;
+    if (posix_spawn(&pid, "/bin/sh", nullptr, nullptr,
+                    const_cast<char* const*>(argv), environ) != 0) {
+        return -1;
+    }
+    return pid;
+}
+
+static void finish_compile(RobotBuild& build, int status) {
+    bool built = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!built || std::rename(build.temp_lib.c_str(), build.shared_lib.c_str()) != 0) {
+        std::cerr << "  Failed to compile " << build.source << "\n";
+        std::remove(build.temp_lib.c_str());
+        build.ok = false;
+        return;
+    }
+    remove_stale_builds(build.core, build.shared_lib);
+}
+
+// Runs the needed compiles with at most `jobs` in flight. Only our own
+// compilers are waited for, each by pid, so children the rest of the
+// process started (isolated robots, say) are left to whoever owns them.
+// Compiles take a second or so; checking every few milliseconds costs
+// nothing next to that.
+static void compile_all(std::vector<RobotBuild>& builds, int jobs, EventSink& sink) {
+    std::map<pid_t, RobotBuild*> running;
+    std::size_t next = 0;
+
+    while (true) {
+        while ((int)running.size() < jobs && next < builds.size()) {
+            RobotBuild& build = builds[next++];
+            if (!build.needs_compile) continue;
+
+            sink.robot_compiling(build.source, build.shared_lib);
+            pid_t pid = start_compile(build);
+            if (pid < 0) {
+                std::cerr << "  Could not start the compiler for " << build.source << "\n";
+                build.ok = false;
+                continue;
+            }
+            running[pid] = &build;
+        }
+
+        if (running.empty()) break;
+
+        bool finished = false;
+        for (auto it = running.begin(); it != running.end(); ) {
+            int status = 0;
+            pid_t pid = waitpid(it->first, &status, WNOHANG);
+            if (pid == 0 || (pid < 0 && errno == EINTR)) {
+                ++it;
+                continue;
+            }
+            if (pid < 0) status = -1;   // lost track of it: count it as failed
+            finish_compile(*it->second, status);
+            it = running.erase(it);
+            finished = true;
+        }
+        if (!finished) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+std::vector<RobotLibrary> load_robot_libraries(EventSink& sink, int build_jobs) {
+    std::vector<RobotLibrary> libraries;
+    auto start = std::chrono::steady_clock::now();
+    int cached = 0;
+
+    if (build_jobs <= 0) {
+        build_jobs = static_cast<int>(std::thread::hardware_concurrency());
+        if (build_jobs <= 0) build_jobs = 1;
+    }
+
+    mkdir(cache_dir.c_str(), 0755);
+
+    // Shared part of every robot's cache key.
+    std::uint64_t base_hash = 0xCBF29CE484222325ULL;
+    hash_text(compile_flags, base_hash);
+    for (const char* input : shared_inputs) {
+        if (!hash_file(input, base_hash)) {
+            std::cerr << "  Could not read " << input << "\n";
+        }
+    }
+
+    std::vector<RobotBuild> builds;
+    for (const std::string& filename : find_robot_sources()) {
+        RobotBuild build;
+        build.source = filename;
+        build.core = filename.substr(6, filename.size() - 6 - 4);
+
+        std::uint64_t key = base_hash;
+        if (!hash_file(filename, key)) {
+            std::cerr << "  Could not read " << filename << "\n";
+            continue;
+        }
+        build.shared_lib = cache_dir + "/lib" + build.core + "-" + to_hex(key) + ".so";
+        // Built under a temporary name so an interrupted compile never
+        // leaves a broken library behind under the real one. The name is
+        // this process's own, so two runs sharing the cache can build the
+        // same robot at once; whichever renames last wins, and both
+        // libraries are the same.
+        build.temp_lib = build.shared_lib + "." + std::to_string(getpid()) + ".tmp";
+
+        struct stat info;
+        if (stat(build.shared_lib.c_str(), &info) == 0) {
+            sink.robot_cached(filename, build.shared_lib);
+            cached++;
+        } else {
+            build.needs_compile = true;
+        }
+        builds.push_back(build);
+    }
+
+    compile_all(builds, build_jobs, sink);
+
+    for (const RobotBuild& build : builds) {
+        if (!build.ok) continue;
+
+        void* handle = dlopen(build.shared_lib.c_str(), RTLD_LAZY);
+        if (!handle) {
+            std::cerr << "  Failed to load " << build.shared_lib << ": "
+                      << dlerror() << "\n";
+            continue;
+        }
+
+        RobotFactory create_robot =
+            (RobotFactory)dlsym(handle, "create_robot");
+        if (!create_robot) {
+            std::cerr << "  Failed to find create_robot in "
+                      << build.shared_lib << ": " << dlerror() << "\n";
+            dlclose(handle);
+            continue;
+        }
+
+        RobotLibrary library;
+        library.name = build.core;
+        library.shared_lib = build.shared_lib;
+        library.handle = handle;
+        library.create_robot = create_robot;
+        libraries.push_back(library);
+    }
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    sink.libraries_loaded(static_cast<int>(libraries.size()), cached, elapsed_ms);
+    return libraries;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "RobotBase.h"
+#include "EventSink.h"
+
+// One compiled and dlopen()ed Robot_*.cpp. Libraries are built once and can
+// then create any number of robots, one per arena that uses them.
+struct RobotLibrary {
+    std::string name;         // "Ratboy" for Robot_Ratboy.cpp
+    std::string shared_lib;   // ".robot_cache/libRatboy-<key>.so"
+    void* handle;
+    RobotFactory create_robot;
+
+    RobotLibrary() : handle(nullptr), create_robot(nullptr) {}
+};
+
+// Compiles every Robot_*.cpp in the current directory into a shared object
+// and loads it. Up to build_jobs compilers run at once (0 means one per
+// core). Libraries come back sorted by file name whatever order the builds
+// finish in. Robots that fail to build or load are reported on std::cerr
+// and left out.
+std::vector<RobotLibrary> load_robot_libraries(EventSink& sink, int build_jobs = 0);
@@ -1,16 +1,175 @@
 #include "Arena.h"
+#include "ConsoleSink.h"
+#include "EventStream.h"
+#include "IsolatedRobot.h"
+#include "Replay.h"
+#include "Sweep.h"
+#include "Tournament.h"
 #include <iostream>
+#include <chrono>
 #include <cstdlib>
-#include <ctime>
+#include <cstdint>
+#include <memory>
+#include <random>
 #include <string>
+#include <unistd.h>
 
-int main(int argc, char* argv[]) {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+static const char* usage =
+    "Usage: ./RobotWarz [-m] [-f] [-q] [-s seed] [-r replay_file] [-e events_file [--event-format jsonl|csv]]\n"
+    "                   [--timing] [-b budget_ms] [-i] [--simultaneous] [-t games] [-j threads]\n"
+    "                   [--map map_file | --save-map map_file]\n"
+    "       ./RobotWarz --sweep sweep_file [-s seed] [-b budget_ms] [-i] [--simultaneous] [-j threads]\n"
+    "       ./RobotWarz -p replay_file [--round N]\n";
+
+// Reads the numeric argument that follows option argv[i].
+static bool next_count(int argc, char* argv[], int& i, int& out) {
+    if (i + 1 >= argc) return false;
+    char* end = nullptr;
+    long value = std::strtol(argv[i + 1], &end, 10);
+    if (end == argv[i + 1] || *end != '\0' || value < 0) return false;
+    out = static_cast<int>(value);
+    ++i;
+    return true;
+}
+
+static bool next_seed(int argc, char* argv[], int& i, std::uint64_t& out) {
+    if (i + 1 >= argc || argv[i + 1][0] == '-') return false;
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(argv[i + 1], &end, 10);
+    if (end == argv[i + 1] || *end != '\0') return false;
+    out = value;
+    ++i;
+    return true;
+}
+
+static bool next_path(int argc, char* argv[], int& i, std::string& out) {
+    if (i + 1 >= argc || argv[i + 1][0] == '-') return false;
+    out = argv[++i];
+    return true;
+}
+
+// Shows a recorded game, starting at the given round. On a terminal it
+// then steps through the game on command; otherwise it prints that one
+// round and stops.
+static int play_replay(const std::string& path, int round) {
+    ReplayPlayer player;
+    if (!player.load(path)) return 1;
+
+    bool interactive = isatty(STDIN_FILENO);
+    player.set_clear_screen(interactive);
+    player.seek(round);
+
+    while (true) {
+        player.print();
+        if (player.round() == player.rounds()) {
+            if (player.result() == GameResult::none) {
+                std::cout << "The recording stops after " << player.rounds() << " rounds.\n";
+            } else {
+                std::cout << "Game over after " << player.rounds() << " rounds. ";
+                print_game_result(std::cout, player.result(), player.winner());
+            }
+            std::cout << "\n";
+        }
+        if (!interactive) return 0;
+
+        std::cout << "Round " << player.round() << " of " << player.rounds()
+                  << ": ENTER next, b back, a number to jump, q to quit: " << std::flush;
+        std::string line;
+        if (!std::getline(std::cin, line) || line == "q") return 0;
+
+        if (line.empty() || line == "n") {
+            player.seek(player.round() + 1);
+        } else if (line == "b") {
+            player.seek(player.round() - 1);
+        } else {
+            char* end = nullptr;
+            long target = std::strtol(line.c_str(), &end, 10);
+            if (end != line.c_str() && *end == '\0') player.seek(static_cast<int>(target));
+        }
+    }
+}
+
+// Plays the roster against itself many times on a thread pool and prints
+// a results table; with --timing, how busy each worker thread was too.
+static int run_tournament(int games, int threads, std::uint64_t seed, int budget_ms,
+                          bool isolate, bool simultaneous, bool timing,
+                          const std::string& map_path) {
+    ConsoleSink console;
+
+    ArenaConfig config;
+    if (!read_config("config.txt", config)) {
+        console.config_missing("config.txt");
+    }
+
+    std::vector<RobotLibrary> libraries = load_robot_libraries(console, threads);
+    if (libraries.empty()) {
+        std::cout << "No robots loaded. Nothing to do.\n";
+        return 1;
+    }
+
+    Tournament tournament(config, libraries, games, seed);
+    tournament.set_call_budget(std::chrono::milliseconds(budget_ms));
+    tournament.set_isolation(isolate);
+    tournament.set_simultaneous(simultaneous);
+    tournament.set_map(map_path);
+    if (!tournament.run(static_cast<unsigned int>(threads))) return 1;
+    tournament.print_summary(std::cout);
+    if (timing) tournament.print_utilization(std::cout);
+    return 0;
+}
+
+// Plays a tournament on every configuration a sweep file declares, with
+// the robots compiled once for all of them, and writes the results as CSV.
+// -s overrides the file's seed.
+static int run_sweep(const std::string& path, int threads, bool have_seed, std::uint64_t seed,
+                     int budget_ms, bool isolate, bool simultaneous) {
+    SweepPlan plan;
+    if (!read_sweep(path, plan)) return 1;
+    if (have_seed || !plan.has_seed) plan.seed = seed;
 
+    ConsoleSink console;
+    std::vector<RobotLibrary> libraries = load_robot_libraries(console, threads);
+    if (libraries.empty()) {
+        std::cout << "No robots loaded. Nothing to do.\n";
+        return 1;
+    }
+
+    Sweep sweep(plan, libraries);
+    sweep.set_call_budget(std::chrono::milliseconds(budget_ms));
+    sweep.set_isolation(isolate);
+    sweep.set_simultaneous(simultaneous);
+    if (!sweep.check()) return 1;
+    std::cout << "Sweeping " << plan.configs.size()
+              << (plan.configs.size() == 1 ? " configuration, " : " configurations, ")
+              << plan.games << " games each, seed " << plan.seed << ".\n";
+    if (!sweep.run(std::cout, static_cast<unsigned int>(threads))) return 1;
+    if (!sweep.write_csv(plan.output)) return 1;
+    std::cout << "Wrote " << plan.output << ".\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     Arena arena;
 
     bool watch_live = false;
     bool fast_mode   = false;
+    bool headless    = false;
+    bool timing      = false;
+    bool isolate     = false;
+    bool simultaneous = false;
+    int games        = 0;
+    int threads      = 0;
+    int budget_ms    = 0;
+    bool have_seed   = false;
+    std::uint64_t seed = 0;
+    std::string replay_path;
+    std::string events_path;
+    std::string map_path;
+    std::string save_map_path;
+    std::string sweep_path;
+    EventFormat events_format = EventFormat::jsonl;
+    std::string play_path;
+    int play_round = 0;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -21,15 +180,156 @@ int main(int argc, char* argv[]) {
         else if (arg == "-f" || arg == "--fast") {
             fast_mode = true;
         }
+        else if (arg == "-q" || arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "--timing") {
+            timing = true;
+        }
+        else if (arg == "-i" || arg == "--isolate") {
+            isolate = true;
+        }
+        else if (arg == "--simultaneous") {
+            simultaneous = true;
+        }
+        else if (arg == "-s" || arg == "--seed") {
+            if (!next_seed(argc, argv, i, seed)) {
+                std::cout << arg << " needs a number.\n" << usage;
+                return 1;
+            }
+            have_seed = true;
+        }
+        else if (arg == "-r" || arg == "--record") {
+            if (!next_path(argc, argv, i, replay_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "-e" || arg == "--events") {
+            if (!next_path(argc, argv, i, events_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "--map") {
+            if (!next_path(argc, argv, i, map_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "--save-map") {
+            if (!next_path(argc, argv, i, save_map_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "--sweep") {
+            if (!next_path(argc, argv, i, sweep_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "--event-format") {
+            if (i + 1 >= argc || !parse_event_format(argv[i + 1], events_format)) {
+                std::cout << arg << " needs jsonl or csv.\n" << usage;
+                return 1;
+            }
+            ++i;
+        }
+        else if (arg == "-p" || arg == "--play") {
+            if (!next_path(argc, argv, i, play_path)) {
+                std::cout << arg << " needs a file name.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "--round") {
+            if (!next_count(argc, argv, i, play_round)) {
+                std::cout << arg << " needs a round number.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "-t" || arg == "--tournament") {
+            if (!next_count(argc, argv, i, games) || games == 0) {
+                std::cout << arg << " needs a number of games.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "-b" || arg == "--budget") {
+            if (!next_count(argc, argv, i, budget_ms) || budget_ms == 0) {
+                std::cout << arg << " needs a number of milliseconds.\n" << usage;
+                return 1;
+            }
+        }
+        else if (arg == "-j" || arg == "--jobs") {
+            if (!next_count(argc, argv, i, threads)) {
+                std::cout << arg << " needs a number of threads.\n" << usage;
+                return 1;
+            }
+        }
         else {
             std::cout << "Unknown option: " << arg << "\n";
-            std::cout << "Usage: ./RobotWarz [-m] [-f]\n";
+            std::cout << usage;
+            return 1;
+        }
+    }
+
+    if (!play_path.empty()) {
+        return play_replay(play_path, play_round);
+    }
+
+    if (!map_path.empty() && !save_map_path.empty()) {
+        std::cout << "--map plays a saved map; --save-map saves a random one. Pick one.\n" << usage;
+        return 1;
+    }
+
+    if (!have_seed) {
+        std::random_device device;
+        seed = (static_cast<std::uint64_t>(device()) << 32) | device();
+    }
+
+    // Robot processes are forked by a launcher, which has to be forked
+    // before anything starts a thread. A budget isolates robots too.
+    if ((isolate || budget_ms > 0) && !IsolatedRobot::start_launcher()) return 1;
+
+    if (!sweep_path.empty()) {
+        if (games > 0 || !replay_path.empty() || !events_path.empty() ||
+            !map_path.empty() || !save_map_path.empty()) {
+            std::cout << "--sweep takes its games and boards from the sweep file; it can't be used "
+                         "with -t, -r, -e, --map or --save-map.\n" << usage;
             return 1;
         }
+        return run_sweep(sweep_path, threads, have_seed, seed, budget_ms, isolate, simultaneous);
+    }
+
+    if (games > 0) {
+        if (!replay_path.empty()) {
+            std::cout << "-r records a single game; it can't be used with -t.\n" << usage;
+            return 1;
+        }
+        if (!events_path.empty()) {
+            std::cout << "-e records a single game; it can't be used with -t.\n" << usage;
+            return 1;
+        }
+        if (!save_map_path.empty()) {
+            std::cout << "--save-map saves a single game's board; it can't be used with -t.\n" << usage;
+            return 1;
+        }
+        return run_tournament(games, threads, seed, budget_ms, isolate, simultaneous, timing,
+                              map_path);
+    }
+    arena.set_seed(seed);
+
+    // Headless: nothing is reported while the game runs, only the result.
+    if (headless) {
+        arena.set_event_sink(nullptr);
+        watch_live = false;
     }
 
     // Load config (defaults if missing)
     arena.load_config("config.txt");
+    if (headless) {
+        arena.set_watch_live(false);
+    }
 
     if (watch_live) {
         std::cout << "Live mode enabled.\n";
@@ -42,13 +342,61 @@ int main(int argc, char* argv[]) {
         arena.set_fast_mode(true);
     }
 
-    arena.load_obstacles();
-    arena.load_robots();
+    // Before the robots are loaded: a budget runs them isolated, so that a
+    // robot that never returns can be put out.
+    arena.set_isolation(isolate);
+    arena.set_call_budget(std::chrono::milliseconds(budget_ms));
+    // -j also sets how many robots decide at once.
+    arena.set_simultaneous(simultaneous, static_cast<unsigned int>(threads));
+    // A map brings its own size and obstacles.
+    if (!map_path.empty()) {
+        if (!arena.load_map(map_path)) return 1;
+    } else if (!arena.load_obstacles()) {
+        return 1;
+    }
+    if (!save_map_path.empty() && !arena.save_map(save_map_path)) return 1;
+    if (!arena.load_robots(threads)) return 1;
+
+    // Several robots seed std::rand from the clock in their constructors;
+    // reseed it from the game seed so the whole game replays.
+    std::srand(static_cast<unsigned int>(seed));
+
+    // Recordings run next to whatever the arena would print anyway; an
+    // event stream is teed onto the sinks before it.
+    ConsoleSink console;
+    ReplayRecorder recorder;
+    EventStream events(events_format);
+    EventSink* outputs = headless ? nullptr : &console;
+    std::vector<std::unique_ptr<TeeSink>> tees;
+    auto add_output = [&](EventSink& output) {
+        if (outputs) outputs = tees.emplace_back(std::make_unique<TeeSink>(*outputs, output)).get();
+        else         outputs = &output;
+        arena.set_event_sink(outputs);
+    };
+    if (!replay_path.empty()) {
+        if (!recorder.open(replay_path)) return 1;
+        recorder.begin(arena);
+        arena.set_replay_recorder(&recorder);
+    }
+    if (!events_path.empty()) {
+        if (!events.open(events_path)) return 1;
+        add_output(events);
+    }
+
+    arena.set_phase_timing(timing);
+
+    if (headless) {
+        arena.run();
+        print_game_result(std::cout, arena.result(), arena.winner());
+        if (timing) arena.phase_times()->print(std::cout, arena.robot_infos());
+        return 0;
+    }
 
-    std::cout << "\nStarting RobotWarz simulation...\n\n";
+    std::cout << "\nStarting RobotWarz simulation (seed " << seed << ")...\n\n";
 
     arena.run();
 
     std::cout << "\nSimulation finished.\n";
+    if (timing) arena.phase_times()->print(std::cout, arena.robot_infos());
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                  sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "futexes need plain 32-bit atomics");
+
+// Sleeps while `word` still holds `expected` (or until woken, or timeout;
+// nullptr waits forever). Works across processes on shared memory.
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                       const timespec* timeout) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected,
+            timeout, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<std::uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1,
+            nullptr, nullptr, 0);
+}
+
+// A single-producer, single-consumer queue of N fixed-size items, meant to
+// live in memory shared by two processes. Head and tail only count up.
+// A side that finds nothing to do spins for a moment, in case the other is
+// running on another core and about to catch up, then says it is going to
+// sleep and sleeps on the other's counter with a futex. The other side only
+// makes the wake-up call when it sees that, so a busy ring runs without
+// system calls.
+template <typename T, std::uint32_t N>
+class SharedRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    // Producer. False if the ring is full. A message that takes several
+    // items can hold back the wake-up with `wake` false on all but the
+    // last, so the consumer isn't woken to find half of it.
+    bool try_push(const T& item, bool wake = true) {
+        std::uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load() == N) return false;
+        m_slots[head % N] = item;
+        m_head.store(head + 1);
+        if (wake) wake_consumer();
+        return true;
+    }
+
+    void wake_consumer() {
+        if (m_consumer_asleep.load()) futex_wake(m_head);
+    }
+
+    // Consumer. False if the ring is empty.
+    bool try_pop(T& item) {
+        std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load() == tail) return false;
+        item = m_slots[tail % N];
+        m_tail.store(tail + 1);
+        if (m_producer_asleep.load()) futex_wake(m_tail);
+        return true;
+    }
+
+    // Sleep until the ring may have an item, or room for one, or the
+    // timeout passes. Returning early is fine; callers try again.
+    void wait_for_item(const timespec* timeout) {
+        sleep_unless(m_head, m_consumer_asleep, timeout,
+                     [this](std::uint32_t head) { return head != m_tail.load(); });
+    }
+
+    // Wakes the consumer first: it may be asleep on items pushed without
+    // a wake-up, and only it can make room.
+    void wait_for_room(const timespec* timeout) {
+        wake_consumer();
+        sleep_unless(m_tail, m_producer_asleep, timeout,
+                     [this](std::uint32_t tail) { return m_head.load() - tail != N; });
+    }
+
+private:
+    // Each side writes only its own cache line of these.
+    alignas(64) std::atomic<std::uint32_t> m_head{0};   // items pushed
+    std::atomic<std::uint32_t> m_producer_asleep{0};
+    alignas(64) std::atomic<std::uint32_t> m_tail{0};   // items popped
+    std::atomic<std::uint32_t> m_consumer_asleep{0};
+    alignas(64) T m_slots[N];
+
+    // Polls `word` with ready() for a few microseconds, on machines where the
+    // other side can be running meanwhile, then sleeps on it. The flag goes up
+    // before the last look, and the other side stores its counter before
+    // looking at the flag, so one of the two always sees the other.
+    template <typename Ready>
+    static void sleep_unless(std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& asleep,
+                             const timespec* timeout, Ready ready) {
+        static const int spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 2000 : 0;
+        for (int i = 0; i < spins; ++i) {
+            if (ready(word.load())) return;
+            cpu_relax();
+        }
+        asleep.store(1);
+        std::uint32_t seen = word.load();
+        if (!ready(seen)) futex_wait(word, seen, timeout);
+        asleep.store(0);
+    }
+
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+};
@@ -0,0 +1,351 @@
+#include "Sweep.h"
+#include "Csv.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+static const int min_side = 10;
+static const int max_side = 1 << 15;
+
+static std::string trim(const std::string& text) {
+    std::size_t first = 0, last = text.size();
+    while (first < last && std::isspace(static_cast<unsigned char>(text[first]))) ++first;
+    while (last > first && std::isspace(static_cast<unsigned char>(text[last - 1]))) --last;
+    return text.substr(first, last - first);
+}
+
+// "a, b ,c" -> {"a", "b", "c"}; an empty item stays in, as "".
+static std::vector<std::string> split_list(const std::string& text, char separator = ',') {
+    std::vector<std::string> items;
+    std::size_t start = 0;
+    while (true) {
+        std::size_t end = text.find(separator, start);
+        items.push_back(trim(text.substr(start, end - start)));
+        if (end == std::string::npos) return items;
+        start = end + 1;
+    }
+}
+
+static bool parse_number(const std::string& text, long long lo, long long hi, long long& out) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    long long value = std::strtoll(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || value < lo || value > hi) return false;
+    out = value;
+    return true;
+}
+
+static bool parse_int(const std::string& text, int lo, int hi, int& out) {
+    long long value;
+    if (!parse_number(text, lo, hi, value)) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Splits density * cells obstacles by the mix, rounding the running total
+// so the three counts always add up.
+static void place_density(ArenaConfig& config, double density, const int mix[3]) {
+    long long cells = static_cast<long long>(config.rows) * config.cols;
+    long long total = std::min(cells, std::llround(density * static_cast<double>(cells)));
+    long long weight = mix[0] + mix[1] + mix[2];
+    auto share = [&](long long upto) { return (total * upto + weight / 2) / weight; };
+    config.num_mounds = static_cast<int>(share(mix[0]));
+    config.num_pits = static_cast<int>(share(mix[0] + mix[1]) - config.num_mounds);
+    config.num_flames = static_cast<int>(total - config.num_mounds - config.num_pits);
+}
+
+bool read_sweep(const std::string& path, SweepPlan& plan) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Can't open sweep file " << path << ".\n";
+        return false;
+    }
+    return read_sweep(in, path, plan);
+}
+
+bool read_sweep(std::istream& in, const std::string& name, SweepPlan& plan) {
+    const ArenaConfig defaults;
+    std::vector<std::pair<int, int>> sizes{ { defaults.rows, defaults.cols } };
+    std::vector<double> densities{ -1.0 };
+    int mix[3] = { 2, 1, 1 };
+    std::vector<int> round_limits{ defaults.max_rounds };
+    std::vector<std::vector<std::string>> rosters{ {} };
+    SweepPlan read;
+
+    bool ok = true;
+    std::map<std::string, int> seen;   // key -> line it was set on
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        auto fail = [&](const std::string& message) {
+            std::cerr << name << ":" << number << ": " << message << "\n";
+            ok = false;
+        };
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            fail("expected key = value.");
+            continue;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        auto [previous, first_time] = seen.emplace(key, number);
+        if (!first_time) {
+            fail(key + " was already set on line " + std::to_string(previous->second) + ".");
+            continue;
+        }
+        if (value.empty()) {
+            fail(key + " needs a value.");
+            continue;
+        }
+        std::vector<std::string> items = split_list(value);
+        if (std::find(items.begin(), items.end(), "") != items.end()) {
+            fail(key + " has an empty item in its list.");
+            continue;
+        }
+
+        if (key == "size") {
+            sizes.clear();
+            for (const std::string& item : items) {
+                std::vector<std::string> sides = split_list(item, 'x');
+                int rows, cols;
+                if (sides.size() != 2 || !parse_int(sides[0], min_side, max_side, rows) ||
+                    !parse_int(sides[1], min_side, max_side, cols)) {
+                    fail("size " + item + " isn't rows x cols with sides from " +
+                         std::to_string(min_side) + " to " + std::to_string(max_side) + ".");
+                    continue;
+                }
+                sizes.emplace_back(rows, cols);
+            }
+        } else if (key == "density") {
+            densities.clear();
+            for (const std::string& item : items) {
+                char* end = nullptr;
+                double density = std::strtod(item.c_str(), &end);
+                if (*end != '\0' || !(density >= 0.0 && density <= 1.0)) {
+                    fail("density " + item + " isn't a number from 0 to 1.");
+                    continue;
+                }
+                densities.push_back(density);
+            }
+        } else if (key == "mix") {
+            std::vector<std::string> parts = split_list(value, ':');
+            bool good = items.size() == 1 && parts.size() == 3;
+            for (int i = 0; good && i < 3; ++i) good = parse_int(parts[i], 0, 1000, mix[i]);
+            if (!good || mix[0] + mix[1] + mix[2] == 0) {
+                fail("mix " + value + " isn't mounds:pits:flames, three weights from 0 to 1000, not all 0.");
+            }
+        } else if (key == "max_rounds") {
+            round_limits.clear();
+            for (const std::string& item : items) {
+                int rounds;
+                if (!parse_int(item, 1, 1000000, rounds)) {
+                    fail("max_rounds " + item + " isn't a number from 1 to 1000000.");
+                    continue;
+                }
+                round_limits.push_back(rounds);
+            }
+        } else if (key == "roster") {
+            rosters.clear();
+            for (const std::string& item : items) {
+                std::istringstream words(item);
+                std::vector<std::string> names;
+                std::string word;
+                while (words >> word) names.push_back(word);
+                if (names == std::vector<std::string>{ "*" }) names.clear();
+                else if (std::find(names.begin(), names.end(), "*") != names.end()) {
+                    fail("roster " + item + ": * stands for every robot, so it goes alone.");
+                    continue;
+                }
+                std::vector<std::string> sorted = names;
+                std::sort(sorted.begin(), sorted.end());
+                auto twice = std::adjacent_find(sorted.begin(), sorted.end());
+                if (twice != sorted.end()) {
+                    fail("roster " + item + " names " + *twice + " twice.");
+                    continue;
+                }
+                rosters.push_back(names);
+            }
+        } else if (key == "games") {
+            if (items.size() != 1 || !parse_int(value, 1, 1000000, read.games)) {
+                fail("games " + value + " isn't a number from 1 to 1000000.");
+            }
+        } else if (key == "seed") {
+            char* end = nullptr;
+            errno = 0;
+            read.seed = std::strtoull(value.c_str(), &end, 10);
+            read.has_seed = true;
+            if (items.size() != 1 || !std::isdigit(static_cast<unsigned char>(value[0])) ||
+                *end != '\0' || errno == ERANGE) {
+                fail("seed " + value + " isn't a number.");
+            }
+        } else if (key == "output") {
+            read.output = value;
+        } else {
+            fail("unknown key " + key + "; expected size, density, mix, max_rounds, roster, "
+                 "games, seed or output.");
+        }
+    }
+    if (!ok) return false;
+
+    for (const auto& [rows, cols] : sizes) {
+        for (double density : densities) {
+            for (int max_rounds : round_limits) {
+                for (const std::vector<std::string>& roster : rosters) {
+                    SweepConfig config;
+                    config.arena.rows = rows;
+                    config.arena.cols = cols;
+                    config.arena.max_rounds = max_rounds;
+                    if (density >= 0.0) place_density(config.arena, density, mix);
+                    config.roster = roster;
+                    read.configs.push_back(config);
+                }
+            }
+        }
+    }
+    plan = std::move(read);
+    return true;
+}
+
+Sweep::Sweep(const SweepPlan& plan_in, const std::vector<RobotLibrary>& libraries_in)
+    : plan(plan_in), libraries(libraries_in) {}
+
+bool Sweep::pick_roster(const SweepConfig& config, std::vector<RobotLibrary>& roster,
+                        std::string& missing) const {
+    if (config.roster.empty()) {
+        roster = libraries;
+        return true;
+    }
+    roster.clear();
+    for (const std::string& name : config.roster) {
+        auto found = std::find_if(libraries.begin(), libraries.end(),
+                                  [&](const RobotLibrary& library) { return library.name == name; });
+        if (found == libraries.end()) {
+            missing = name;
+            return false;
+        }
+        roster.push_back(*found);
+    }
+    return true;
+}
+
+static long long obstacle_count(const ArenaConfig& config) {
+    return static_cast<long long>(config.num_mounds) + config.num_pits + config.num_flames;
+}
+
+bool Sweep::check() const {
+    bool ok = true;
+    for (std::size_t i = 0; i < plan.configs.size(); ++i) {
+        const SweepConfig& config = plan.configs[i];
+        std::vector<RobotLibrary> roster;
+        std::string missing;
+        if (!pick_roster(config, roster, missing)) {
+            std::cerr << "Configuration " << i + 1 << ": no robot called " << missing
+                      << " was loaded (loaded:";
+            for (const RobotLibrary& library : libraries) std::cerr << " " << library.name;
+            std::cerr << ").\n";
+            ok = false;
+            continue;
+        }
+        long long cells = static_cast<long long>(config.arena.rows) * config.arena.cols;
+        long long wanted = obstacle_count(config.arena) + static_cast<long long>(roster.size());
+        if (wanted > cells) {
+            std::cerr << "Configuration " << i + 1 << ": " << obstacle_count(config.arena)
+                      << " obstacles and " << roster.size() << " robots don't fit on a "
+                      << config.arena.rows << "x" << config.arena.cols << " board.\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool Sweep::run(std::ostream& progress, unsigned int threads) {
+    outcomes.clear();
+    if (!check()) return false;
+
+    for (std::size_t i = 0; i < plan.configs.size(); ++i) {
+        const SweepConfig& config = plan.configs[i];
+        std::vector<RobotLibrary> roster;
+        std::string missing;
+        pick_roster(config, roster, missing);   // checked above
+
+        Tournament tournament(config.arena, roster, plan.games, plan.seed);
+        tournament.set_call_budget(call_budget);
+        tournament.set_isolation(isolate);
+        tournament.set_simultaneous(simultaneous);
+        if (!tournament.run(threads)) return false;
+
+        SweepResult result;
+        result.config = config;
+        result.games = plan.games;
+        result.drawn_games = tournament.draws();
+        result.average_rounds = tournament.average_rounds();
+        result.stats = tournament.stats();
+        outcomes.push_back(result);
+
+        progress << "[" << i + 1 << "/" << plan.configs.size() << "] "
+                 << config.arena.rows << "x" << config.arena.cols << ", "
+                 << obstacle_count(config.arena) << " obstacles, "
+                 << config.arena.max_rounds << " rounds, " << roster.size() << " robots: "
+                 << result.drawn_games << " of " << result.games << " games drawn, "
+                 << std::fixed << std::setprecision(1) << result.average_rounds
+                 << " rounds on average.\n";
+    }
+    return true;
+}
+
+void Sweep::write_csv(std::ostream& out) const {
+    out << "config,rows,cols,mounds,pits,flames,density,max_rounds,roster,games,drawn_games,"
+           "average_rounds,robot,wins,draws,losses,win_pct,survived,average_rounds_alive,"
+           "overruns,crashes\n";
+    out << std::fixed;
+    for (std::size_t i = 0; i < outcomes.size(); ++i) {
+        const SweepResult& result = outcomes[i];
+        const ArenaConfig& arena = result.config.arena;
+        double cells = static_cast<double>(arena.rows) * arena.cols;
+        std::string names, roster;
+        for (const TournamentStats& t : result.stats) names += (names.empty() ? "" : " ") + t.name;
+        append_csv_field(roster, names);
+
+        for (const TournamentStats& t : result.stats) {
+            double games = t.games > 0 ? t.games : 1;
+            out << i + 1 << ',' << arena.rows << ',' << arena.cols << ','
+                << arena.num_mounds << ',' << arena.num_pits << ',' << arena.num_flames << ','
+                << std::setprecision(4) << obstacle_count(arena) / cells << ','
+                << arena.max_rounds << ',' << roster
+                << ',' << result.games << ',' << result.drawn_games << ','
+                << std::setprecision(2) << result.average_rounds << ',';
+            std::string name;
+            append_csv_field(name, t.name);
+            out << name << ',' << t.wins << ',' << t.draws << ',' << t.losses << ','
+                << std::setprecision(1) << 100.0 * t.wins / games << ','
+                << t.survived << ','
+                << std::setprecision(2) << t.rounds_alive / games << ','
+                << t.overruns << ',' << t.crashes << '\n';
+        }
+    }
+}
+
+bool Sweep::write_csv(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Can't write " << path << ".\n";
+        return false;
+    }
+    write_csv(out);
+    out.close();
+    if (!out) {
+        std::cerr << "Writing " << path << " failed.\n";
+        return false;
+    }
+    return true;
+}
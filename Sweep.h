@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "RobotLibrary.h"
+#include "Tournament.h"
+
+// A parameter sweep: a tournament on every combination of board size,
+// obstacle density, round limit and roster, all in one process. Read from
+// a keyed file, one setting per line, lists separated by commas:
+//
+//   # Lines starting with # are comments.
+//   size       = 20x20, 40x60        rows x cols, each side 10 to 32768
+//   density    = 0.05, 0.2           share of cells with an obstacle, 0 to 1
+//   mix        = 2:1:1               mounds : pits : flames
+//   max_rounds = 100, 500
+//   roster     = *, Ratboy Bomber    robot names; * for every robot
+//   games      = 20                  per configuration
+//   seed       = 42                  the same for every configuration
+//   output     = sweep.csv           one row per robot per configuration
+//
+// Every key is optional and may appear once. Without density, boards get
+// ArenaConfig's obstacle counts whatever their size.
+struct SweepConfig {
+    ArenaConfig arena;
+    std::vector<std::string> roster;   // robot names; empty for every robot
+};
+
+struct SweepPlan {
+    // Every combination; sizes vary slowest, rosters fastest.
+    std::vector<SweepConfig> configs;
+    int games = 10;
+    bool has_seed = false;
+    std::uint64_t seed = 0;
+    std::string output = "sweep.csv";
+};
+
+// Reports problems on std::cerr, by line, and returns false. The plan is
+// only filled in if the whole file is good.
+bool read_sweep(const std::string& path, SweepPlan& plan);
+bool read_sweep(std::istream& in, const std::string& name, SweepPlan& plan);
+
+// How one configuration went.
+struct SweepResult {
+    SweepConfig config;
+    int games = 0;
+    int drawn_games = 0;
+    double average_rounds = 0.0;
+    std::vector<TournamentStats> stats;   // per robot, in roster order
+};
+
+// Runs a plan's configurations one after another, each as a Tournament.
+// The robots are compiled once, by whoever loads `libraries`, and every
+// configuration picks its roster out of them.
+class Sweep {
+public:
+    Sweep(const SweepPlan& plan, const std::vector<RobotLibrary>& libraries);
+
+    // See Tournament; these apply to every configuration.
+    void set_call_budget(std::chrono::microseconds budget) { call_budget = budget; }
+    void set_isolation(bool on) { isolate = on; }
+    void set_simultaneous(bool on) { simultaneous = on; }
+
+    // Checks every configuration before any is played: each roster names
+    // robots that were loaded, and its robots and obstacles fit the board.
+    // Reports problems on std::cerr and returns false.
+    bool check() const;
+
+    // Checks, then plays everything, with a line on `progress` as each
+    // configuration finishes. 0 threads means one per hardware core.
+    bool run(std::ostream& progress, unsigned int threads = 0);
+
+    const std::vector<SweepResult>& results() const { return outcomes; }
+
+    // One row per robot per configuration, under a header row.
+    void write_csv(std::ostream& out) const;
+    bool write_csv(const std::string& path) const;
+
+private:
+    SweepPlan plan;
+    const std::vector<RobotLibrary>& libraries;
+    std::chrono::microseconds call_budget{0};
+    bool isolate = false;
+    bool simultaneous = false;
+
+    std::vector<SweepResult> outcomes;
+
+    // False, with the first name not loaded in `missing`, if the roster
+    // names a robot that isn't in libraries.
+    bool pick_roster(const SweepConfig& config, std::vector<RobotLibrary>& roster,
+                     std::string& missing) const;
+};
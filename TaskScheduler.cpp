@@ -0,0 +1,196 @@
+#include "TaskScheduler.h"
+
+#include <iomanip>
+
+// The scheduler and worker the current thread belongs to, if any.
+static thread_local const TaskScheduler* current_scheduler = nullptr;
+static thread_local std::size_t current_worker = 0;
+// Time inside the running job that isn't its own: jobs run while it waited
+// on a group, and time asleep in that wait.
+static thread_local std::int64_t excluded_ns = 0;
+
+static std::int64_t since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start).count();
+}
+
+TaskScheduler::TaskScheduler(unsigned int threads) : m_started(std::chrono::steady_clock::now()) {
+    if (threads == 0) threads = default_thread_count();
+    for (unsigned int i = 0; i < threads; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // Every deque exists before any worker goes looking in them.
+    for (std::size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i]->thread = std::thread([this, i] { work(i); });
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) worker->thread.join();
+}
+
+void TaskScheduler::submit(TaskGroup& group, std::function<void()> job) {
+    group.m_pending++;
+    // A worker's own jobs go on the back, where it takes its next job from;
+    // jobs from outside go on the front, so a worker gets through them in
+    // the order they came (a one-thread tournament plays its games in
+    // order) and thieves take them before the smaller jobs they spawn.
+    bool own = current_scheduler == this;
+    std::size_t index = own ? current_worker : m_next.fetch_add(1) % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        if (own) m_workers[index]->tasks.push_back(Task{ std::move(job), &group });
+        else     m_workers[index]->tasks.push_front(Task{ std::move(job), &group });
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_epoch;
+    }
+    m_wake.notify_one();
+}
+
+void TaskScheduler::wait(TaskGroup& group) {
+    if (current_scheduler != this) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&] { return group.done(); });
+        return;
+    }
+
+    // A worker keeps working until the group is done.
+    while (!group.done()) {
+        std::uint64_t seen = epoch();
+        if (group.done()) return;
+        Task task;
+        if (find_task(current_worker, task)) {
+            run(current_worker, task);
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_epoch != seen || m_stopping || group.done(); });
+        }
+        excluded_ns += since(start);
+    }
+}
+
+std::uint64_t TaskScheduler::epoch() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_epoch;
+}
+
+void TaskScheduler::work(std::size_t index) {
+    current_scheduler = this;
+    current_worker = index;
+    while (true) {
+        std::uint64_t seen;
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            seen = m_epoch;
+            stopping = m_stopping;
+        }
+        Task task;
+        if (find_task(index, task)) {
+            run(index, task);
+            continue;
+        }
+        if (stopping) return;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_epoch != seen || m_stopping; });
+    }
+}
+
+// Newest job off our own deque, else the oldest off someone else's.
+bool TaskScheduler::find_task(std::size_t index, Task& task) {
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < m_workers.size(); ++k) {
+        Worker& victim = *m_workers[(index + k) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_workers[index]->stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::run(std::size_t index, Task& task) {
+    Worker& worker = *m_workers[index];
+    std::int64_t outer = excluded_ns;
+    excluded_ns = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    task.job();
+
+    std::int64_t elapsed = since(start);
+    worker.busy_ns += elapsed - excluded_ns;
+    worker.tasks_run++;
+    excluded_ns = outer + elapsed;
+
+    // The group may be gone as soon as its count reaches zero.
+    if (task.group->m_pending.fetch_sub(1) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_epoch;
+        }
+        m_wake.notify_all();
+        m_done.notify_all();
+    }
+}
+
+std::vector<WorkerStats> TaskScheduler::worker_stats() const {
+    std::chrono::nanoseconds elapsed(since(m_started));
+    std::vector<WorkerStats> stats;
+    for (const auto& worker : m_workers) {
+        WorkerStats s;
+        s.tasks = worker->tasks_run.load();
+        s.stolen = worker->stolen.load();
+        s.busy = std::chrono::nanoseconds(worker->busy_ns.load());
+        s.elapsed = elapsed;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+// Only meant for when no jobs are running.
+void TaskScheduler::reset_stats() {
+    for (auto& worker : m_workers) {
+        worker->tasks_run = 0;
+        worker->stolen = 0;
+        worker->busy_ns = 0;
+    }
+    m_started = std::chrono::steady_clock::now();
+}
+
+void print_worker_stats(std::ostream& out, const std::vector<WorkerStats>& stats) {
+    out << std::left << std::setw(8) << "Worker" << std::right
+        << std::setw(9) << "Tasks"
+        << std::setw(9) << "Stolen"
+        << std::setw(12) << "Busy ms"
+        << std::setw(9) << "Busy%" << "\n";
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        out << std::left << std::setw(8) << i << std::right
+            << std::setw(9) << stats[i].tasks
+            << std::setw(9) << stats[i].stolen
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << stats[i].busy.count() / 1e6
+            << std::setw(8) << 100.0 * stats[i].utilization() << "%\n";
+    }
+}
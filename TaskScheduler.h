@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs submitted together, to be waited on together.
+class TaskGroup {
+public:
+    bool done() const { return m_pending.load() == 0; }
+
+private:
+    friend class TaskScheduler;
+    std::atomic<std::size_t> m_pending{0};
+};
+
+// What one worker has done since the scheduler started (or reset_stats).
+struct WorkerStats {
+    std::uint64_t tasks = 0;        // jobs run
+    std::uint64_t stolen = 0;       // of those, taken from another worker's deque
+    std::chrono::nanoseconds busy{0};
+    std::chrono::nanoseconds elapsed{0};
+
+    double utilization() const {
+        return elapsed.count() > 0 ? static_cast<double>(busy.count()) / elapsed.count() : 0.0;
+    }
+};
+
+// One line per worker: jobs, steals, busy time and share of the time busy.
+void print_worker_stats(std::ostream& out, const std::vector<WorkerStats>& stats);
+
+// A fixed set of worker threads, each with a deque of its own. A worker
+// takes its newest job first and, when it runs dry, steals the oldest job
+// of another worker, so long and short jobs spread themselves over the
+// workers without anyone dividing them up in advance.
+//
+// Jobs submitted from a worker go onto its own deque; from any other
+// thread they are dealt round the workers and run in the order given. A worker waiting on a group
+// runs other jobs meanwhile, so jobs may submit and wait on jobs of their
+// own (a tournament game deciding its robots' turns, say) without tying up
+// the worker.
+class TaskScheduler {
+public:
+    // 0 threads means one per hardware core.
+    explicit TaskScheduler(unsigned int threads = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(TaskGroup& group, std::function<void()> job);
+    // Blocks until every job in the group has finished.
+    void wait(TaskGroup& group);
+
+    // The same, for jobs in no particular group.
+    void submit(std::function<void()> job) { submit(m_default_group, std::move(job)); }
+    void wait_idle() { wait(m_default_group); }
+
+    std::size_t size() const { return m_workers.size(); }
+
+    // Per worker. Busy time leaves out time a job spent waiting on a group,
+    // and counts jobs run meanwhile at their own level.
+    std::vector<WorkerStats> worker_stats() const;
+    void reset_stats();
+
+    static unsigned int default_thread_count() {
+        unsigned int n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+private:
+    struct Task {
+        std::function<void()> job;
+        TaskGroup* group = nullptr;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+        std::atomic<std::uint64_t> tasks_run{0};
+        std::atomic<std::uint64_t> stolen{0};
+        std::atomic<std::int64_t> busy_ns{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    TaskGroup m_default_group;
+    std::atomic<std::size_t> m_next{0};   // where the next outside job goes
+
+    // Sleepers. The epoch moves on with every submit and every group that
+    // finishes, so a worker that found nothing to do sleeps only if nothing
+    // has changed since it started looking.
+    std::mutex m_mutex;
+    std::condition_variable m_wake;       // workers, idle or helping
+    std::condition_variable m_done;       // outside threads in wait()
+    std::uint64_t m_epoch = 0;
+    bool m_stopping = false;
+
+    std::chrono::steady_clock::time_point m_started;
+
+    void work(std::size_t index);
+    bool find_task(std::size_t index, Task& task);
+    void run(std::size_t index, Task& task);
+    std::uint64_t epoch();
+};
@@ -0,0 +1,138 @@
+#include "TerminalRenderer.h"
+
+#include <cerrno>
+#include <iostream>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Unchanged stretches shorter than this are sent again rather than skipped:
+// a cursor move costs about as many bytes.
+static const std::size_t min_skip = 8;
+
+TerminalRenderer::~TerminalRenderer() {
+    if (!m_scroll_region) return;
+    // Resetting the region homes the cursor; put it back at the bottom.
+    send("\033[r\033[" + std::to_string(m_height) + ";1H\n");
+}
+
+TerminalRenderer& TerminalRenderer::screen() {
+    static TerminalRenderer renderer(STDOUT_FILENO);
+    return renderer;
+}
+
+void TerminalRenderer::draw(const std::string& frame) {
+    std::cout.flush();
+
+    int height = 0;
+    winsize size;
+    if (isatty(m_fd) && ioctl(m_fd, TIOCGWINSZ, &size) == 0) height = size.ws_row;
+
+    send(render(frame, height));
+}
+
+const std::string& TerminalRenderer::render(const std::string& frame, int height) {
+    split(frame);
+    m_out.clear();
+
+    int rows = static_cast<int>(m_next.size());
+    bool same_shape = height > 0 && height == m_height && m_next.size() == m_lines.size();
+    if (!same_shape || rows >= height) {
+        redraw(frame, height);
+    } else {
+        for (int r = 0; r < rows; ++r) {
+            if (m_lines[r] != m_next[r]) update_line(r + 1, m_lines[r], m_next[r]);
+        }
+        // Below the frame: clear what the last round printed there.
+        move_to(rows + 1, 1);
+        m_out += "\033[J";
+    }
+
+    m_lines.swap(m_next);
+    m_height = height;
+    return m_out;
+}
+
+// One string per line, without the newlines.
+void TerminalRenderer::split(const std::string& frame) {
+    std::size_t count = 0;
+    std::size_t start = 0;
+    while (start < frame.size()) {
+        std::size_t end = frame.find('\n', start);
+        if (end == std::string::npos) end = frame.size();
+        if (count == m_next.size()) m_next.emplace_back();
+        m_next[count++].assign(frame, start, end - start);
+        start = end + 1;
+    }
+    m_next.resize(count);
+}
+
+void TerminalRenderer::redraw(const std::string& frame, int height) {
+    if (m_scroll_region) m_out += "\033[r";
+    m_out += "\033[H\033[J";
+    m_out += frame;
+    m_scroll_region = false;
+
+    int rows = static_cast<int>(m_next.size());
+    if (height > 0 && rows < height) {
+        // Setting the region homes the cursor, so move back under the frame.
+        m_out += "\033[" + std::to_string(rows + 1) + ";" + std::to_string(height) + "r";
+        move_to(rows + 1, 1);
+        m_scroll_region = true;
+    }
+}
+
+void TerminalRenderer::update_line(int row, const std::string& was, const std::string& now) {
+    std::size_t n = now.size();
+    std::size_t w = was.size();
+    auto same = [&](std::size_t i) { return i < w && was[i] == now[i]; };
+
+    std::size_t i = 0;
+    while (i < n) {
+        if (same(i)) {
+            ++i;
+            continue;
+        }
+        // A changed run, carried over short unchanged stretches.
+        std::size_t end = i + 1;
+        while (end < n) {
+            std::size_t skip = end;
+            while (skip < n && same(skip)) ++skip;
+            if (skip == end) {
+                ++end;
+                continue;
+            }
+            if (skip == n || skip - end >= min_skip) break;
+            end = skip;
+        }
+        move_to(row, static_cast<int>(i) + 1);
+        m_out.append(now, i, end - i);
+        i = end;
+    }
+
+    if (w > n) {
+        move_to(row, static_cast<int>(n) + 1);
+        m_out += "\033[K";
+    }
+}
+
+void TerminalRenderer::move_to(int row, int col) {
+    m_out += "\033[";
+    m_out += std::to_string(row);
+    m_out += ';';
+    m_out += std::to_string(col);
+    m_out += 'H';
+}
+
+// One write() unless the terminal takes less than the whole frame.
+void TerminalRenderer::send(const std::string& bytes) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = ::write(m_fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    m_sent += bytes.size();
+}
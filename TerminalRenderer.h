@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Draws frames (a screenful of text, lines ending in '\n') on a terminal,
+// sending only what changed since the last frame.
+//
+// The first frame, and any frame after the terminal or the frame changed
+// size, clears the screen and is drawn whole. After that, each changed run
+// of characters goes out as a cursor move plus the new text. The frame stays
+// at the top of the screen: the lines under it become the terminal's
+// scrolling region, so whatever is printed after draw() (the turn
+// commentary) scrolls there without moving the board. Each frame is built in
+// one buffer and sent with one write().
+//
+// When the output isn't a terminal, or the frame is too tall for it, every
+// frame clears the screen and is drawn whole - still in one write.
+class TerminalRenderer {
+public:
+    explicit TerminalRenderer(int fd) : m_fd(fd) {}
+    ~TerminalRenderer();   // gives the terminal its whole screen back
+
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    // The renderer for standard output.
+    static TerminalRenderer& screen();
+
+    // Flushes std::cout first so earlier text lands above the frame.
+    void draw(const std::string& frame);
+
+    // The bytes draw() sends for a terminal `height` lines tall (0: not a
+    // terminal). Remembers the frame as being on screen.
+    const std::string& render(const std::string& frame, int height);
+
+    // Forget what is on screen; the next frame is drawn whole.
+    void reset() { m_lines.clear(); }
+
+    std::size_t bytes_sent() const { return m_sent; }
+
+private:
+    int m_fd;
+    int m_height = -1;                 // terminal height of the last frame
+    bool m_scroll_region = false;      // lines under the frame scroll on their own
+    std::vector<std::string> m_lines;  // what is on screen
+    std::vector<std::string> m_next;
+    std::string m_out;                 // the update being built
+    std::size_t m_sent = 0;
+
+    void split(const std::string& frame);
+    void redraw(const std::string& frame, int height);
+    void update_line(int row, const std::string& was, const std::string& now);
+    void move_to(int row, int col);
+    void send(const std::string& bytes);
+};
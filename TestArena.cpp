@@ -1,6 +1,32 @@
 #include "TestArena.h"
 #include "RadarObj.h"
+#include "ConsoleSink.h"
+#include "EventStream.h"
+#include "IsolatedRobot.h"
+#include "Replay.h"
+#include "Sweep.h"
+#include "TerminalRenderer.h"
+#include "Tournament.h"
 #include <iomanip>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Helper to record and print a test result
 bool TestArena::print_test_result(const std::string& test_name, bool condition) {
@@ -301,4 +327,2112 @@ void TestArena::test_radar_local() {
     ok &= (!fired);
 
     print_test_result("Radar local scan & no-target behavior", ok);
-}
\ No newline at end of file
+}
+// ----------------------------------------------------------
+// 9) Occupancy grid stays in sync through placement, moves and deaths
+// ----------------------------------------------------------
+void TestArena::test_occupancy_grid() {
+    bool ok = true;
+
+    Arena arena(10, 10);
+    JumperRobot mover;      // always moves right, 5 cells
+    ShooterRobot target(hammer, "Target");
+
+    arena.add_robot(&mover, 2, 2);
+    arena.add_robot(&target, 2, 5);
+
+    ok &= (arena.find_robot_at(2, 2) == 0);
+    ok &= (arena.find_robot_at(2, 5) == 1);
+    ok &= (arena.find_robot_at(3, 3) == -1);
+    ok &= (arena.find_robot_at(-1, 4) == -1);
+    ok &= (arena.get_cell_type(2, 5) == 'R');
+
+    // The mover stops in front of the other robot; its old cell is freed.
+    arena.handle_movement(arena.robots[0], 3, 5);
+    ok &= (arena.robots[0].row == 2 && arena.robots[0].col == 4);
+    ok &= (arena.find_robot_at(2, 2) == -1);
+    ok &= (arena.find_robot_at(2, 4) == 0);
+
+    // A dead robot still occupies its cell and reports as 'X'.
+    arena.robots[1].alive = false;
+    ok &= (arena.get_cell_type(2, 5) == 'X');
+    ok &= (arena.find_robot_at(2, 5) == 1);
+
+    print_test_result("Occupancy grid follows moves and deaths", ok);
+}
+
+// ----------------------------------------------------------
+// 10) Same seed, same game: obstacles, placement and damage rolls
+// ----------------------------------------------------------
+void TestArena::test_seeded_arena() {
+    bool ok = true;
+
+    Arena a(30, 30);
+    Arena b(30, 30);
+    a.set_event_sink(nullptr);
+    b.set_event_sink(nullptr);
+    a.set_seed(2025);
+    b.set_seed(2025);
+    a.load_obstacles();
+    b.load_obstacles();
+
+    for (int r = 0; r < 30; ++r)
+        for (int c = 0; c < 30; ++c)
+            ok &= (a.board(r, c) == b.board(r, c));
+
+    for (int i = 0; i < 100; ++i) {
+        int x = a.random_int(10, 40);
+        ok &= (x == b.random_int(10, 40));
+        ok &= (x >= 10 && x <= 40);
+    }
+
+    // A different seed should not lay out the same board.
+    Arena c(30, 30);
+    c.set_seed(2026);
+    c.load_obstacles();
+    bool same = true;
+    for (int r = 0; r < 30; ++r)
+        for (int col = 0; col < 30; ++col)
+            same &= (a.board(r, col) == c.board(r, col));
+    ok &= !same;
+
+    print_test_result("Seeded arenas replay the same random choices", ok);
+}
+
+// ----------------------------------------------------------
+// 11) Radar engine reports exactly what the cell-by-cell walk does
+// ----------------------------------------------------------
+void TestArena::test_radar_engine() {
+    bool ok = true;
+
+    // Wider than 64 columns so scans cross bitset words.
+    const int rows = 70;
+    const int cols = 130;
+    Arena arena(rows, cols);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(8);
+    arena.num_mounds = 900;
+    arena.num_pits = 300;
+    arena.num_flames = 300;
+    arena.load_obstacles();
+
+    std::vector<std::unique_ptr<JumperRobot>> bots;
+    for (int i = 0; i < 40; ++i) {
+        int r = arena.random_int(0, rows - 1);
+        int c = arena.random_int(0, cols - 1);
+        if (arena.find_robot_at(r, c) != -1) continue;
+        bots.push_back(std::make_unique<JumperRobot>());
+        arena.add_robot(bots.back().get(), r, c);
+        if (i % 3 == 0) arena.robots.back().alive = false;
+    }
+
+    std::vector<RadarObj> fast;
+    for (int r = 0; r < rows && ok; ++r) {
+        for (int c = 0; c < cols && ok; ++c) {
+            RobotInfo probe;
+            probe.row = r;
+            probe.col = c;
+            for (int dir = 0; dir <= 8; ++dir) {
+                arena.do_radar_scan(probe, dir, fast);
+
+                std::vector<RadarObj> slow;
+                RadarEngine::walk(rows, cols, r, c, dir,
+                    [&](int rr, int cc) { return arena.get_cell_type(rr, cc) != '.'; },
+                    [&](int rr, int cc) { slow.emplace_back(arena.get_cell_type(rr, cc), rr, cc); });
+
+                ok &= (fast.size() == slow.size());
+                for (std::size_t i = 0; ok && i < fast.size(); ++i) {
+                    ok &= (fast[i].m_type == slow[i].m_type &&
+                           fast[i].m_row == slow[i].m_row &&
+                           fast[i].m_col == slow[i].m_col);
+                }
+            }
+        }
+    }
+
+    // Moving a robot updates what the radar sees.
+    arena.robots[0].alive = true;
+    int r0 = arena.robots[0].row;
+    int c0 = arena.robots[0].col;
+    arena.move_robot(arena.robots[0], r0, c0);   // no-op move keeps it visible
+    ok &= arena.radar.occupied(r0, c0);
+
+    print_test_result("Radar engine matches the cell-by-cell scan", ok);
+}
+
+// ----------------------------------------------------------
+// 12) Cell planes agree with the board through moves and deaths
+// ----------------------------------------------------------
+void TestArena::test_cell_planes() {
+    bool ok = true;
+
+    const int rows = 40;
+    const int cols = 150;
+    Arena arena(rows, cols);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(9);
+    arena.num_mounds = 400;
+    arena.num_pits = 150;
+    arena.num_flames = 150;
+    arena.load_obstacles();
+
+    std::vector<std::unique_ptr<ShooterRobot>> bots;
+    for (int i = 0; i < 60; ++i) {
+        int r = arena.random_int(0, rows - 1);
+        int c = arena.random_int(0, cols - 1);
+        if (arena.get_cell_type(r, c) != '.') continue;
+        bots.push_back(std::make_unique<ShooterRobot>(grenade, "Bot"));
+        arena.add_robot(bots.back().get(), r, c);
+    }
+
+    // A grenade barrage kills some robots and leaves wrecks.
+    const int count = static_cast<int>(arena.robots.size());
+    for (int i = 0; i < 600; ++i) {
+        RobotInfo& shooter = arena.robots[i % count];
+        const RobotInfo& target = arena.robots[(i * 7 + 1) % (count / 3)];
+        arena.handle_shot(shooter, target.row, target.col);
+    }
+    // Some survivors move around.
+    for (RobotInfo& info : arena.robots) {
+        if (info.alive) arena.handle_movement(info, arena.random_int(1, 8), 3);
+    }
+
+    int alive = 0;
+    for (const RobotInfo& info : arena.robots) alive += info.alive;
+    ok &= (alive < (int)arena.robots.size());
+    ok &= (arena.planes.count(CellPlanes::robots) == alive);
+    ok &= (arena.planes.count(CellPlanes::wrecks) == (int)arena.robots.size() - alive);
+
+    // Obstacle planes follow the board, robot planes the occupancy grid (a
+    // robot can sit in a pit or on a flame).
+    auto matches = [&](CellPlanes::Plane p, int r, int c, bool expected) {
+        return arena.planes.test(p, r, c) == expected;
+    };
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            ok &= matches(CellPlanes::mounds, r, c, arena.board(r, c) == 'M');
+            ok &= matches(CellPlanes::pits, r, c, arena.board(r, c) == 'P');
+            ok &= matches(CellPlanes::flames, r, c, arena.board(r, c) == 'F');
+            ok &= matches(CellPlanes::robots, r, c, arena.get_cell_type(r, c) == 'R');
+            ok &= matches(CellPlanes::wrecks, r, c, arena.get_cell_type(r, c) == 'X');
+        }
+    }
+
+    // Row searches clip to the board and cross word boundaries.
+    const unsigned mounds = CellPlanes::bit(CellPlanes::mounds);
+    for (int r = 0; r < rows; ++r) {
+        int expected = -1;
+        for (int c = 60; c < cols && expected == -1; ++c) {
+            if (arena.board(r, c) == 'M') expected = c;
+        }
+        ok &= (arena.planes.next_in_row(mounds, r, 60, cols + 10) == expected);
+    }
+    ok &= (arena.planes.next_in_row(mounds, -1, 0, cols - 1) == -1);
+
+    print_test_result("Cell planes follow obstacles, moves and deaths", ok);
+}
+
+// ----------------------------------------------------------
+// 13) GridLine walks the cells the old double stepping did
+// ----------------------------------------------------------
+
+// The stepping handle_movement, railgun_line and flamethrower_cone used
+// before GridLine: add double increments, std::round every step.
+static std::vector<std::pair<int, int>> double_stepped_line(int r0, int c0, int r1, int c1,
+                                                           int count) {
+    std::vector<std::pair<int, int>> cells;
+    double delta_r = r1 - r0;
+    double delta_c = c1 - c0;
+    int steps = std::max(std::abs(r1 - r0), std::abs(c1 - c0));
+    double row = r0;
+    double col = c0;
+    for (int i = 0; i < count; ++i) {
+        row += delta_r / steps;
+        col += delta_c / steps;
+        cells.emplace_back((int)std::round(row), (int)std::round(col));
+    }
+    return cells;
+}
+
+static std::vector<std::pair<int, int>> grid_line_cells(int r0, int c0, int r1, int c1,
+                                                       int count) {
+    std::vector<std::pair<int, int>> cells;
+    GridLine line(r0, c0, r1, c1);
+    for (int i = 0; i < count; ++i) {
+        line.advance();
+        cells.emplace_back(line.row(), line.col());
+    }
+    return cells;
+}
+
+void TestArena::test_grid_line() {
+    bool ok = true;
+
+    // The spec's railgun example, carried on to the edge of a 10x10 board.
+    std::vector<std::pair<int, int>> expected = {
+        {3, 3}, {3, 4}, {4, 5}, {5, 6}, {5, 7}, {6, 8}, {7, 9}
+    };
+    ok &= (grid_line_cells(2, 2, 4, 5, 7) == expected);
+    ok &= (GridLine(2, 2, 4, 5).length() == 3);
+    ok &= (GridLine(6, 6, 6, 6).length() == 0);
+
+    // Every move a robot can make (speed 1-5, clamped at the edges) on a
+    // 12x12 board follows exactly the old path.
+    const int size = 12;
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) {
+            for (int dir = 1; dir <= 8; ++dir) {
+                for (int dist = 1; dist <= 5; ++dist) {
+                    int r1 = std::clamp(r + directions[dir].first * dist, 0, size - 1);
+                    int c1 = std::clamp(c + directions[dir].second * dist, 0, size - 1);
+                    int steps = std::max(std::abs(r1 - r), std::abs(c1 - c));
+                    if (steps == 0) continue;
+                    ok &= (grid_line_cells(r, c, r1, c1, steps) ==
+                           double_stepped_line(r, c, r1, c1, steps));
+                }
+            }
+        }
+    }
+
+    // Shots from every cell at every other cell of a 20x20 board, followed to
+    // the edge: the same cells, halves included.
+    const int board = 20;
+    for (int r0 = 0; r0 < board && ok; ++r0) {
+        for (int c0 = 0; c0 < board; ++c0) {
+            for (int r1 = 0; r1 < board; ++r1) {
+                for (int c1 = 0; c1 < board; ++c1) {
+                    if (r1 == r0 && c1 == c0) continue;
+                    ok &= (grid_line_cells(r0, c0, r1, c1, board) ==
+                           double_stepped_line(r0, c0, r1, c1, board));
+                }
+            }
+        }
+    }
+    // A half the old code rounded down by error: (0,0) through (1,12).
+    ok &= (grid_line_cells(0, 0, 1, 12, 6)[5] == std::make_pair(0, 6));
+
+    print_test_result("GridLine reproduces the movement and weapon paths", ok);
+}
+
+// ----------------------------------------------------------
+// 14) Cached shot paths land on the cells GridLine walks
+// ----------------------------------------------------------
+void TestArena::test_footprint_cache() {
+    bool ok = true;
+
+    // Every shooter and target on an odd-sized board, followed to the edge.
+    const int rows = 13;
+    const int cols = 21;
+    FootprintCache cache;
+    for (int r0 = 0; r0 < rows; ++r0) {
+        for (int c0 = 0; c0 < cols; ++c0) {
+            for (int r1 = 0; r1 < rows; ++r1) {
+                for (int c1 = 0; c1 < cols; ++c1) {
+                    if (r1 == r0 && c1 == c0) continue;
+                    std::span<const PathCell> path = cache.path(r1 - r0, c1 - c0, cols);
+                    GridLine line(r0, c0, r1, c1);
+                    int steps = line.length();
+                    double row = r0, col = c0;
+                    for (const PathCell& cell : path) {
+                        line.advance();
+                        row += static_cast<double>(r1 - r0) / steps;
+                        col += static_cast<double>(c1 - c0) / steps;
+                        ok &= (cell.row(r0, row) == line.row() && cell.col(c0, col) == line.col());
+                        if (line.row() < 0 || line.row() >= rows ||
+                            line.col() < 0 || line.col() >= cols) break;
+                    }
+                }
+            }
+        }
+    }
+    ok &= (cache.misses() == cache.paths());
+    ok &= (cache.hits() + cache.misses() ==
+           (std::uint64_t)rows * cols * (rows * cols - 1));
+
+    // Parallel shots share one entry.
+    FootprintCache counted;
+    counted.path(2, 3, 10);
+    counted.path(4, 6, 10);
+    counted.path(-2, -3, 10);
+    ok &= (counted.misses() == 2 && counted.hits() == 1 && counted.paths() == 2);
+
+    std::span<const PathCell> diagonal = counted.path(-3, 3, 10);
+    ok &= (diagonal.size() == 10 && diagonal[9].row(12, 2.0) == 2 && diagonal[9].col(0, 10.0) == 10);
+
+    // The cache only takes arenas whose every path fits its budget.
+    FootprintCache small(19 * 19 * 10);
+    ok &= small.covers(10);
+    ok &= !small.covers(11);
+    ok &= FootprintCache().covers(20);
+
+    print_test_result("Footprint cache matches GridLine and stays bounded", ok);
+}
+
+// ----------------------------------------------------------
+// 15) Replay files: header matches the arena, records chain to the end
+// ----------------------------------------------------------
+void TestArena::test_replay_recorder() {
+    bool ok = true;
+    const std::string path = "test_replay.rwr";
+
+    Arena arena(12, 12);
+    arena.set_seed(99);
+    arena.max_rounds = 40;
+    arena.load_obstacles();
+
+    // Four hammers next to each other fight it out; the jumper wanders.
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+    for (int i = 0; i < 4; ++i) {
+        arena.board(spots[i][0], spots[i][1]) = '.';
+        bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer" + std::to_string(i)));
+        arena.add_robot(bots.back().get(), spots[i][0], spots[i][1]);
+    }
+    arena.board(0, 0) = '.';
+    bots.push_back(std::make_unique<JumperRobot>());
+    arena.add_robot(bots.back().get(), 0, 0);
+
+    {
+        ReplayRecorder recorder;
+        ok &= recorder.open(path);
+        recorder.begin(arena);
+        arena.set_replay_recorder(&recorder);
+        arena.run();
+        recorder.close();
+        arena.set_replay_recorder(nullptr);
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path.c_str());
+
+    std::size_t pos = 0;
+    bool truncated = false;
+    auto byte = [&]() -> unsigned {
+        if (pos >= bytes.size()) { truncated = true; return 0; }
+        return bytes[pos++];
+    };
+    auto varint = [&]() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            unsigned b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return value;
+    };
+
+    for (char m : replay_magic) ok &= (byte() == static_cast<unsigned char>(m));
+    ok &= (byte() == replay_version);
+    ok &= (varint() == 12 && varint() == 12 && varint() == 40);
+    std::uint64_t seed = 0;
+    for (int i = 0; i < 8; ++i) seed |= static_cast<std::uint64_t>(byte()) << (8 * i);
+    ok &= (seed == 99);
+
+    ok &= (varint() == arena.robots.size());
+    for (const RobotInfo& info : arena.robots) {
+        std::string name;
+        for (std::uint64_t n = varint(); n > 0; --n) name += static_cast<char>(byte());
+        ok &= (name == info.robot->m_name);
+        ok &= (byte() == static_cast<unsigned char>(info.symbol));
+        for (int i = 0; i < 6; ++i) varint();   // row, col, health, armor, move, weapon
+    }
+
+    int obstacles = 0;
+    for (int r = 0; r < 12; ++r)
+        for (int c = 0; c < 12; ++c)
+            obstacles += (arena.board(r, c) != '.');
+    std::uint64_t listed = varint();
+    ok &= (listed == static_cast<std::uint64_t>(obstacles));
+    for (std::uint64_t i = 0; i < listed; ++i) {
+        int r = static_cast<int>(varint());
+        int c = static_cast<int>(varint());
+        ok &= (byte() == static_cast<unsigned char>(arena.board(r, c)));
+    }
+
+    // Walk the records by their lengths: they must end exactly at the end
+    // of the file, with game_over last.
+    int rounds = 0, deaths = 0, damage = 0;
+    unsigned last_kind = 0;
+    std::uint64_t last_result = 0;
+    while (pos < bytes.size() && !truncated) {
+        last_kind = byte();
+        std::size_t length = varint();
+        std::size_t end = pos + length;
+        if (last_kind == static_cast<unsigned>(ReplayRecord::round))  rounds++;
+        if (last_kind == static_cast<unsigned>(ReplayRecord::death))  deaths++;
+        if (last_kind == static_cast<unsigned>(ReplayRecord::damage)) damage++;
+        if (last_kind == static_cast<unsigned>(ReplayRecord::game_over)) last_result = varint();
+        pos = end;
+    }
+    ok &= !truncated && pos == bytes.size();
+    ok &= (last_kind == static_cast<unsigned>(ReplayRecord::game_over));
+    ok &= (last_result == static_cast<std::uint64_t>(arena.result()));
+    ok &= (rounds == arena.rounds_played());
+    ok &= (damage > 0);
+
+    int dead = 0;
+    for (const RobotInfo& info : arena.robots) dead += !info.alive;
+    ok &= (deaths == dead);
+
+    print_test_result("Replay file header and records match the game", ok);
+}
+
+// What every robot looked like at the start of each round.
+class SnapshotSink : public EventSink {
+public:
+    struct Robot {
+        int row, col, health, armor, move;
+        bool alive;
+        bool operator==(const Robot&) const = default;
+    };
+
+    std::vector<std::vector<Robot>> rounds;
+
+    static std::vector<Robot> take(const std::vector<RobotInfo>& robots) {
+        std::vector<Robot> shot;
+        for (const RobotInfo& info : robots) {
+            shot.push_back({ info.row, info.col, info.robot->get_health(),
+                             info.robot->get_armor(), info.robot->get_move_speed(), info.alive });
+        }
+        return shot;
+    }
+
+    void round_start(const Arena& arena, int) override {
+        rounds.push_back(take(arena.robot_infos()));
+    }
+};
+
+// ----------------------------------------------------------
+// 16) Replay player: every round it seeks to matches the game
+// ----------------------------------------------------------
+void TestArena::test_replay_player() {
+    bool ok = true;
+    const std::string path = "test_replay_player.rwr";
+
+    Arena arena(12, 12);
+    arena.set_seed(5);
+    arena.max_rounds = 40;
+
+    // A flame and a pit in the jumpers' way, a mound, and four hammers
+    // that fight until one is left.
+    auto obstacle = [&](int r, int c, char type) {
+        arena.board(r, c) = type;
+        arena.update_cell(r, c);
+    };
+    obstacle(0, 3, 'F');
+    obstacle(2, 4, 'P');
+    obstacle(9, 9, 'M');
+
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+    for (int i = 0; i < 4; ++i) {
+        bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer" + std::to_string(i)));
+        arena.add_robot(bots.back().get(), spots[i][0], spots[i][1]);
+    }
+    bots.push_back(std::make_unique<JumperRobot>());
+    arena.add_robot(bots.back().get(), 0, 0);
+    bots.push_back(std::make_unique<JumperRobot>());
+    arena.add_robot(bots.back().get(), 2, 0);
+
+    SnapshotSink snapshots;
+    {
+        ReplayRecorder recorder(4);
+        ok &= recorder.open(path);
+        recorder.begin(arena);
+        arena.set_event_sink(&snapshots);
+        arena.set_replay_recorder(&recorder);
+        arena.run();
+        recorder.close();
+        arena.set_event_sink(nullptr);
+        arena.set_replay_recorder(nullptr);
+    }
+    snapshots.rounds.push_back(SnapshotSink::take(arena.robots));
+
+    ReplayPlayer player;
+    ok &= player.load(path);
+    std::remove(path.c_str());
+    if (!ok) {
+        print_test_result("Replay player seeks to the recorded rounds", false);
+        return;
+    }
+
+    int rounds = player.rounds();
+    ok &= (rounds == arena.rounds_played());
+    ok &= (player.keyframes() == static_cast<std::size_t>((rounds - 1) / 4));
+    ok &= (player.result() == arena.result());
+
+    auto matches = [&](int round) {
+        player.seek(round);
+        return player.round() == round &&
+               SnapshotSink::take(player.arena().robot_infos()) == snapshots.rounds[round];
+    };
+
+    // Forward one round at a time, back again, then jumps all over.
+    for (int r = 0; r <= rounds; ++r) ok &= matches(r);
+    for (int r = rounds; r >= 0; --r) ok &= matches(r);
+    Rng jumps(6);
+    for (int i = 0; i < 100; ++i) ok &= matches(jumps.between(0, rounds));
+
+    // The finished board, wrecks included, looks like the arena's.
+    player.seek(rounds);
+    for (int r = 0; r < 12; ++r)
+        for (int c = 0; c < 12; ++c)
+            ok &= (player.arena().get_cell_type(r, c) == arena.get_cell_type(r, c));
+
+    // The game had to have something in it worth replaying.
+    const std::vector<SnapshotSink::Robot>& last = snapshots.rounds.back();
+    ok &= !last[0].alive || !last[1].alive;     // a hammer died
+    ok &= (last[4].health < 100);               // the jumper crossed the flame
+    ok &= (last[5].move == 0);                  // and the other fell in the pit
+
+    player.seek(rounds + 10);
+    ok &= (player.round() == rounds);
+
+    print_test_result("Replay player seeks to the recorded rounds", ok);
+}
+
+// Just enough of a terminal to check what TerminalRenderer sends: text,
+// newlines, cursor moves, clearing and a scrolling region.
+class VirtualTerminal {
+public:
+    VirtualTerminal(int height, int width)
+        : m_height(height), m_width(width), m_bottom(height - 1),
+          m_screen(height, std::string(width, ' ')) {}
+
+    void feed(const std::string& bytes) {
+        for (std::size_t i = 0; i < bytes.size(); ++i) {
+            char ch = bytes[i];
+            if (ch == '\033' && i + 1 < bytes.size() && bytes[i + 1] == '[') {
+                std::size_t end = i + 2;
+                while (end < bytes.size() && !std::isalpha(static_cast<unsigned char>(bytes[end]))) ++end;
+                control(bytes.substr(i + 2, end - i - 2), bytes[end]);
+                i = end;
+            } else if (ch == '\n') {
+                m_col = 0;
+                if (m_row == m_bottom) scroll();
+                else if (m_row < m_height - 1) ++m_row;
+            } else {
+                if (m_col < m_width) m_screen[m_row][m_col] = ch;
+                ++m_col;
+            }
+        }
+    }
+
+    // Screen line, without the trailing blanks.
+    std::string line(int row) const {
+        std::string text = m_screen[row];
+        text.erase(text.find_last_not_of(' ') + 1);
+        return text;
+    }
+
+private:
+    int m_height, m_width;
+    int m_row = 0, m_col = 0;
+    int m_top = 0, m_bottom;
+    std::vector<std::string> m_screen;
+
+    void scroll() {
+        m_screen.erase(m_screen.begin() + m_top);
+        m_screen.insert(m_screen.begin() + m_bottom, std::string(m_width, ' '));
+    }
+
+    void control(const std::string& args, char command) {
+        int a = 0, b = 0;
+        std::size_t semi = args.find(';');
+        if (!args.empty()) a = std::atoi(args.c_str());
+        if (semi != std::string::npos) b = std::atoi(args.c_str() + semi + 1);
+
+        if (command == 'H') {
+            m_row = a ? a - 1 : 0;
+            m_col = b ? b - 1 : 0;
+        } else if (command == 'J') {
+            m_screen[m_row].replace(m_col, std::string::npos, m_width - m_col, ' ');
+            for (int r = m_row + 1; r < m_height; ++r) m_screen[r].assign(m_width, ' ');
+        } else if (command == 'K') {
+            m_screen[m_row].replace(m_col, std::string::npos, m_width - m_col, ' ');
+        } else if (command == 'r') {
+            m_top = a ? a - 1 : 0;
+            m_bottom = b ? b - 1 : m_height - 1;
+            m_row = m_col = 0;
+        }
+    }
+};
+
+// ----------------------------------------------------------
+// 17) Terminal renderer: diffs leave the screen showing the new frame
+// ----------------------------------------------------------
+void TestArena::test_terminal_renderer() {
+    bool ok = true;
+
+    Arena arena(20, 20);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(21);
+    arena.load_obstacles();
+    JumperRobot jumper;
+    ShooterRobot hammer_bot(hammer, "Hammer");
+    arena.board(3, 3) = arena.board(10, 10) = '.';
+    arena.add_robot(&jumper, 3, 3);
+    arena.add_robot(&hammer_bot, 10, 10);
+
+    const int height = 70;
+    VirtualTerminal terminal(height, 120);
+    TerminalRenderer renderer(-1);
+
+    // True if the top of the screen is exactly the frame.
+    auto shows = [&](const std::string& frame) {
+        std::istringstream lines(frame);
+        std::string expected;
+        bool same = true;
+        for (int row = 0; std::getline(lines, expected); ++row) {
+            expected.erase(expected.find_last_not_of(' ') + 1);
+            same &= (terminal.line(row) == expected);
+        }
+        return same;
+    };
+
+    std::string first = arena.board_frame(0);
+    const std::string& full = renderer.render(first, height);
+    ok &= (full.rfind("\033[H\033[J" + first, 0) == 0);
+    terminal.feed(full);
+    ok &= shows(first);
+
+    // Commentary long enough to scroll the region under the board.
+    for (int i = 0; i < 40; ++i) terminal.feed("  commentary line " + std::to_string(i) + "\n");
+    ok &= shows(first);
+
+    // A move and some damage: a handful of cells and one stats line change.
+    arena.move_robot(arena.robots[0], 3, 8);
+    arena.robots[1].robot->take_damage(35);
+    std::string second = arena.board_frame(1);
+    const std::string& update = renderer.render(second, height);
+    ok &= (update.size() < 120);
+    terminal.feed(update);
+    ok &= shows(second);
+    ok &= terminal.line(static_cast<int>(std::count(second.begin(), second.end(), '\n'))).empty();
+
+    // Nothing changed but the round number.
+    std::string third = arena.board_frame(2);
+    ok &= (renderer.render(third, height).size() < 30);
+
+    // A death shortens nothing but adds "(DEAD)"; a shorter line must be
+    // cleared at its end.
+    arena.robots[1].robot->take_damage(100);
+    arena.mark_dead(arena.robots[1]);
+    std::string fourth = arena.board_frame(3);
+    terminal.feed(renderer.render(fourth, height));
+    ok &= shows(fourth);
+    arena.robots[0].robot->m_name = "J";
+    std::string fifth = arena.board_frame(4);
+    terminal.feed(renderer.render(fifth, height));
+    ok &= shows(fifth);
+
+    // Not a terminal, or a terminal too short for the frame: whole frames.
+    TerminalRenderer plain(-1);
+    ok &= (plain.render(first, 0) == "\033[H\033[J" + first);
+    ok &= (plain.render(second, 0) == "\033[H\033[J" + second);
+    ok &= (plain.render(second, 10).rfind("\033[H\033[J" + second, 0) == 0);
+
+    print_test_result("Terminal renderer redraws only what changed", ok);
+}
+
+// Counts events by the stream's event types.
+class EventCounter : public EventSink {
+public:
+    std::map<std::string, int> counts;
+
+    void turn_start(const RobotInfo&) override { counts["turn_start"]++; }
+    void radar(const RobotInfo&, int, const std::vector<RadarObj>&) override { counts["radar"]++; }
+    void move_rejected(const RobotInfo&, MoveProblem) override { counts["move"]++; }
+    void move_hazard(const RobotInfo&, char, int, int) override { counts["move"]++; }
+    void move_end(const RobotInfo&) override { counts["move"]++; }
+    void shot(const RobotInfo&, WeaponType, int, int) override { counts["shot"]++; }
+    void shot_rejected(const RobotInfo&, ShotProblem) override { counts["shot"]++; }
+    void damage(const RobotInfo&, int, int, int) override { counts["damage"]++; }
+    void death(const RobotInfo&) override { counts["death"]++; }
+    void overrun(const RobotInfo&, RobotCall, double) override { counts["overrun"]++; }
+    void crashed(const RobotInfo&, RobotCall) override { counts["crashed"]++; }
+    void game_over(GameResult, const RobotInfo*) override { counts["winner"]++; }
+};
+
+// ----------------------------------------------------------
+// 18) Event streams: JSONL and CSV carry every event of the game
+// ----------------------------------------------------------
+void TestArena::test_event_stream() {
+    bool ok = true;
+    const std::string jsonl_path = "test_events.jsonl";
+    const std::string csv_path = "test_events.csv";
+
+    Arena arena(12, 12);
+    arena.set_seed(99);
+    arena.max_rounds = 40;
+    arena.load_obstacles();
+
+    // The same hammer fight as the replay test; one name needs escaping.
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+    for (int i = 0; i < 4; ++i) {
+        arena.board(spots[i][0], spots[i][1]) = '.';
+        std::string name = i == 0 ? "Ham\"mer,0" : "Hammer" + std::to_string(i);
+        bots.push_back(std::make_unique<ShooterRobot>(hammer, name));
+        arena.add_robot(bots.back().get(), spots[i][0], spots[i][1]);
+    }
+    arena.board(0, 0) = '.';
+    bots.push_back(std::make_unique<JumperRobot>());
+    arena.add_robot(bots.back().get(), 0, 0);
+
+    EventCounter counter;
+    std::uint64_t jsonl_events = 0, csv_events = 0;
+    {
+        EventStream jsonl(EventFormat::jsonl);
+        EventStream csv(EventFormat::csv);
+        ok &= jsonl.open(jsonl_path) && csv.open(csv_path);
+        TeeSink streams(jsonl, csv);
+        TeeSink all(streams, counter);
+        arena.set_event_sink(&all);
+        arena.run();
+        arena.set_event_sink(nullptr);
+        jsonl.close();
+        csv.close();
+        jsonl_events = jsonl.events_written();
+        csv_events = csv.events_written();
+    }
+
+    std::uint64_t expected = 0;
+    for (const auto& [type, count] : counter.counts) expected += count;
+    ok &= (expected > 0 && jsonl_events == expected && csv_events == expected);
+    ok &= (counter.counts["damage"] > 0 && counter.counts["winner"] == 1);
+
+    // JSONL: one object per line, starting with its type.
+    std::map<std::string, int> seen;
+    std::string line, last;
+    bool escaped_name = false;
+    std::ifstream jsonl_in(jsonl_path);
+    while (std::getline(jsonl_in, line)) {
+        const std::string start = "{\"event\":\"";
+        if (line.rfind(start, 0) != 0 || line.back() != '}') {
+            ok = false;
+            break;
+        }
+        seen[line.substr(start.size(), line.find('"', start.size()) - start.size())]++;
+        escaped_name |= line.find("\"robot\":\"Ham\\\"mer,0\"") != std::string::npos;
+        last = line;
+    }
+    jsonl_in.close();
+    std::remove(jsonl_path.c_str());
+    ok &= (seen == counter.counts) && escaped_name;
+    std::string outcome = arena.result() == GameResult::winner ? "winner"
+                        : arena.result() == GameResult::draw   ? "draw" : "round_limit";
+    ok &= (last.find("\"event\":\"winner\"") != std::string::npos);
+    ok &= (last.find("\"outcome\":\"" + outcome + "\"") != std::string::npos);
+    ok &= (last.find("\"round\":" + std::to_string(arena.rounds_played())) != std::string::npos);
+
+    // CSV: a header, then the same number of fields on every row.
+    auto fields = [](const std::string& row) {
+        std::vector<std::string> out(1);
+        bool quoted = false;
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            char c = row[i];
+            if (quoted && c == '"' && i + 1 < row.size() && row[i + 1] == '"') {
+                out.back() += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = !quoted;
+            } else if (c == ',' && !quoted) {
+                out.emplace_back();
+            } else {
+                out.back() += c;
+            }
+        }
+        return out;
+    };
+
+    seen.clear();
+    escaped_name = false;
+    std::ifstream csv_in(csv_path);
+    std::getline(csv_in, line);
+    ok &= (line + "\n" == EventStream::csv_header());
+    std::size_t columns = fields(line).size();
+    while (std::getline(csv_in, line)) {
+        std::vector<std::string> row = fields(line);
+        ok &= (row.size() == columns);
+        seen[row[0]]++;
+        escaped_name |= row[2] == "Ham\"mer,0";
+    }
+    csv_in.close();
+    std::remove(csv_path.c_str());
+    ok &= (seen == counter.counts) && escaped_name;
+
+    // The writer keeps blocks in order when there are many of them.
+    {
+        BackgroundWriter writer;
+        ok &= writer.open(csv_path);
+        std::string expected_text;
+        for (int i = 0; i < 50000; ++i) {
+            std::string text = "line " + std::to_string(i) + "\n";
+            writer.block() += text;
+            writer.done_appending();
+            expected_text += text;
+        }
+        writer.close();
+        std::ifstream in(csv_path, std::ios::binary);
+        std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::remove(csv_path.c_str());
+        ok &= (expected_text.size() > 4 * BackgroundWriter::block_size);
+        ok &= (written == expected_text && writer.bytes_written() == expected_text.size());
+    }
+
+    // Buffers swapped out whole go in order with appended text, past the
+    // number of blocks the writer lets wait.
+    {
+        BackgroundWriter writer;
+        ok &= writer.open(csv_path);
+        std::string expected_text;
+        std::string buffer(1000, '\0');
+        for (std::size_t i = 0; i < 3 * BackgroundWriter::max_waiting; ++i) {
+            std::string text = "swapped " + std::to_string(i) + "\n";
+            ok &= (buffer.size() >= 1000);
+            std::copy(text.begin(), text.end(), buffer.begin());
+            writer.swap_out(buffer, text.size());
+            expected_text += text;
+            writer.block() += "appended\n";
+            expected_text += "appended\n";
+        }
+        writer.close();
+        std::ifstream in(csv_path, std::ios::binary);
+        std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::remove(csv_path.c_str());
+        ok &= (written == expected_text && writer.bytes_written() == expected_text.size());
+    }
+
+    // Formats are chosen by name.
+    EventFormat format;
+    ok &= parse_event_format("csv", format) && format == EventFormat::csv;
+    ok &= parse_event_format("jsonl", format) && format == EventFormat::jsonl;
+    ok &= !parse_event_format("xml", format);
+
+    print_test_result("Event streams carry every event as JSONL and CSV", ok);
+}
+
+// Thinks for a while over its radar results, then does what JumperBot does.
+class SlowThinker : public JumperRobot {
+public:
+    explicit SlowThinker(std::chrono::microseconds think) : m_think(think) {
+        m_name = "SlowThinker";
+    }
+
+    void process_radar_results(const std::vector<RadarObj>&) override {
+        auto until = std::chrono::steady_clock::now() + m_think;
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+
+private:
+    std::chrono::microseconds m_think;
+};
+
+// ----------------------------------------------------------
+// 19) Phase timing: every turn's phases are counted and timed
+// ----------------------------------------------------------
+void TestArena::test_phase_timing() {
+    bool ok = true;
+
+    // Histogram buckets cover every duration and read back at most 12.5% high.
+    for (std::uint64_t ns : { 0ull, 1ull, 15ull, 16ull, 17ull, 100ull, 1000ull,
+                              123456ull, 1ull << 40, ~0ull >> 1 }) {
+        std::uint64_t top = DurationHistogram::bucket_top(DurationHistogram::bucket(ns));
+        ok &= (top >= ns && top - ns <= ns / 8);
+    }
+    DurationHistogram h;
+    for (int ns = 1; ns <= 1000; ++ns) h.add(static_cast<std::uint64_t>(ns));
+    ok &= (h.count() == 1000 && h.total() == 500500 && h.max() == 1000);
+    ok &= (h.percentile(0.99) >= 990 && h.percentile(0.99) <= 1000);
+    ok &= (h.percentile(0.5) >= 500 && h.percentile(0.5) <= 563);
+
+    Arena arena(12, 12);
+    arena.set_seed(7);
+    arena.max_rounds = 20;
+    arena.load_obstacles();
+    ok &= (arena.phase_times() == nullptr);
+
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    const int spots[3][2] = { {5, 5}, {5, 6}, {9, 0} };
+    bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer0"));
+    bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer1"));
+    bots.push_back(std::make_unique<SlowThinker>(std::chrono::microseconds(300)));
+    for (int i = 0; i < 3; ++i) {
+        arena.board(spots[i][0], spots[i][1]) = '.';
+        arena.add_robot(bots[i].get(), spots[i][0], spots[i][1]);
+    }
+
+    EventCounter counter;
+    arena.set_event_sink(&counter);
+    arena.set_phase_timing(true);
+    arena.run();
+    arena.set_event_sink(nullptr);
+
+    const PhaseTimes* times = arena.phase_times();
+    ok &= (times != nullptr);
+    if (!times) {
+        print_test_result("Phase timing counts and times every turn", false);
+        return;
+    }
+
+    auto calls = [&](Phase phase) {
+        std::uint64_t n = 0;
+        for (int robot = 0; robot < 3; ++robot) n += times->of(robot, phase).count();
+        return n;
+    };
+    std::uint64_t turns = static_cast<std::uint64_t>(counter.counts["turn_start"]);
+    ok &= (turns > 0);
+    ok &= (calls(Phase::get_radar_direction) == turns);
+    ok &= (calls(Phase::radar_scan) == turns);
+    ok &= (calls(Phase::process_radar_results) == turns);
+    ok &= (calls(Phase::get_shot_location) == turns);
+    ok &= (calls(Phase::board_update) == turns);
+    ok &= (calls(Phase::output) == 2 * turns);
+    ok &= (calls(Phase::shot) + calls(Phase::movement) == turns);
+    ok &= (calls(Phase::get_move_direction) == calls(Phase::movement));
+    ok &= (calls(Phase::shot) > 0 && calls(Phase::movement) > 0);
+    ok &= (times->of(-1, Phase::output).count() ==
+           static_cast<std::uint64_t>(arena.rounds_played()));
+
+    // The slow robot stands out, and only in the phase where it is slow.
+    const DurationHistogram& slow = times->of(2, Phase::process_radar_results);
+    ok &= (slow.count() > 0 && slow.mean() >= 300000 && slow.percentile(0.99) >= 300000);
+    ok &= (times->of(2, Phase::get_radar_direction).mean() < 100000);
+    ok &= (times->of(0, Phase::process_radar_results).mean() < 100000);
+
+    std::ostringstream table;
+    times->print(table, arena.robot_infos());
+    ok &= (table.str().find("SlowThinker") != std::string::npos);
+    ok &= (table.str().find("process_radar_results") != std::string::npos);
+
+    arena.set_phase_timing(false);
+    ok &= (arena.phase_times() == nullptr);
+
+    // An isolated robot's take_turn covers the calls timed in its process.
+    Arena isolated_arena(12, 12);
+    isolated_arena.set_seed(7);
+    isolated_arena.max_rounds = 5;
+    isolated_arena.set_event_sink(nullptr);
+    std::unique_ptr<IsolatedRobot> thinker = IsolatedRobot::launch(
+        [] () -> RobotBase* { return new SlowThinker(std::chrono::microseconds(300)); },
+        std::chrono::microseconds(0));
+    ShooterRobot target(hammer, "Target");
+    ok &= (thinker != nullptr);
+    if (thinker) {
+        isolated_arena.add_robot(thinker.get(), 2, 2);
+        isolated_arena.add_robot(&target, 9, 9);
+        isolated_arena.set_phase_timing(true);
+        isolated_arena.run();
+        const PhaseTimes* split = isolated_arena.phase_times();
+        const DurationHistogram& whole = split->of(0, Phase::take_turn);
+        const DurationHistogram& thinking = split->of(0, Phase::process_radar_results);
+        ok &= (whole.count() == 5 && thinking.count() == 5);
+        ok &= (thinking.mean() >= 300000 && whole.total() >= thinking.total());
+        ok &= (split->of(0, Phase::get_shot_location).count() == 5);
+        ok &= (split->of(0, Phase::get_move_direction).count() ==
+               split->of(0, Phase::movement).count());
+    }
+
+    print_test_result("Phase timing counts and times every turn", ok);
+}
+
+// Spins in get_move_direction until released - a robot stuck in a loop -
+// or, with spin_for set, for that long - a robot that is only slow.
+class SpinningRobot : public JumperRobot {
+public:
+    std::atomic<bool> released{false};
+    std::atomic<bool> returned{false};
+    std::chrono::milliseconds spin_for{0};
+
+    SpinningRobot() { m_name = "Spinner"; }
+
+    void get_move_direction(int& direction, int& distance) override {
+        auto start = std::chrono::steady_clock::now();
+        while (!released) {
+            if (spin_for.count() > 0 && std::chrono::steady_clock::now() - start >= spin_for) break;
+        }
+        direction = 3;
+        distance = 1;
+        returned = true;
+    }
+};
+
+// ----------------------------------------------------------
+// 20) Call budget: a robot whose callback overruns is put out of the game
+// ----------------------------------------------------------
+void TestArena::test_call_budget() {
+    bool ok = true;
+
+    // An honest game plays the same with and without the watchdog.
+    auto play = [&](bool budget) {
+        Arena arena(12, 12);
+        arena.set_seed(99);
+        arena.max_rounds = 40;
+        arena.load_obstacles();
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+        for (int i = 0; i < 4; ++i) {
+            arena.board(spots[i][0], spots[i][1]) = '.';
+            bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer" + std::to_string(i)));
+            arena.add_robot(bots.back().get(), spots[i][0], spots[i][1]);
+        }
+        arena.board(0, 0) = '.';
+        bots.push_back(std::make_unique<JumperRobot>());
+        arena.add_robot(bots.back().get(), 0, 0);
+
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        if (budget) arena.set_call_budget(std::chrono::seconds(5));
+        arena.run();
+        for (const RobotInfo& info : arena.robot_infos()) ok &= (info.overruns == 0);
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> direct = play(false);
+    ok &= (direct.size() > 1 && play(true) == direct);
+
+    Arena arena(12, 12);
+    arena.set_seed(5);
+    arena.max_rounds = 10;
+    arena.load_obstacles();
+    JumperRobot jumper;
+    SpinningRobot spinner;
+    spinner.spin_for = std::chrono::milliseconds(60);
+    arena.board(2, 2) = arena.board(8, 2) = '.';
+    arena.add_robot(&jumper, 2, 2);
+    arena.add_robot(&spinner, 8, 2);
+
+    EventCounter counter;
+    std::ostringstream text;
+    ConsoleSink console;
+    std::streambuf* old = std::cout.rdbuf(text.rdbuf());
+    TeeSink both(counter, console);
+    arena.set_event_sink(&both);
+    arena.set_call_budget(std::chrono::milliseconds(20));
+    auto start = std::chrono::steady_clock::now();
+    arena.run();
+    auto took = std::chrono::steady_clock::now() - start;
+    std::cout.rdbuf(old);
+    arena.set_event_sink(nullptr);
+
+    // Out in its first turn, once its late call is back; the game carries
+    // on without it. (A call that never returns is test 21's: only an
+    // isolated robot can be stopped.)
+    const RobotInfo& slow = arena.robot_infos()[1];
+    ok &= (slow.overruns == 1 && !slow.alive && slow.died_in_round == 0);
+    ok &= (arena.robot_infos()[0].overruns == 0);
+    ok &= (counter.counts["death"] == 1);
+    ok &= (arena.result() == GameResult::winner && arena.winner() == &arena.robot_infos()[0]);
+    ok &= (took < std::chrono::seconds(2));
+    ok &= (text.str().find("Spinner took longer than 20 ms in get_move_direction") != std::string::npos);
+    ok &= spinner.returned.load();
+
+    print_test_result("Call budget puts a robot that overruns out of the game", ok);
+}
+
+// Dies in the middle of a callback, the way a robot with a bad pointer does.
+class CrashingRobot : public JumperRobot {
+public:
+    CrashingRobot() { m_name = "Crasher"; }
+
+    void get_move_direction(int&, int&) override { std::raise(SIGSEGV); }
+};
+
+// Tells the arena how many radar objects it was last given, as a distance.
+class RadarCounter : public JumperRobot {
+public:
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        m_seen = static_cast<int>(radar_results.size());
+        m_last = radar_results.empty() ? RadarObj('.', -1, -1) : radar_results.back();
+    }
+
+    void get_move_direction(int& direction, int& distance) override {
+        direction = m_last.m_type == 'R' ? m_last.m_row : 0;
+        distance = m_seen;
+    }
+
+private:
+    int m_seen = 0;
+    RadarObj m_last;
+};
+
+// ----------------------------------------------------------
+// 21) Isolation: robots in child processes play the same game, and one that
+//     crashes or hangs is put out of the game
+// ----------------------------------------------------------
+void TestArena::test_isolated_robots() {
+    bool ok = true;
+    using Factory = RobotBase* (*)();
+    Factory make_hammer = [] () -> RobotBase* { return new ShooterRobot(hammer, "Hammer"); };
+    Factory make_jumper = [] () -> RobotBase* { return new JumperRobot(); };
+
+    auto play = [&](bool isolated) {
+        Arena arena(12, 12);
+        arena.set_seed(99);
+        arena.max_rounds = 40;
+        arena.load_obstacles();
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        auto add = [&](Factory make, int r, int c) {
+            arena.board(r, c) = '.';
+            if (isolated) {
+                bots.push_back(IsolatedRobot::launch(make, std::chrono::microseconds(0)));
+            } else {
+                bots.emplace_back(make());
+            }
+            ok &= (bots.back() != nullptr);
+            if (bots.back()) arena.add_robot(bots.back().get(), r, c);
+        };
+        const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+        for (const auto& spot : spots) add(make_hammer, spot[0], spot[1]);
+        add(make_jumper, 0, 0);
+
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        arena.run();
+        for (const RobotInfo& info : arena.robot_infos()) {
+            ok &= ((info.isolated != nullptr) == isolated);
+            ok &= (info.crashes == 0 && info.overruns == 0);
+        }
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> direct = play(false);
+    ok &= (direct.size() > 1 && play(true) == direct);
+
+    // Radar results longer than one message arrive whole.
+    std::unique_ptr<IsolatedRobot> counter =
+        IsolatedRobot::launch([] () -> RobotBase* { return new RadarCounter(); },
+                              std::chrono::microseconds(0));
+    ok &= (counter != nullptr);
+    if (counter) {
+        std::vector<RadarObj> seen;
+        for (int i = 0; i < 70; ++i) seen.push_back(RadarObj(i == 69 ? 'R' : 'M', i, i));
+        counter->process_radar_results(seen);
+        int direction = 0, distance = 0;
+        counter->get_move_direction(direction, distance);
+        ok &= (distance == 70 && direction == 69);
+
+        // More chunks than the ring holds: the child, not yet woken for
+        // them, is woken when the ring fills.
+        seen.clear();
+        for (int i = 0; i < 1000; ++i) seen.push_back(RadarObj(i == 999 ? 'R' : 'M', i, i));
+        counter->process_radar_results(seen);
+        counter->get_move_direction(direction, distance);
+        ok &= (distance == 1000 && direction == 999);
+        ok &= (counter->failure() == RobotFailure::none);
+    }
+
+    // A crash and a hang each cost one robot; the game carries on. Isolated
+    // robots take whole turns, so that is where both happen.
+    Arena arena(12, 12);
+    arena.set_seed(5);
+    arena.max_rounds = 10;
+    arena.load_obstacles();
+    std::unique_ptr<IsolatedRobot> jumper = IsolatedRobot::launch(make_jumper, std::chrono::microseconds(0));
+    std::unique_ptr<IsolatedRobot> crasher =
+        IsolatedRobot::launch([] () -> RobotBase* { return new CrashingRobot(); },
+                              std::chrono::microseconds(0));
+    std::unique_ptr<IsolatedRobot> spinner =
+        IsolatedRobot::launch([] () -> RobotBase* { return new SpinningRobot(); },
+                              std::chrono::microseconds(0));
+    ok &= (jumper && crasher && spinner);
+    if (!ok) {
+        print_test_result("Isolated robots play the same game and fail alone", ok);
+        return;
+    }
+    arena.board(2, 2) = arena.board(5, 2) = arena.board(8, 2) = '.';
+    arena.add_robot(jumper.get(), 2, 2);
+    arena.add_robot(crasher.get(), 5, 2);
+    arena.add_robot(spinner.get(), 8, 2);
+
+    EventCounter events;
+    std::ostringstream text;
+    ConsoleSink console;
+    std::streambuf* old = std::cout.rdbuf(text.rdbuf());
+    TeeSink both(events, console);
+    arena.set_event_sink(&both);
+    arena.set_call_budget(std::chrono::milliseconds(20));
+    auto start = std::chrono::steady_clock::now();
+    arena.run();
+    auto took = std::chrono::steady_clock::now() - start;
+    std::cout.rdbuf(old);
+    arena.set_event_sink(nullptr);
+
+    const RobotInfo& crashed = arena.robot_infos()[1];
+    const RobotInfo& stuck = arena.robot_infos()[2];
+    ok &= (crashed.crashes == 1 && crashed.overruns == 0 && !crashed.alive && crashed.died_in_round == 0);
+    ok &= (crasher->failure() == RobotFailure::crashed);
+    ok &= (stuck.overruns == 1 && stuck.crashes == 0 && !stuck.alive && stuck.died_in_round == 0);
+    ok &= (spinner->failure() == RobotFailure::overrun);
+    ok &= (events.counts["crashed"] == 1 && events.counts["overrun"] == 1 && events.counts["death"] == 2);
+    ok &= (arena.result() == GameResult::winner && arena.winner() == &arena.robot_infos()[0]);
+    ok &= (took < std::chrono::seconds(2));
+    ok &= (text.str().find("Crasher crashed in take_turn") != std::string::npos);
+    ok &= (text.str().find("Spinner took longer than 20 ms in take_turn") != std::string::npos);
+
+    // A failed robot answers at once and asks for nothing.
+    int direction = 1, distance = 1;
+    crasher->get_move_direction(direction, distance);
+    ok &= (direction == 0 && distance == 0);
+
+    print_test_result("Isolated robots play the same game and fail alone", ok);
+}
+
+// ShooterRobot written against take_turn.
+class BatchedShooter : public BatchedRobot {
+public:
+    explicit BatchedShooter(const std::string& name) : BatchedRobot(5, 3, hammer) {
+        m_name = name;
+        m_character = 'H';
+        set_boundaries(0, 0);
+    }
+
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+
+    TurnAction take_turn(const std::vector<RadarObj>& radar_results) override {
+        TurnAction action;
+        if (!radar_results.empty()) {
+            action.shoots = true;
+            action.shot_row = radar_results[0].m_row;
+            action.shot_col = radar_results[0].m_col;
+        }
+        return action;
+    }
+};
+
+// ----------------------------------------------------------
+// 22) Turn robots: take_turn plays the same game as the separate callbacks
+// ----------------------------------------------------------
+void TestArena::test_turn_robots() {
+    bool ok = true;
+
+    // The adapter makes the same calls the arena would.
+    ShooterRobot legacy(hammer, "Hammer");
+    LegacyTurns turns(legacy);
+    TurnAction action = turns.take_turn({ RadarObj('R', 3, 4) });
+    ok &= (action.shoots && action.shot_row == 3 && action.shot_col == 4);
+    action = turns.take_turn({});
+    ok &= (!action.shoots && action.move_direction == 0 && action.move_distance == 0);
+
+    // A batched robot still answers the separate callbacks.
+    BatchedShooter batched("Hammer");
+    int row = 0, col = 0;
+    batched.process_radar_results({ RadarObj('R', 7, 2) });
+    ok &= (batched.get_shot_location(row, col) && row == 7 && col == 2);
+
+    auto play = [&](bool batched_bots, bool budget) {
+        Arena arena(12, 12);
+        arena.set_seed(99);
+        arena.max_rounds = 40;
+        arena.load_obstacles();
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        const int spots[4][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6} };
+        for (const auto& spot : spots) {
+            arena.board(spot[0], spot[1]) = '.';
+            if (batched_bots) bots.push_back(std::make_unique<BatchedShooter>("Hammer"));
+            else              bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer"));
+            arena.add_robot(bots.back().get(), spot[0], spot[1]);
+        }
+        arena.board(0, 0) = '.';
+        bots.push_back(std::make_unique<JumperRobot>());
+        arena.add_robot(bots.back().get(), 0, 0);
+
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        arena.set_phase_timing(true);
+        if (budget) arena.set_call_budget(std::chrono::seconds(5));
+        arena.run();
+
+        // Batched robots show up as one take_turn per turn.
+        const PhaseTimes& times = *arena.phase_times();
+        for (int i = 0; i < 4; ++i) {
+            ok &= ((arena.robot_infos()[i].turns != nullptr) == batched_bots);
+            ok &= ((times.of(i, Phase::take_turn).count() > 0) == batched_bots);
+            ok &= ((times.of(i, Phase::process_radar_results).count() > 0) != batched_bots);
+        }
+        ok &= (arena.robot_infos()[4].turns == nullptr);
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> direct = play(false, false);
+    ok &= (direct.size() > 1);
+    ok &= (play(true, false) == direct);
+    ok &= (play(true, true) == direct);
+
+    print_test_result("Turn robots play the same game through take_turn", ok);
+}
+
+// ----------------------------------------------------------
+// 23) Simultaneous turns: everyone decides on the same board, the same game
+//     on any number of threads
+// ----------------------------------------------------------
+void TestArena::test_simultaneous_turns() {
+    bool ok = true;
+
+    // The jumper moves away first; the hammer decided while it was still
+    // next door, so in simultaneous mode it swings at an empty cell.
+    auto swings = [&](bool simultaneous) {
+        Arena arena(12, 12);
+        arena.max_rounds = 1;
+        JumperRobot jumper;
+        ShooterRobot hammer_bot(hammer, "Hammer");
+        arena.add_robot(&jumper, 2, 2);
+        arena.add_robot(&hammer_bot, 2, 1);
+        EventCounter counter;
+        arena.set_event_sink(&counter);
+        arena.set_simultaneous(simultaneous, 2);
+        arena.run();
+        return std::make_pair(counter.counts["shot"], counter.counts["damage"]);
+    };
+    ok &= (swings(false) == std::make_pair(0, 0));
+    // The swing and its "nothing there" both count as shots.
+    ok &= (swings(true) == std::make_pair(2, 0));
+
+    auto play = [&](unsigned int threads, bool budget) {
+        Arena arena(12, 12);
+        arena.set_seed(99);
+        arena.max_rounds = 40;
+        arena.load_obstacles();
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        const int spots[6][2] = { {5, 5}, {5, 6}, {6, 5}, {6, 6}, {7, 5}, {7, 6} };
+        for (const auto& spot : spots) {
+            arena.board(spot[0], spot[1]) = '.';
+            bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer"));
+            arena.add_robot(bots.back().get(), spot[0], spot[1]);
+        }
+        arena.board(0, 0) = '.';
+        bots.push_back(std::make_unique<JumperRobot>());
+        arena.add_robot(bots.back().get(), 0, 0);
+
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        arena.set_simultaneous(true, threads);
+        arena.set_phase_timing(true);
+        if (budget) arena.set_call_budget(std::chrono::seconds(5));
+        arena.run();
+        ok &= (arena.phase_times()->of(0, Phase::radar_scan).count() > 0);
+        ok &= (arena.phase_times()->of(0, Phase::process_radar_results).count() > 0);
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> one = play(1, false);
+    ok &= (one.size() > 1);
+    ok &= (play(4, false) == one);
+    ok &= (play(4, false) == one);
+    ok &= (play(3, true) == one);
+
+    // With a budget, a robot that overruns on a pool thread is out and the
+    // rest carry on.
+    Arena arena(12, 12);
+    arena.max_rounds = 10;
+    JumperRobot jumper;
+    SpinningRobot spinner;
+    spinner.spin_for = std::chrono::milliseconds(60);
+    arena.add_robot(&jumper, 2, 2);
+    arena.add_robot(&spinner, 8, 2);
+    EventCounter counter;
+    arena.set_event_sink(&counter);
+    arena.set_simultaneous(true, 2);
+    arena.set_call_budget(std::chrono::milliseconds(20));
+    arena.run();
+    const RobotInfo& stuck = arena.robot_infos()[1];
+    ok &= (stuck.overruns == 1 && !stuck.alive && stuck.died_in_round == 0);
+    ok &= (counter.counts["overrun"] == 1 && counter.counts["death"] == 1);
+    ok &= (arena.result() == GameResult::winner && arena.winner() == &arena.robot_infos()[0]);
+    ok &= spinner.returned.load();
+
+    print_test_result("Simultaneous turns decide on one board, the same on any thread count", ok);
+}
+
+// ----------------------------------------------------------
+// 24) Task scheduler: idle workers steal, workers waiting on their own jobs
+//     help run them, and an arena can decide turns on a shared scheduler
+// ----------------------------------------------------------
+void TestArena::test_task_scheduler() {
+    bool ok = true;
+
+    // One job fans out 40 sleepy jobs onto its own worker's deque and waits
+    // for them; the other workers have nothing else to do but steal.
+    {
+        TaskScheduler scheduler(4);
+        std::atomic<int> ran{0};
+        scheduler.submit([&] {
+            TaskGroup fan_out;
+            for (int i = 0; i < 40; ++i) {
+                scheduler.submit(fan_out, [&] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    ran++;
+                });
+            }
+            scheduler.wait(fan_out);
+        });
+        scheduler.wait_idle();
+        ok &= (ran == 40);
+
+        std::vector<WorkerStats> stats = scheduler.worker_stats();
+        std::uint64_t tasks = 0, stolen = 0;
+        for (const WorkerStats& s : stats) {
+            tasks += s.tasks;
+            stolen += s.stolen;
+            ok &= (s.busy <= s.elapsed);
+        }
+        ok &= (stats.size() == 4 && tasks == 41 && stolen > 0);
+
+        scheduler.reset_stats();
+        for (const WorkerStats& s : scheduler.worker_stats()) {
+            ok &= (s.tasks == 0 && s.stolen == 0 && s.busy.count() == 0);
+        }
+    }
+
+    // With a single worker, a job waiting on jobs it submitted runs them
+    // itself instead of waiting forever.
+    {
+        TaskScheduler scheduler(1);
+        int sum = 0;
+        scheduler.submit([&] {
+            TaskGroup inner;
+            std::vector<int> parts(10, 0);
+            for (int i = 0; i < 10; ++i) {
+                scheduler.submit(inner, [&parts, i] { parts[i] = i; });
+            }
+            scheduler.wait(inner);
+            for (int part : parts) sum += part;
+        });
+        scheduler.wait_idle();
+        ok &= (sum == 45);
+        ok &= (scheduler.worker_stats()[0].tasks == 11);
+    }
+
+    // Several games deciding their turns on one shared scheduler play the
+    // same as one game deciding on its own.
+    auto play = [&](TaskScheduler* scheduler) {
+        Arena arena(12, 12);
+        arena.set_seed(7);
+        arena.max_rounds = 30;
+        arena.load_obstacles();
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        const int spots[4][2] = { {3, 3}, {3, 4}, {8, 8}, {8, 9} };
+        for (const auto& spot : spots) {
+            arena.board(spot[0], spot[1]) = '.';
+            bots.push_back(std::make_unique<ShooterRobot>(hammer, "Hammer"));
+            arena.add_robot(bots.back().get(), spot[0], spot[1]);
+        }
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        arena.set_simultaneous(true, 1);
+        arena.set_scheduler(scheduler);
+        arena.run();
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> alone = play(nullptr);
+    ok &= (alone.size() > 1);
+    {
+        TaskScheduler scheduler(3);
+        std::vector<std::vector<std::vector<SnapshotSink::Robot>>> games(4);
+        for (std::size_t g = 0; g < games.size(); ++g) {
+            scheduler.submit([&, g] { games[g] = play(&scheduler); });
+        }
+        scheduler.wait_idle();
+        for (const auto& game : games) ok &= (game == alone);
+    }
+
+    print_test_result("Task scheduler steals, helps while waiting, and runs shared games", ok);
+}
+
+// ----------------------------------------------------------
+// 25) Map files: a saved board loads back as it was, plays the same game,
+//     and bad files are turned down
+// ----------------------------------------------------------
+void TestArena::test_map_files() {
+    bool ok = true;
+    const std::string path = "test_map.rwm";
+
+    Arena original(30, 41);
+    original.set_seed(5);
+    original.num_mounds = 60;
+    original.num_pits = 30;
+    original.num_flames = 30;
+    original.load_obstacles();
+    ok &= original.save_map(path);
+
+    Arena mapped;
+    ok &= mapped.load_map(path);
+    ok &= (mapped.map_file != nullptr && mapped.rows == 30 && mapped.cols == 41);
+    bool same_cells = true;
+    for (int r = 0; r < 30; ++r) {
+        for (int c = 0; c < 41; ++c) {
+            same_cells &= (mapped.board(r, c) == original.board(r, c));
+            same_cells &= (mapped.radar.occupied(r, c) == original.radar.occupied(r, c));
+            for (int p = 0; p < CellPlanes::plane_count; ++p) {
+                auto plane = static_cast<CellPlanes::Plane>(p);
+                same_cells &= (mapped.planes.test(plane, r, c) == original.planes.test(plane, r, c));
+            }
+            same_cells &= (mapped.find_robot_at(r, c) == -1);
+        }
+    }
+    ok &= same_cells;
+
+    // The same robots on the same seed play the same game on either board.
+    auto play = [&](Arena& arena) {
+        arena.set_seed(11);
+        arena.max_rounds = 40;
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        const int spots[4][2] = { {2, 2}, {2, 3}, {20, 30}, {21, 30} };
+        for (const auto& spot : spots) {
+            arena.board(spot[0], spot[1]) = '.';
+            arena.update_cell(spot[0], spot[1]);
+            bots.push_back(std::make_unique<ShooterRobot>(railgun, "Rail"));
+            arena.add_robot(bots.back().get(), spot[0], spot[1]);
+        }
+        SnapshotSink snapshots;
+        arena.set_event_sink(&snapshots);
+        arena.run();
+        return snapshots.rounds;
+    };
+    std::vector<std::vector<SnapshotSink::Robot>> on_original = play(original);
+    ok &= (on_original.size() > 1);
+    ok &= (play(mapped) == on_original);
+
+    // The game wrote to its private copy only: the file still has no robots.
+    Arena again;
+    ok &= again.load_map(path);
+    bool file_untouched = true;
+    for (int r = 0; r < 30; ++r) {
+        for (int c = 0; c < 41; ++c) {
+            bool obstacle = again.board(r, c) != '.';
+            file_untouched &= (again.radar.occupied(r, c) == obstacle);
+        }
+    }
+    ok &= file_untouched;
+
+    // A fresh board drops the map.
+    again.configure(ArenaConfig());
+    ok &= (again.map_file == nullptr && again.rows == 20 && again.board(0, 0) == '.');
+
+    // Bad files: missing, short, foreign, or with sections that don't add up.
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto loads = [&](const std::string& contents) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << contents;
+        }
+        Arena arena;
+        return arena.load_map(path);
+    };
+    ok &= loads(bytes);
+    ok &= !loads(bytes.substr(0, 20));
+    ok &= !loads(bytes.substr(0, bytes.size() - 8));
+    std::string foreign = bytes;
+    foreign[0] = 'X';
+    ok &= !loads(foreign);
+    std::string resized = bytes;
+    resized[12] = static_cast<char>(0xff);   // rows, low byte
+    ok &= !loads(resized);
+    // Cells and bitsets that disagree, or a cell that isn't an obstacle:
+    // any changed byte fails the checksum.
+    MapHeader header;
+    std::memcpy(&header, bytes.data(), sizeof header);
+    std::string bad_cell = bytes;
+    bad_cell[header.cells_offset] = 'Z';
+    ok &= !loads(bad_cell);
+    std::string moved = bytes;
+    char& first = moved[header.cells_offset];
+    first = (first == '.') ? 'M' : '.';
+    ok &= !loads(moved);
+    std::string bad_bits = bytes;
+    bad_bits[header.radar_offset] ^= 1;
+    ok &= !loads(bad_bits);
+    std::string padding = bytes;
+    padding[header.planes_offset - 1] = 'M';
+    ok &= !loads(padding);
+    // A map of the previous version is turned down, not misread.
+    std::string old_version = bytes;
+    old_version[6] = '1';
+    ok &= !loads(old_version);
+    std::remove(path.c_str());
+    Arena missing;
+    ok &= !missing.load_map(path);
+
+    print_test_result("Map files load straight into the board and play the same game", ok);
+}
+
+static RobotBase* make_jumper() { return new JumperRobot; }
+
+// ----------------------------------------------------------
+// 26) Placement: obstacles and robots fill a board to the last cell, and
+//     counts that can't fit are turned down before anything is placed
+// ----------------------------------------------------------
+void TestArena::test_placement() {
+    bool ok = true;
+
+    // The shuffle deals every cell exactly once.
+    CellShuffle shuffle;
+    for (std::uint32_t cell = 0; cell < 1000; ++cell) shuffle.add(cell);
+    Rng rng(3);
+    std::vector<int> seen(1000, 0);
+    for (int i = 0; i < 1000; ++i) seen[shuffle.draw(rng)]++;
+    ok &= (shuffle.remaining() == 0);
+    ok &= std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; });
+
+    // Obstacles fill the board exactly, and the same seed fills it the
+    // same way.
+    auto full_board = [&](std::uint64_t seed) {
+        Arena arena(10, 10);
+        arena.set_seed(seed);
+        arena.num_mounds = 40;
+        arena.num_pits = 30;
+        arena.num_flames = 30;
+        ok &= arena.load_obstacles();
+        ok &= (arena.free_cells() == 0);
+        int r, c;
+        ok &= !arena.take_free_cell(r, c);
+        ok &= (arena.planes.count(CellPlanes::mounds) == 40 &&
+               arena.planes.count(CellPlanes::pits) == 30 &&
+               arena.planes.count(CellPlanes::flames) == 30);
+        return std::string(arena.board.data(), arena.board.size());
+    };
+    ok &= (full_board(8) == full_board(8));
+    ok &= (full_board(8) != full_board(9));
+
+    // One too many, or a negative count, places nothing.
+    Arena crowded(10, 10);
+    crowded.num_mounds = 50;
+    crowded.num_pits = 50;
+    crowded.num_flames = 1;
+    ok &= !crowded.load_obstacles();
+    crowded.num_flames = -1;
+    ok &= !crowded.load_obstacles();
+    ok &= (crowded.free_cells() == 100);
+    ok &= (std::count(crowded.board.data(), crowded.board.data() + crowded.board.size(), '.') == 100);
+
+    // Cells taken some other way are skipped: a robot put down by hand and
+    // 98 obstacles leave exactly one cell, and a roster of two won't fit.
+    Arena nearly(10, 10);
+    JumperRobot by_hand;
+    nearly.add_robot(&by_hand, 4, 4);
+    nearly.num_mounds = 98;
+    nearly.num_pits = 0;
+    nearly.num_flames = 0;
+    ok &= nearly.load_obstacles();
+    ok &= (nearly.free_cells() == 1);
+
+    std::vector<RobotLibrary> roster(2);
+    for (RobotLibrary& library : roster) {
+        library.name = "Jumper";
+        library.create_robot = make_jumper;
+    }
+    ok &= !nearly.spawn_robots(roster);
+    ok &= (nearly.robots.size() == 1);
+    roster.pop_back();
+    ok &= nearly.spawn_robots(roster);
+    ok &= (nearly.robots.size() == 2 && nearly.free_cells() == 0);
+    ok &= (nearly.board(nearly.robots[1].row, nearly.robots[1].col) == '.');
+
+    print_test_result("Placement fills the board exactly and turns down what can't fit", ok);
+}
+
+// ----------------------------------------------------------
+// 27) Sweeps: a keyed file declares a grid of configurations, bad files
+//     and rosters are turned down, and every configuration gets its stats
+// ----------------------------------------------------------
+void TestArena::test_sweeps() {
+    bool ok = true;
+
+    auto read = [](const std::string& text, SweepPlan& plan) {
+        std::istringstream in(text);
+        return read_sweep(in, "test.sweep", plan);
+    };
+
+    SweepPlan plan;
+    ok &= read("# two sizes, two densities, two rosters\n"
+               "size = 20x20, 40x60\n"
+               "density = 0.05, 0.1\n"
+               "  max_rounds = 7  \n"
+               "\n"
+               "roster = *, Hopper Jumper\n"
+               "games = 3\n"
+               "seed = 12\n"
+               "output = grid.csv\n", plan);
+    ok &= (plan.configs.size() == 8 && plan.games == 3 && plan.has_seed && plan.seed == 12 &&
+           plan.output == "grid.csv");
+    if (plan.configs.size() == 8) {
+        const SweepConfig& first = plan.configs[0];
+        ok &= (first.arena.rows == 20 && first.arena.cols == 20 && first.arena.max_rounds == 7);
+        ok &= (first.arena.num_mounds == 10 && first.arena.num_pits == 5 && first.arena.num_flames == 5);
+        ok &= first.roster.empty();
+        ok &= (plan.configs[1].roster == std::vector<std::string>{ "Hopper", "Jumper" });
+        const SweepConfig& last = plan.configs[7];
+        ok &= (last.arena.rows == 40 && last.arena.cols == 60);
+        ok &= (last.arena.num_mounds == 120 && last.arena.num_pits == 60 && last.arena.num_flames == 60);
+    }
+
+    // The mix splits the obstacles without losing any to rounding; no
+    // density keeps the usual counts.
+    ok &= read("size = 10x10\ndensity = 0.1\nmix = 1:1:1\n", plan);
+    ok &= (plan.configs.size() == 1 && plan.configs[0].arena.num_mounds == 3 &&
+           plan.configs[0].arena.num_pits == 4 && plan.configs[0].arena.num_flames == 3);
+    ok &= read("max_rounds = 50, 60\n", plan);
+    ok &= (plan.configs.size() == 2 && plan.configs[1].arena.max_rounds == 60 &&
+           plan.configs[1].arena.num_mounds == ArenaConfig().num_mounds && !plan.has_seed);
+
+    // Bad files leave the plan as it was.
+    for (const char* bad : { "size = 5x20\n", "size = 20\n", "density = 1.5\n", "density = 0.1,\n",
+                             "mix = 1:1\n", "mix = 0:0:0\n", "max_rounds = 0\n", "games = many\n",
+                             "seed = -1\n", "roster = * Jumper\n", "roster = Jumper Jumper\n",
+                             "colour = red\n", "size 20x20\n", "games = 2\ngames = 3\n" }) {
+        ok &= !read(bad, plan);
+    }
+    ok &= (plan.configs.size() == 2);
+
+    std::vector<RobotLibrary> libraries(2);
+    libraries[0].name = "Hopper";
+    libraries[1].name = "Jumper";
+    for (RobotLibrary& library : libraries) library.create_robot = make_jumper;
+
+    ok &= read("roster = Jumper Nobody\n", plan);
+    ok &= !Sweep(plan, libraries).check();
+    ok &= read("size = 10x10\ndensity = 0.99\n", plan);
+    ok &= !Sweep(plan, libraries).check();
+
+    ok &= read("size = 10x10, 12x12\nmax_rounds = 5\ngames = 2\nseed = 4\n", plan);
+    Sweep sweep(plan, libraries);
+    std::ostringstream progress;
+    ok &= sweep.run(progress, 2);
+    ok &= (sweep.results().size() == 2);
+    for (const SweepResult& result : sweep.results()) {
+        ok &= (result.games == 2 && result.stats.size() == 2);
+        ok &= (result.average_rounds >= 1.0 && result.average_rounds <= 5.0);
+        for (const TournamentStats& t : result.stats) {
+            ok &= (t.games == 2 && t.wins + t.draws + t.losses == 2);
+        }
+    }
+    ok &= (sweep.results()[1].config.arena.rows == 12);
+
+    std::ostringstream csv;
+    sweep.write_csv(csv);
+    std::istringstream rows(csv.str());
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(rows, line)) lines.push_back(line);
+    ok &= (lines.size() == 5 && lines[0].rfind("config,rows,cols,", 0) == 0);
+    ok &= (lines.size() == 5 && lines[4].rfind("2,12,12,10,5,5,", 0) == 0 &&
+           lines[4].find(",Hopper Jumper,2,") != std::string::npos);
+
+    // A malformed config.txt keeps the defaults from the bad field on.
+    const std::string path = "test_config.txt";
+    {
+        std::ofstream out(path);
+        out << "30 31 x 1 1 50 0\n";
+    }
+    ArenaConfig config;
+    ok &= read_config(path, config);
+    ok &= (config.rows == 30 && config.cols == 31 && config.num_mounds == ArenaConfig().num_mounds &&
+           config.max_rounds == ArenaConfig().max_rounds);
+    std::remove(path.c_str());
+
+    print_test_result("Sweep files declare a grid of configurations, each with its own stats", ok);
+}
+
+// ----------------------------------------------------------
+// 28) Grid: row-major cells, at() throws outside the board and only there
+// ----------------------------------------------------------
+void TestArena::test_grid_bounds() {
+    bool ok = true;
+
+    Grid<int> grid(3, 5, 7);
+    ok &= (grid.rows() == 3 && grid.cols() == 5 && grid.size() == 15);
+    ok &= std::all_of(grid.data(), grid.data() + grid.size(), [](int v) { return v == 7; });
+    grid(2, 4) = 42;
+    ok &= (grid.index(2, 4) == 14 && grid.data()[14] == 42 && grid.row(2)[4] == 42);
+
+    auto throws = [&](int r, int c) {
+        try {
+            grid.at(r, c);
+        } catch (const std::out_of_range&) {
+            return true;
+        }
+        return false;
+    };
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 5; ++c)
+            ok &= !throws(r, c);
+    ok &= (grid.at(2, 4) == 42);
+    for (const auto& [r, c] : { std::pair{ -1, 0 }, std::pair{ 0, -1 }, std::pair{ 3, 0 },
+                                std::pair{ 0, 5 }, std::pair{ 3, 5 }, std::pair{ -1, -1 } }) {
+        ok &= throws(r, c);
+        ok &= !grid.in_bounds(r, c);
+    }
+
+    // The const overload checks the same way.
+    const Grid<int>& view = grid;
+    try {
+        view.at(0, 5);
+        ok = false;
+    } catch (const std::out_of_range&) {
+    }
+
+    // A view over someone else's cells bounds-checks against its own shape.
+    int cells[6] = { 0, 1, 2, 3, 4, 5 };
+    Grid<int> borrowed;
+    borrowed.view(2, 3, cells);
+    ok &= (borrowed.at(1, 2) == 5);
+    try {
+        borrowed.at(2, 0);
+        ok = false;
+    } catch (const std::out_of_range&) {
+    }
+
+    print_test_result("Grid keeps cells row-major and at() bounds-checks", ok);
+}
+
+// ----------------------------------------------------------
+// 29) Headless: with no event sink a whole game prints nothing, and the
+//     console sink prints it as before
+// ----------------------------------------------------------
+void TestArena::test_silent_sink() {
+    bool ok = true;
+
+    // Moves, bad moves and shots, a hammer kill and the end of the game.
+    auto play = [&](bool silent) {
+        std::ostringstream captured;
+        std::streambuf* saved = std::cout.rdbuf(captured.rdbuf());
+        {
+            Arena arena(12, 12);
+            if (silent) arena.set_event_sink(nullptr);
+            arena.set_seed(17);
+            arena.max_rounds = 30;
+            arena.load_config("no_such_config.txt");
+            arena.load_obstacles();
+            for (int r = 0; r < 12; ++r) {
+                for (int c = 0; c < 4; ++c) {
+                    arena.board(r, c) = '.';
+                    arena.update_cell(r, c);
+                }
+            }
+            JumperRobot jumper;
+            TestRobot tester(2, 5, railgun, "Tester");
+            ShooterRobot hammer_bot(hammer, "Hammer");
+            arena.add_robot(&jumper, 5, 1);
+            arena.add_robot(&tester, 9, 2);
+            arena.add_robot(&hammer_bot, 5, 0);
+            arena.run();
+        }
+        std::cout.rdbuf(saved);
+        return captured.str();
+    };
+    ok &= play(true).empty();
+    ok &= !play(false).empty();
+
+    print_test_result("No event sink: a whole game prints nothing", ok);
+}
+
+// Sweeps its radar round the compass, fires its railgun at the first live
+// robot it sees and steps one cell along a fixed cycle of directions, so
+// games end in kills without any randomness of its own.
+class RailSeeker : public RobotBase {
+public:
+    RailSeeker() : RobotBase(3, 3, railgun) {
+        m_name = "Seeker";
+        m_character = 'K';
+        set_boundaries(0, 0);
+    }
+
+    void get_radar_direction(int& radar_direction) override {
+        radar_direction = m_turn % 8 + 1;
+    }
+
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        m_has_target = false;
+        for (const RadarObj& obj : radar_results) {
+            if (obj.m_type != 'R') continue;
+            m_target_row = obj.m_row;
+            m_target_col = obj.m_col;
+            m_has_target = true;
+            break;
+        }
+    }
+
+    bool get_shot_location(int& shot_row, int& shot_col) override {
+        shot_row = m_target_row;
+        shot_col = m_target_col;
+        return m_has_target;
+    }
+
+    void get_move_direction(int& direction, int& distance) override {
+        direction = (m_turn * 3) % 8 + 1;
+        distance = 1;
+        ++m_turn;
+    }
+
+private:
+    int m_turn = 0;
+    int m_target_row = -1, m_target_col = -1;
+    bool m_has_target = false;
+};
+
+static RobotBase* make_seeker() { return new RailSeeker; }
+
+// ----------------------------------------------------------
+// 30) Tournaments: the totals add up to the games played one by one, and
+//     any number of threads gives the same totals
+// ----------------------------------------------------------
+void TestArena::test_tournament_tally() {
+    bool ok = true;
+
+    ArenaConfig config;
+    config.rows = 12;
+    config.cols = 12;
+    config.max_rounds = 40;
+    std::vector<RobotLibrary> roster(3);
+    roster[0].name = "Seeker";
+    roster[0].create_robot = make_seeker;
+    roster[1].name = "Seeker2";
+    roster[1].create_robot = make_seeker;
+    roster[2].name = "Jumper";
+    roster[2].create_robot = make_jumper;
+    const int games = 12;
+    const std::uint64_t seed = 77;
+
+    // Each game by hand, the way Tournament::play_game sets it up.
+    std::vector<int> wins(roster.size(), 0), survived(roster.size(), 0);
+    int drawn = 0;
+    long long rounds = 0;
+    for (int game = 0; game < games; ++game) {
+        Arena arena;
+        arena.set_event_sink(nullptr);
+        arena.configure(config);
+        arena.set_seed(Tournament::game_seed(seed, game));
+        ok &= arena.load_obstacles();
+        ok &= arena.spawn_robots(roster);
+        arena.run();
+        rounds += arena.rounds_played();
+        const RobotInfo* winner = arena.winner();
+        if (arena.result() != GameResult::winner) drawn++;
+        for (const RobotInfo& info : arena.robot_infos()) {
+            if (&info == winner) wins[info.library]++;
+            if (info.alive) survived[info.library]++;
+        }
+    }
+    // Enough happens for the totals to mean something.
+    ok &= (std::accumulate(wins.begin(), wins.end(), 0) > 0 && drawn > 0);
+
+    auto run = [&](unsigned int threads) {
+        Tournament tournament(config, roster, games, seed);
+        ok &= tournament.run(threads);
+        return tournament;
+    };
+    Tournament one = run(1);
+    ok &= (one.draws() == drawn);
+    ok &= (one.average_rounds() == static_cast<double>(rounds) / games);
+    for (std::size_t i = 0; i < roster.size(); ++i) {
+        const TournamentStats& t = one.stats()[i];
+        ok &= (t.name == roster[i].name && t.games == games);
+        ok &= (t.wins == wins[i] && t.survived == survived[i]);
+        ok &= (t.wins + t.draws + t.losses == games);
+    }
+
+    for (unsigned int threads : { 2u, 4u }) {
+        Tournament many = run(threads);
+        ok &= (many.draws() == one.draws() && many.average_rounds() == one.average_rounds());
+        for (std::size_t i = 0; i < roster.size(); ++i) {
+            const TournamentStats& a = one.stats()[i];
+            const TournamentStats& b = many.stats()[i];
+            ok &= (a.wins == b.wins && a.draws == b.draws && a.losses == b.losses &&
+                   a.survived == b.survived && a.rounds_alive == b.rounds_alive);
+        }
+    }
+
+    print_test_result("Tournament totals match the games one by one, on any thread count", ok);
+}
+
+// ----------------------------------------------------------
+// 31) Command line: -b alone stops a robot that never returns from a call
+// ----------------------------------------------------------
+void TestArena::test_budget_command_line() {
+    bool ok = true;
+
+    // A directory of its own with two robots and what they build against;
+    // RobotWarz compiles whatever Robot_*.cpp it finds where it runs.
+    char cwd[4096];
+    char dir[] = "/tmp/robotwarz_budget_XXXXXX";
+    ok &= (getcwd(cwd, sizeof(cwd)) != nullptr && mkdtemp(dir) != nullptr);
+    const std::string here = cwd;
+    const std::string there = dir;
+    for (const char* shared : { "RobotBase.o", "RobotBase.h", "RadarObj.h" }) {
+        ok &= (symlink((here + "/" + shared).c_str(), (there + "/" + shared).c_str()) == 0);
+    }
+    auto write_robot = [&](const std::string& name, const std::string& move) {
+        std::ofstream out(there + "/Robot_" + name + ".cpp");
+        out << "#include \"RobotBase.h\"\n"
+               "class Robot_" << name << " : public RobotBase {\n"
+               "public:\n"
+               "    Robot_" << name << "() : RobotBase(2, 2, hammer) { m_name = \"" << name << "\"; }\n"
+               "    void get_radar_direction(int& d) override { d = 1; }\n"
+               "    void process_radar_results(const std::vector<RadarObj>&) override {}\n"
+               "    bool get_shot_location(int&, int&) override { return false; }\n"
+               "    void get_move_direction(int& d, int& n) override { d = 0; n = 0; " << move << " }\n"
+               "};\n"
+               "extern \"C\" RobotBase* create_robot() { return new Robot_" << name << "(); }\n";
+    };
+    write_robot("Hanger", "volatile bool spin = true; while (spin) {}");
+    write_robot("Idler", "");
+
+    // Only -b: the budget alone has to isolate the robots, or the game
+    // never ends and timeout kills it.
+    const std::string output = there + "/output.txt";
+    std::string command = "cd " + there + " && timeout 120 " + here +
+                          "/RobotWarz -q -s 3 -b 50 > " + output + " 2>&1";
+    int status = std::system(command.c_str());
+    ok &= (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    std::ifstream in(output);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ok &= (text.find("Winner: Idler!") != std::string::npos);
+
+    ok &= (std::system(("rm -rf " + there).c_str()) == 0);
+    print_test_result("RobotWarz -b puts out a robot that never returns", ok);
+}
+
+// ----------------------------------------------------------
+// Simultaneous games with the shipped robots repeat with the seed
+// ----------------------------------------------------------
+void TestArena::test_simultaneous_command_line() {
+    bool ok = true;
+
+    // The robots that come with the game, built where they are in-process
+    // and call std::rand as they decide.
+    char cwd[4096];
+    char dir[] = "/tmp/robotwarz_simultaneous_XXXXXX";
+    ok &= (getcwd(cwd, sizeof(cwd)) != nullptr && mkdtemp(dir) != nullptr);
+    const std::string here = cwd;
+    const std::string there = dir;
+    for (const char* shared : { "RobotBase.o", "RobotBase.h", "RadarObj.h",
+                                "Robot_Bomber.cpp", "Robot_Flame_e_o.cpp",
+                                "Robot_PerimeterPatrol.cpp" }) {
+        ok &= (symlink((here + "/" + shared).c_str(), (there + "/" + shared).c_str()) == 0);
+    }
+
+    auto play = [&](int threads, const std::string& name) {
+        std::string command = "cd " + there + " && timeout 120 " + here +
+                              "/RobotWarz -q -s 11 --simultaneous -j " + std::to_string(threads) +
+                              " -e " + name + " > /dev/null 2>&1";
+        int status = std::system(command.c_str());
+        ok &= (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        std::ifstream in(there + "/" + name);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    std::string one = play(1, "one.jsonl");
+    std::string four = play(4, "four.jsonl");
+    std::string again = play(4, "again.jsonl");
+    ok &= (!one.empty() && one == four && four == again);
+
+    ok &= (std::system(("rm -rf " + there).c_str()) == 0);
+    print_test_result("Shipped robots play the same simultaneous game on 1 and 4 threads", ok);
+}
@@ -18,6 +18,30 @@ public:
     void test_grenade_damage();
     void test_radar();
     void test_radar_local();
+    void test_occupancy_grid();
+    void test_seeded_arena();
+    void test_radar_engine();
+    void test_cell_planes();
+    void test_grid_line();
+    void test_footprint_cache();
+    void test_replay_recorder();
+    void test_replay_player();
+    void test_terminal_renderer();
+    void test_event_stream();
+    void test_phase_timing();
+    void test_call_budget();
+    void test_isolated_robots();
+    void test_turn_robots();
+    void test_simultaneous_turns();
+    void test_task_scheduler();
+    void test_map_files();
+    void test_placement();
+    void test_sweeps();
+    void test_grid_bounds();
+    void test_silent_sink();
+    void test_tournament_tally();
+    void test_budget_command_line();
+    void test_simultaneous_command_line();
 	void print_summary();
 
 private:
@@ -33,6 +57,10 @@ public:
     TestRobot(int move, int armor, WeaponType weapon, const std::string& name)
         : RobotBase(move, armor, weapon) {
         m_name = name;
+        // RobotBase leaves the symbol and board bounds unset; add_robot
+        // sets the real bounds.
+        m_character = 'T';
+        set_boundaries(0, 0);
     }
 
     void get_radar_direction(int& radar_direction) override {
@@ -70,6 +98,8 @@ public:
     RobotOutOfBounds()
         : RobotBase(2, 5, hammer) {
         m_name = "OutOfBoundsBot";
+        m_character = 'O';
+        set_boundaries(0, 0);
     }
 
     void get_move_direction(int& direction, int& distance) override {
@@ -105,6 +135,8 @@ public:
     BadMovesRobot()
         : RobotBase(2, 5, grenade) {
         m_name = "BadMovesBot";
+        m_character = 'B';
+        set_boundaries(0, 0);
     }
 
     void get_move_direction(int& direction, int& distance) override {
@@ -137,6 +169,8 @@ public:
     JumperRobot()
         : RobotBase(5, 2, flamethrower) {
         m_name = "JumperBot";
+        m_character = 'J';
+        set_boundaries(0, 0);
     }
 
     void get_move_direction(int& direction, int& distance) override {
@@ -163,6 +197,8 @@ public:
     ShooterRobot(WeaponType weapon, const std::string& name)
         : RobotBase(5, 3, weapon) {
         m_name = name;
+        m_character = 'S';
+        set_boundaries(0, 0);
     }
 
     void get_move_direction(int& direction, int& distance) override {
@@ -0,0 +1,160 @@
+#include "Tournament.h"
+#include <iomanip>
+
+Tournament::Tournament(const ArenaConfig& config_in,
+                       const std::vector<RobotLibrary>& libraries_in,
+                       int games_in,
+                       std::uint64_t seed_in)
+    : config(config_in),
+      libraries(libraries_in),
+      games(games_in),
+      seed(seed_in) {
+    config.watch_live = false;
+}
+
+// splitmix64 over (tournament seed, game number): neighbouring games get
+// unrelated seeds, and the same tournament seed always gives the same games.
+std::uint64_t Tournament::game_seed(std::uint64_t tournament_seed, int game) {
+    std::uint64_t z = tournament_seed + 0x9E3779B97F4A7C15ULL * static_cast<std::uint64_t>(game + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+bool Tournament::run(unsigned int threads) {
+    // Every game gets the same board size, obstacle counts and roster, so
+    // one trial board tells whether they fit before any game starts.
+    {
+        Arena trial;
+        trial.set_event_sink(nullptr);
+        trial.configure(config);
+        bool board_ok = map_path.empty() ? trial.load_obstacles() : trial.load_map(map_path);
+        if (!board_ok || !trial.has_room_for(libraries.size())) return false;
+    }
+    outcomes.assign(games, GameOutcome());
+
+    {
+        TaskScheduler pool(threads);
+        scheduler = &pool;
+        for (int game = 0; game < games; ++game) {
+            pool.submit([this, game] { play_game(game); });
+        }
+        pool.wait_idle();
+        worker_usage = pool.worker_stats();
+        scheduler = nullptr;
+    }
+
+    tally();
+    return true;
+}
+
+void Tournament::play_game(int game) {
+    Arena arena;
+    arena.set_event_sink(nullptr);
+    arena.configure(config);
+    arena.set_seed(game_seed(seed, game));
+    arena.set_call_budget(call_budget);
+    arena.set_isolation(isolate);
+    arena.set_simultaneous(simultaneous, 1);
+    arena.set_scheduler(simultaneous ? scheduler : nullptr);
+    // Checked in run(), so the board and the robots fit.
+    if (map_path.empty()) arena.load_obstacles();
+    else                  arena.load_map(map_path);
+    arena.spawn_robots(libraries);
+    arena.run();
+
+    GameOutcome& outcome = outcomes[game];
+    outcome.result = arena.result();
+    outcome.rounds = arena.rounds_played();
+    outcome.winner_flags.assign(libraries.size(), 0);
+    outcome.alive_flags.assign(libraries.size(), 0);
+    outcome.rounds_alive.assign(libraries.size(), 0);
+    outcome.overruns.assign(libraries.size(), 0);
+    outcome.crashes.assign(libraries.size(), 0);
+
+    const RobotInfo* winner = arena.winner();
+    for (const RobotInfo& info : arena.robot_infos()) {
+        if (info.library < 0) continue;
+        outcome.winner_flags[info.library] = (&info == winner);
+        outcome.alive_flags[info.library] = info.alive;
+        outcome.rounds_alive[info.library] =
+            info.alive ? outcome.rounds : info.died_in_round + 1;
+        outcome.overruns[info.library] = info.overruns;
+        outcome.crashes[info.library] = info.crashes;
+    }
+}
+
+// Adds the games up in game order, so the totals do not depend on which
+// worker finished first.
+void Tournament::tally() {
+    totals.assign(libraries.size(), TournamentStats());
+    drawn_games = 0;
+    total_rounds = 0;
+    for (std::size_t i = 0; i < libraries.size(); ++i) {
+        totals[i].name = libraries[i].name;
+    }
+
+    for (const GameOutcome& outcome : outcomes) {
+        if (outcome.result != GameResult::winner) drawn_games++;
+        total_rounds += outcome.rounds;
+
+        for (std::size_t i = 0; i < libraries.size(); ++i) {
+            TournamentStats& t = totals[i];
+            t.games++;
+            t.rounds_alive += outcome.rounds_alive[i];
+            t.survived += outcome.alive_flags[i];
+            t.overruns += outcome.overruns[i];
+            t.crashes += outcome.crashes[i];
+
+            if (outcome.winner_flags[i]) {
+                t.wins++;
+            } else if (outcome.result != GameResult::winner && outcome.alive_flags[i]) {
+                t.draws++;      // still standing when the round limit hit
+            } else if (outcome.result == GameResult::draw) {
+                t.draws++;      // everybody died
+            } else {
+                t.losses++;
+            }
+        }
+    }
+}
+
+void Tournament::print_summary(std::ostream& out) const {
+    out << "\n=========== Tournament: " << games << " games, seed " << seed
+        << " ===========\n";
+    out << std::left << std::setw(18) << "Robot" << std::right
+        << std::setw(7) << "Games"
+        << std::setw(7) << "Wins"
+        << std::setw(7) << "Draws"
+        << std::setw(8) << "Losses"
+        << std::setw(8) << "Win%"
+        << std::setw(10) << "Survived"
+        << std::setw(12) << "Avg rounds";
+    if (call_budget.count() > 0) out << std::setw(10) << "Overruns";
+    if (isolate || call_budget.count() > 0) out << std::setw(9) << "Crashes";
+    out << "\n";
+
+    for (const TournamentStats& t : totals) {
+        double win_pct = t.games ? 100.0 * t.wins / t.games : 0.0;
+        double avg_rounds = t.games ? static_cast<double>(t.rounds_alive) / t.games : 0.0;
+        out << std::left << std::setw(18) << t.name << std::right
+            << std::setw(7) << t.games
+            << std::setw(7) << t.wins
+            << std::setw(7) << t.draws
+            << std::setw(8) << t.losses
+            << std::setw(7) << std::fixed << std::setprecision(1) << win_pct << "%"
+            << std::setw(10) << t.survived
+            << std::setw(12) << avg_rounds;
+        if (call_budget.count() > 0) out << std::setw(10) << t.overruns;
+        if (isolate || call_budget.count() > 0) out << std::setw(9) << t.crashes;
+        out << "\n";
+    }
+    out << "Games without a winner: " << drawn_games << "\n";
+}
+
+void Tournament::print_utilization(std::ostream& out) const {
+    if (worker_usage.empty()) return;
+    out << "\nWorkers over " << std::fixed << std::setprecision(1)
+        << worker_usage[0].elapsed.count() / 1e6 << " ms:\n";
+    print_worker_stats(out, worker_usage);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "RobotLibrary.h"
+
+// Per-robot totals over all games of a tournament.
+struct TournamentStats {
+    std::string name;
+    int games = 0;
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    int survived = 0;             // still alive when the game ended
+    long long rounds_alive = 0;   // summed over games
+    int overruns = 0;             // games it was put out of for running past the call budget
+    int crashes = 0;              // games its process died in (isolated robots only)
+};
+
+// Plays many independent games with the same roster, in parallel, and
+// totals up how each robot did. Every game gets its own Arena, its own
+// robot instances and a seed derived from the tournament seed, so the
+// games do not share any state.
+class Tournament {
+public:
+    Tournament(const ArenaConfig& config,
+               const std::vector<RobotLibrary>& libraries,
+               int games,
+               std::uint64_t seed);
+
+    // See Arena::set_call_budget; applies to every game.
+    void set_call_budget(std::chrono::microseconds budget) { call_budget = budget; }
+    // See Arena::set_isolation; applies to every game.
+    void set_isolation(bool on) { isolate = on; }
+    // See Arena::set_simultaneous. Games decide their robots' turns on the
+    // tournament's own workers, so once only a few long games are left
+    // their robots spread over the workers the short games have freed.
+    void set_simultaneous(bool on) { simultaneous = on; }
+    // Play every game on this map file (Arena::load_map) instead of random
+    // obstacles; "" for random ones. Each game maps the file afresh and
+    // reads it through once for its checksum: about 10 ms for a 4096x4096
+    // map once the first game has brought it into memory.
+    void set_map(const std::string& path) { map_path = path; }
+
+    // 0 threads means one per hardware core. Games run on a work-stealing
+    // TaskScheduler: they vary a lot in length, and an idle worker takes
+    // whatever is still queued on a busy one. False, with no games played,
+    // if the map won't load.
+    bool run(unsigned int threads = 0);
+
+    const std::vector<TournamentStats>& stats() const { return totals; }
+    int draws() const { return drawn_games; }
+    double average_rounds() const { return games > 0 ? static_cast<double>(total_rounds) / games : 0.0; }
+    void print_summary(std::ostream& out) const;
+    // How busy each worker was during the last run.
+    const std::vector<WorkerStats>& worker_stats() const { return worker_usage; }
+    void print_utilization(std::ostream& out) const;
+
+    static std::uint64_t game_seed(std::uint64_t tournament_seed, int game);
+
+private:
+    // What one game reports back; filled in by a worker, read after all
+    // workers are done.
+    struct GameOutcome {
+        GameResult result = GameResult::none;
+        int rounds = 0;
+        std::vector<int> winner_flags;     // per library: 1 if it won
+        std::vector<int> alive_flags;      // per library: 1 if alive at the end
+        std::vector<int> rounds_alive;     // per library
+        std::vector<int> overruns;         // per library
+        std::vector<int> crashes;          // per library
+    };
+
+    ArenaConfig config;
+    const std::vector<RobotLibrary>& libraries;
+    int games;
+    std::uint64_t seed;
+    std::chrono::microseconds call_budget{0};
+    bool isolate = false;
+    bool simultaneous = false;
+    std::string map_path;
+
+    std::vector<GameOutcome> outcomes;
+    std::vector<TournamentStats> totals;
+    int drawn_games = 0;
+    long long total_rounds = 0;
+    TaskScheduler* scheduler = nullptr;   // during run
+    std::vector<WorkerStats> worker_usage;
+
+    void play_game(int game);
+    void tally();
+};
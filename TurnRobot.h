@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "RadarObj.h"
+#include "RobotBase.h"
+
+// What a robot does with its turn once it has seen its radar results.
+struct TurnAction {
+    bool shoots = false;
+    int shot_row = 0;
+    int shot_col = 0;
+    int move_direction = 0;   // only when not shooting
+    int move_distance = 0;
+};
+
+// An optional second interface for robots: the rest of a turn, after the
+// radar direction, in one call instead of process_radar_results,
+// get_shot_location and get_move_direction. A robot that also derives from
+// this is driven through take_turn; for an isolated robot that is one round
+// trip to its process instead of three.
+//
+// A robot gets it by deriving from BatchedRobot (below), or from RobotBase
+// and TurnRobot both. take_turn must decide what the three calls would
+// have.
+class TurnRobot {
+public:
+    virtual ~TurnRobot() = default;
+
+    virtual TurnAction take_turn(const std::vector<RadarObj>& radar_results) = 0;
+};
+
+// Drives an ordinary RobotBase through take_turn, making the same calls in
+// the same order as the arena does: results, shot, and the move only if
+// it doesn't shoot. Each call is timed, for callers that can't see inside
+// take_turn (an isolated robot's process).
+class LegacyTurns : public TurnRobot {
+public:
+    explicit LegacyTurns(RobotBase& robot) : m_robot(robot) {}
+
+    TurnAction take_turn(const std::vector<RadarObj>& radar_results) override {
+        TurnAction action;
+        Clock::time_point start = Clock::now();
+        m_robot.process_radar_results(radar_results);
+        Clock::time_point radar_done = Clock::now();
+        action.shoots = m_robot.get_shot_location(action.shot_row, action.shot_col);
+        Clock::time_point shot_done = Clock::now();
+        m_call_ns[0] = nanoseconds(start, radar_done);
+        m_call_ns[1] = nanoseconds(radar_done, shot_done);
+        m_call_ns[2] = 0;
+        if (!action.shoots) {
+            m_robot.get_move_direction(action.move_direction, action.move_distance);
+            m_call_ns[2] = nanoseconds(shot_done, Clock::now());
+        }
+        return action;
+    }
+
+    // How long the last take_turn spent in process_radar_results,
+    // get_shot_location and get_move_direction; at least 1 for a call that
+    // was made, 0 for a move it didn't ask for.
+    const std::array<std::uint64_t, 3>& call_ns() const { return m_call_ns; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    RobotBase& m_robot;
+    std::array<std::uint64_t, 3> m_call_ns{};
+
+    static std::uint64_t nanoseconds(Clock::time_point from, Clock::time_point to) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+        return ns > 0 ? static_cast<std::uint64_t>(ns) : 1;
+    }
+};
+
+// A base for robots written against take_turn: it answers the three
+// callbacks take_turn replaces from one take_turn call, so the robot also
+// works wherever it is driven one callback at a time.
+class BatchedRobot : public RobotBase, public TurnRobot {
+public:
+    BatchedRobot(int move, int armor, WeaponType weapon) : RobotBase(move, armor, weapon) {}
+
+    void process_radar_results(const std::vector<RadarObj>& radar_results) final {
+        m_action = take_turn(radar_results);
+    }
+    bool get_shot_location(int& shot_row, int& shot_col) final {
+        shot_row = m_action.shot_row;
+        shot_col = m_action.shot_col;
+        return m_action.shoots;
+    }
+    void get_move_direction(int& direction, int& distance) final {
+        direction = m_action.move_direction;
+        distance = m_action.move_distance;
+    }
+
+private:
+    TurnAction m_action;
+};
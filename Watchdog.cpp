@@ -0,0 +1,28 @@
+#include "Watchdog.h"
+
+template <typename Call>
+bool Watchdog::timed(Call&& call) const {
+    auto start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::steady_clock::now() - start <= m_budget;
+}
+
+bool Watchdog::get_radar_direction(RobotBase& robot, int& radar_dir) const {
+    return timed([&] { robot.get_radar_direction(radar_dir); });
+}
+
+bool Watchdog::process_radar_results(RobotBase& robot, const std::vector<RadarObj>& results) const {
+    return timed([&] { robot.process_radar_results(results); });
+}
+
+bool Watchdog::get_shot_location(RobotBase& robot, int& row, int& col, bool& shoots) const {
+    return timed([&] { shoots = robot.get_shot_location(row, col); });
+}
+
+bool Watchdog::get_move_direction(RobotBase& robot, int& direction, int& distance) const {
+    return timed([&] { robot.get_move_direction(direction, distance); });
+}
+
+bool Watchdog::take_turn(TurnRobot& robot, const std::vector<RadarObj>& results, TurnAction& action) const {
+    return timed([&] { action = robot.take_turn(results); });
+}
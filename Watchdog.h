@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "EventSink.h"
+#include "TurnRobot.h"
+
+// Times robot callbacks against a budget. Each call runs directly on the
+// caller's thread between two clock reads, so a budget costs well under a
+// microsecond a call; a call that comes back late is reported, and the
+// arena puts the robot out.
+//
+// A call that never comes back can't be stopped in-process: only a robot in
+// a child process of its own can be killed. That's why spawn_robots
+// isolates every robot when there is a budget (see Arena::set_call_budget);
+// a robot added by hand has to return to be caught. A Watchdog holds no
+// state but its budget, so threads can share one.
+class Watchdog {
+public:
+    explicit Watchdog(std::chrono::microseconds budget) : m_budget(budget) {}
+
+    std::chrono::microseconds budget() const { return m_budget; }
+
+    // Each returns false if the call overran; the outputs are then whatever
+    // the robot left in them.
+    bool get_radar_direction(RobotBase& robot, int& radar_dir) const;
+    bool process_radar_results(RobotBase& robot, const std::vector<RadarObj>& results) const;
+    bool get_shot_location(RobotBase& robot, int& row, int& col, bool& shoots) const;
+    bool get_move_direction(RobotBase& robot, int& direction, int& distance) const;
+    bool take_turn(TurnRobot& robot, const std::vector<RadarObj>& results, TurnAction& action) const;
+
+private:
+    std::chrono::microseconds m_budget;
+
+    template <typename Call>
+    bool timed(Call&& call) const;
+};
@@ -0,0 +1,1460 @@
+#include "Arena.h"
+#include "Grid.h"
+#include "Rng.h"
+#include "RadarEngine.h"
+#include "GridLine.h"
+#include "FootprintCache.h"
+#include "ConsoleSink.h"
+#include "IsolatedRobot.h"
+#include "EventStream.h"
+#include "Replay.h"
+#include "TaskScheduler.h"
+#include "TerminalRenderer.h"
+#include "ThreadPool.h"
+#include "RobotBase.h"
+#include "SharedRing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A robot that never does anything - the benchmarks only care about the
+// arena side of the work.
+class IdleRobot : public RobotBase {
+public:
+    IdleRobot() : RobotBase(3, 4, railgun) {
+        m_name = "Idle";
+        m_character = 'I';
+    }
+
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        (void)radar_results;
+    }
+    bool get_shot_location(int& shot_row, int& shot_col) override {
+        shot_row = shot_col = 0;
+        return false;
+    }
+    void get_move_direction(int& direction, int& distance) override {
+        direction = 0;
+        distance = 0;
+    }
+};
+
+// Sweeps the radar around and paces left and right, so every turn scans and
+// moves.
+class PacingRobot : public RobotBase {
+public:
+    PacingRobot() : RobotBase(3, 4, railgun) {
+        m_name = "Pacer";
+        m_character = 'P';
+    }
+
+    void get_radar_direction(int& radar_direction) override {
+        radar_direction = m_turn % 9;
+    }
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        m_seen += radar_results.size();
+    }
+    bool get_shot_location(int& shot_row, int& shot_col) override {
+        shot_row = shot_col = 0;
+        return false;
+    }
+    void get_move_direction(int& direction, int& distance) override {
+        direction = (m_turn++ % 2) ? 3 : 7;
+        distance = 1;
+    }
+
+private:
+    int m_turn = 0;
+    std::size_t m_seen = 0;
+};
+
+// A pacer that thinks about its radar results for a while first: spinning
+// on the CPU, or asleep as if waiting on something.
+class ThinkingRobot : public PacingRobot {
+public:
+    ThinkingRobot(std::chrono::microseconds think, bool sleeps) : m_think(think), m_sleeps(sleeps) {}
+
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        if (m_sleeps) {
+            std::this_thread::sleep_for(m_think);
+        } else {
+            auto until = std::chrono::steady_clock::now() + m_think;
+            while (std::chrono::steady_clock::now() < until) {}
+        }
+        PacingRobot::process_radar_results(radar_results);
+    }
+
+private:
+    std::chrono::microseconds m_think;
+    bool m_sleeps;
+};
+
+// Alternates railgun and flamethrower shots at cells across the board with
+// full-speed moves, so most of a turn goes into walking paths.
+class SniperRobot : public RobotBase {
+public:
+    SniperRobot(WeaponType weapon, int rows, int cols)
+        : RobotBase(5, 2, weapon), m_rng(rows * 31 + cols), m_rows(rows), m_cols(cols) {
+        m_name = "Sniper";
+        m_character = 'S';
+    }
+
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        (void)radar_results;
+    }
+    bool get_shot_location(int& shot_row, int& shot_col) override {
+        if (m_turn++ % 2) return false;
+        shot_row = m_rng.between(0, m_rows - 1);
+        shot_col = m_rng.between(0, m_cols - 1);
+        return true;
+    }
+    void get_move_direction(int& direction, int& distance) override {
+        direction = m_rng.between(1, 8);
+        distance = 5;
+    }
+
+private:
+    Rng m_rng;
+    int m_rows;
+    int m_cols;
+    int m_turn = 0;
+};
+
+// Every heap allocation in the process goes through here, so benchmarks can
+// count what a stretch of code allocates.
+static std::atomic<long long> allocation_count{0};
+
+// noinline keeps GCC from pairing an inlined malloc/free with new/delete
+// and warning about a mismatch.
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using bench_clock = std::chrono::steady_clock;
+
+static double elapsed_ms(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+// Keeps the optimizer from throwing away benchmark loops.
+static volatile long long bench_sink = 0;
+
+// Friend of Arena so the benchmarks can drive the private lookup helpers.
+class BenchArena {
+public:
+    void bench_robot_lookup();
+    void bench_radar_scan();
+    void bench_cell_planes();
+    void bench_turn_allocations();
+    void bench_line_paths();
+    void bench_shot_paths();
+    void bench_replay();
+    void bench_board_render();
+    void bench_phase_timing();
+    void bench_isolation();
+    void bench_simultaneous();
+    void bench_scheduler();
+    void bench_map_load();
+    void bench_placement();
+
+private:
+    std::vector<std::unique_ptr<IdleRobot>> owned;
+
+    void fill_robots(Arena& arena, int count);
+    static int linear_find_robot_at(const Arena& arena, int r, int c);
+};
+
+void BenchArena::fill_robots(Arena& arena, int count) {
+    std::srand(1234);
+    for (int placed = 0; placed < count; ) {
+        int r = std::rand() % arena.rows;
+        int c = std::rand() % arena.cols;
+        if (arena.find_robot_at(r, c) != -1) continue;
+        owned.push_back(std::make_unique<IdleRobot>());
+        arena.add_robot(owned.back().get(), r, c);
+        placed++;
+    }
+}
+
+// The lookup Arena used before the occupancy grid: walk every robot.
+int BenchArena::linear_find_robot_at(const Arena& arena, int r, int c) {
+    for (std::size_t i = 0; i < arena.robots.size(); ++i) {
+        if (arena.robots[i].row == r && arena.robots[i].col == c) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Sweeps every cell of a 200x200 board once per pass, the way radar,
+// movement and weapons end up touching cells.
+void BenchArena::bench_robot_lookup() {
+    const int size = 200;
+    const int passes = 5;
+
+    std::cout << "\n=== find_robot_at: linear scan vs occupancy grid ("
+              << size << "x" << size << ", " << passes << " passes) ===\n";
+    std::cout << std::setw(8) << "robots"
+              << std::setw(14) << "linear ms"
+              << std::setw(14) << "grid ms"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (int count : {10, 100, 1000}) {
+        Arena arena(size, size);
+        fill_robots(arena, count);
+
+        long long found = 0;
+        auto start = bench_clock::now();
+        for (int p = 0; p < passes; ++p)
+            for (int r = 0; r < size; ++r)
+                for (int c = 0; c < size; ++c)
+                    found += linear_find_robot_at(arena, r, c) != -1;
+        double linear_ms = elapsed_ms(start);
+
+        long long found_grid = 0;
+        start = bench_clock::now();
+        for (int p = 0; p < passes; ++p)
+            for (int r = 0; r < size; ++r)
+                for (int c = 0; c < size; ++c)
+                    found_grid += arena.find_robot_at(r, c) != -1;
+        double grid_ms = elapsed_ms(start);
+
+        if (found != found_grid) {
+            std::cout << "  MISMATCH: linear found " << found
+                      << ", grid found " << found_grid << "\n";
+        }
+        bench_sink = bench_sink + found + found_grid;
+
+        std::cout << std::setw(8) << count
+                  << std::setw(14) << std::fixed << std::setprecision(2) << linear_ms
+                  << std::setw(14) << grid_ms
+                  << std::setw(9) << std::setprecision(1) << linear_ms / grid_ms << "x\n";
+    }
+}
+
+using NestedBoard = std::vector<std::vector<char>>;
+
+static long long scan_rows(const NestedBoard& b, int size) {
+    long long n = 0;
+    for (int r = 0; r < size; ++r)
+        for (int c = 0; c < size; ++c) n += b[r][c] != '.';
+    return n;
+}
+
+static long long scan_rows(const Grid<char>& b, int size) {
+    long long n = 0;
+    for (int r = 0; r < size; ++r)
+        for (int c = 0; c < size; ++c) n += b(r, c) != '.';
+    return n;
+}
+
+static long long scan_cols(const NestedBoard& b, int size) {
+    long long n = 0;
+    for (int c = 0; c < size; ++c)
+        for (int r = 0; r < size; ++r) n += b[r][c] != '.';
+    return n;
+}
+
+static long long scan_cols(const Grid<char>& b, int size) {
+    long long n = 0;
+    for (int c = 0; c < size; ++c)
+        for (int r = 0; r < size; ++r) n += b(r, c) != '.';
+    return n;
+}
+
+template <typename Board, typename Scan>
+static double time_scan(const Board& b, int size, int passes, Scan scan) {
+    long long count = 0;
+    auto start = bench_clock::now();
+    for (int p = 0; p < passes; ++p) count += scan(b, size);
+    double ms = elapsed_ms(start);
+    bench_sink = bench_sink + count;
+    return ms;
+}
+
+// Radar scans from random spots on a mostly empty 2000x2000 board: the
+// cell-by-cell walk against the bitset engine.
+void BenchArena::bench_radar_scan() {
+    const int size = 2000;
+    const int origins = 2000;
+
+    Arena arena(size, size);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(5);
+    arena.num_mounds = 4000;
+    arena.num_pits = 1000;
+    arena.num_flames = 1000;
+    arena.load_obstacles();
+    fill_robots(arena, 100);
+
+    Rng rng(11);
+    std::vector<RobotInfo> probes(origins);
+    for (RobotInfo& probe : probes) {
+        probe.row = rng.between(0, size - 1);
+        probe.col = rng.between(0, size - 1);
+    }
+
+    std::vector<RadarObj> results;
+    long long walk_found = 0;
+    auto start = bench_clock::now();
+    for (const RobotInfo& probe : probes) {
+        for (int dir = 0; dir <= 8; ++dir) {
+            results.clear();
+            RadarEngine::walk(size, size, probe.row, probe.col, dir,
+                [&](int rr, int cc) { return arena.get_cell_type(rr, cc) != '.'; },
+                [&](int rr, int cc) { results.emplace_back(arena.get_cell_type(rr, cc), rr, cc); });
+            walk_found += results.size();
+        }
+    }
+    double walk_ms = elapsed_ms(start);
+
+    long long engine_found = 0;
+    start = bench_clock::now();
+    for (RobotInfo& probe : probes) {
+        for (int dir = 0; dir <= 8; ++dir) {
+            arena.do_radar_scan(probe, dir, results);
+            engine_found += results.size();
+        }
+    }
+    double engine_ms = elapsed_ms(start);
+
+    if (walk_found != engine_found) {
+        std::cout << "  MISMATCH: walk found " << walk_found
+                  << ", engine found " << engine_found << "\n";
+    }
+    bench_sink = bench_sink + walk_found + engine_found;
+
+    std::cout << "\n=== radar scans: cell walk vs bitset engine (" << size << "x" << size
+              << ", " << origins << " origins x 9 directions, "
+              << engine_found << " objects found) ===\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "  cell walk       " << std::setw(10) << walk_ms << " ms\n"
+              << "  radar engine    " << std::setw(10) << engine_ms << " ms  ("
+              << std::setprecision(1) << walk_ms / engine_ms << "x)\n";
+}
+
+// The test_arena weapon and movement scenarios blown up to a 2000x2000 board
+// with 40000 robots, a third of them wrecks: the per-cell checks Arena used
+// to make against the cell planes.
+void BenchArena::bench_cell_planes() {
+    const int size = 2000;
+    const int queries = 1000000;
+
+    Arena arena(size, size);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(6);
+    arena.num_mounds = 200000;
+    arena.num_pits = 50000;
+    arena.num_flames = 50000;
+    arena.load_obstacles();
+    fill_robots(arena, 40000);
+    for (std::size_t i = 0; i < arena.robots.size(); i += 3) {
+        arena.mark_dead(arena.robots[i]);
+    }
+
+    Rng rng(12);
+    std::vector<std::pair<int, int>> spots(queries);
+    for (auto& spot : spots) {
+        spot = { rng.between(0, size - 1), rng.between(0, size - 1) };
+    }
+
+    auto report = [](const char* what, double cell_ms, double plane_ms) {
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  " << std::left << std::setw(16) << what << std::right
+                  << std::setw(12) << cell_ms << std::setw(12) << plane_ms
+                  << std::setw(9) << std::setprecision(1) << cell_ms / plane_ms << "x\n";
+    };
+
+    std::cout << "\n=== cell checks: per cell vs cell planes (" << size << "x" << size
+              << ", " << arena.robots.size() << " robots, " << queries << " queries) ===\n";
+    std::cout << "  query              cell ms    plane ms   speedup\n";
+
+    // Grenade: live robots in a 3x3 box.
+    long long cell_hits = 0;
+    auto start = bench_clock::now();
+    for (auto [r0, c0] : spots) {
+        for (int r = r0 - 1; r <= r0 + 1; ++r) {
+            for (int c = c0 - 1; c <= c0 + 1; ++c) {
+                int idx = arena.find_robot_at(r, c);
+                if (idx != -1 && arena.robots[idx].alive) cell_hits++;
+            }
+        }
+    }
+    double cell_ms = elapsed_ms(start);
+
+    long long plane_hits = 0;
+    const unsigned live = CellPlanes::bit(CellPlanes::robots);
+    start = bench_clock::now();
+    for (auto [r0, c0] : spots) {
+        for (int r = r0 - 1; r <= r0 + 1; ++r) {
+            for (int c = arena.planes.next_in_row(live, r, c0 - 1, c0 + 1); c != -1;
+                 c = arena.planes.next_in_row(live, r, c + 1, c0 + 1)) {
+                plane_hits++;
+            }
+        }
+    }
+    double plane_ms = elapsed_ms(start);
+    report("grenade box", cell_ms, plane_ms);
+    if (cell_hits != plane_hits) std::cout << "  MISMATCH in grenade box\n";
+    bench_sink = bench_sink + cell_hits + plane_hits;
+
+    // Movement: cells a 5-step move gets through before something blocks it.
+    int dir = 0;
+    cell_hits = 0;
+    start = bench_clock::now();
+    for (auto [r, c] : spots) {
+        auto [dr, dc] = directions[dir++ % 8 + 1];
+        for (int step = 1; step <= 5; ++step) {
+            char cell = arena.get_cell_type(r + dr * step, c + dc * step);
+            if (!arena.in_bounds(r + dr * step, c + dc * step) ||
+                cell == 'R' || cell == 'X' || cell == 'M') break;
+            cell_hits++;
+        }
+    }
+    cell_ms = elapsed_ms(start);
+
+    dir = 0;
+    plane_hits = 0;
+    start = bench_clock::now();
+    for (auto [r, c] : spots) {
+        auto [dr, dc] = directions[dir++ % 8 + 1];
+        for (int step = 1; step <= 5; ++step) {
+            if (!arena.in_bounds(r + dr * step, c + dc * step) ||
+                arena.planes.test_any(CellPlanes::blocking, r + dr * step, c + dc * step)) break;
+            plane_hits++;
+        }
+    }
+    plane_ms = elapsed_ms(start);
+    report("move collision", cell_ms, plane_ms);
+    if (cell_hits != plane_hits) std::cout << "  MISMATCH in move collision\n";
+    bench_sink = bench_sink + cell_hits + plane_hits;
+
+    // Census: live robots and wrecks on the whole board, 20 times over.
+    cell_hits = 0;
+    start = bench_clock::now();
+    for (int pass = 0; pass < 20; ++pass) {
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                char cell = arena.get_cell_type(r, c);
+                cell_hits += (cell == 'R') + (cell == 'X');
+            }
+        }
+    }
+    cell_ms = elapsed_ms(start);
+
+    plane_hits = 0;
+    start = bench_clock::now();
+    for (int pass = 0; pass < 20; ++pass) {
+        plane_hits += arena.planes.count(CellPlanes::robots) +
+                      arena.planes.count(CellPlanes::wrecks);
+    }
+    plane_ms = elapsed_ms(start);
+    report("board census", cell_ms, plane_ms);
+    if (cell_hits != plane_hits) std::cout << "  MISMATCH in board census\n";
+    bench_sink = bench_sink + cell_hits + plane_hits;
+}
+
+// Heap allocations per turn once the arena has warmed up. The old turn built
+// a fresh radar vector every time; the arena now reuses one buffer.
+void BenchArena::bench_turn_allocations() {
+    const int size = 200;
+    const int robot_count = 400;
+    const int rounds = 200;
+
+    Arena arena(size, size);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(10);
+    arena.num_mounds = 2000;
+    arena.num_pits = 0;
+    arena.num_flames = 0;
+    arena.load_obstacles();
+
+    std::vector<std::unique_ptr<PacingRobot>> pacers;
+    Rng rng(13);
+    while ((int)pacers.size() < robot_count) {
+        int r = rng.between(0, size - 1);
+        int c = rng.between(0, size - 1);
+        if (arena.get_cell_type(r, c) != '.') continue;
+        pacers.push_back(std::make_unique<PacingRobot>());
+        arena.add_robot(pacers.back().get(), r, c);
+    }
+
+    for (int round = 0; round < 10; ++round) arena.play_round(round);
+
+    long long turns = static_cast<long long>(rounds) * robot_count;
+    long long before = allocation_count.load();
+    auto start = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) arena.play_round(round);
+    double turn_ms = elapsed_ms(start);
+    long long turn_allocs = allocation_count.load() - before;
+
+    // The same radar scans, each into a vector of its own.
+    long long found = 0;
+    before = allocation_count.load();
+    start = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (RobotInfo& info : arena.robots) {
+            std::vector<RadarObj> results;
+            arena.do_radar_scan(info, round % 9, results);
+            found += results.size();
+        }
+    }
+    double fresh_ms = elapsed_ms(start);
+    long long fresh_allocs = allocation_count.load() - before;
+    bench_sink = bench_sink + found;
+
+    std::cout << "\n=== heap allocations per turn (" << size << "x" << size << ", "
+              << robot_count << " robots, " << turns << " turns) ===\n";
+    std::cout << std::fixed << std::setprecision(3)
+              << "  radar into a fresh vector  " << std::setw(8)
+              << (double)fresh_allocs / turns << " allocs/turn  "
+              << std::setprecision(1) << std::setw(6) << fresh_ms * 1e6 / turns << " ns/scan\n"
+              << std::setprecision(3)
+              << "  full turn, reused buffer   " << std::setw(8)
+              << (double)turn_allocs / turns << " allocs/turn  "
+              << std::setprecision(1) << std::setw(6) << turn_ms * 1e6 / turns << " ns/turn\n";
+    if (turn_allocs != 0) {
+        std::cout << "  WARNING: steady-state turns allocated " << turn_allocs << " times\n";
+    }
+}
+
+// Railgun paths walked with the old double increments and std::round against
+// GridLine, then whole path-heavy games.
+void BenchArena::bench_line_paths() {
+    const int size = 1000;
+    const int paths = 20000;
+
+    Rng rng(14);
+    std::vector<int> ends(4 * paths);
+    for (int& v : ends) v = rng.between(0, size - 1);
+
+    long long double_sum = 0;
+    long long cells = 0;
+    auto start = bench_clock::now();
+    for (int p = 0; p < paths; ++p) {
+        int r0 = ends[4 * p], c0 = ends[4 * p + 1];
+        int r1 = ends[4 * p + 2], c1 = ends[4 * p + 3];
+        double delta_r = r1 - r0;
+        double delta_c = c1 - c0;
+        int steps = std::max(std::abs(r1 - r0), std::abs(c1 - c0));
+        if (steps == 0) continue;
+        double row_inc = delta_r / steps;
+        double col_inc = delta_c / steps;
+        double row = r0 + row_inc;
+        double col = c0 + col_inc;
+        while (true) {
+            int rr = static_cast<int>(std::round(row));
+            int cc = static_cast<int>(std::round(col));
+            if (rr < 0 || rr >= size || cc < 0 || cc >= size) break;
+            double_sum += rr + cc;
+            cells++;
+            row += row_inc;
+            col += col_inc;
+        }
+    }
+    double double_ms = elapsed_ms(start);
+
+    long long line_sum = 0;
+    start = bench_clock::now();
+    for (int p = 0; p < paths; ++p) {
+        GridLine line(ends[4 * p], ends[4 * p + 1], ends[4 * p + 2], ends[4 * p + 3]);
+        if (line.length() == 0) continue;
+        while (true) {
+            line.advance();
+            int rr = line.row();
+            int cc = line.col();
+            if (rr < 0 || rr >= size || cc < 0 || cc >= size) break;
+            line_sum += rr + cc;
+        }
+    }
+    double line_ms = elapsed_ms(start);
+    bench_sink = bench_sink + double_sum + line_sum;
+
+    std::cout << "\n=== railgun paths: double stepping vs GridLine (" << size << "x" << size
+              << ", " << paths << " paths, " << cells << " cells) ===\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "  double + round  " << std::setw(10) << double_ms << " ms\n"
+              << "  GridLine        " << std::setw(10) << line_ms << " ms  ("
+              << std::setprecision(1) << double_ms / line_ms << "x)\n";
+    if (double_sum != line_sum) std::cout << "  MISMATCH between double stepping and GridLine\n";
+
+    // Snipers on a big open board: every other turn a railgun or flamethrower
+    // shot at a random cell, otherwise a full-speed move.
+    const int game_size = 500;
+    const int snipers = 200;
+    const int rounds = 200;
+    Arena arena(game_size, game_size);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(15);
+    arena.num_mounds = 500;
+    arena.num_pits = 0;
+    arena.num_flames = 0;
+    arena.load_obstacles();
+
+    std::vector<std::unique_ptr<SniperRobot>> bots;
+    while ((int)bots.size() < snipers) {
+        int r = rng.between(0, game_size - 1);
+        int c = rng.between(0, game_size - 1);
+        if (arena.get_cell_type(r, c) != '.') continue;
+        WeaponType weapon = bots.size() % 2 ? railgun : flamethrower;
+        bots.push_back(std::make_unique<SniperRobot>(weapon, game_size, game_size));
+        arena.add_robot(bots.back().get(), r, c);
+    }
+
+    start = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) arena.play_round(round);
+    double game_ms = elapsed_ms(start);
+
+    std::cout << "  path-heavy game " << std::setw(10) << std::setprecision(2) << game_ms
+              << " ms  (" << game_size << "x" << game_size << ", " << snipers
+              << " snipers, " << rounds << " rounds)\n";
+}
+
+// Railgun shots between random cells of tournament-sized boards: walking
+// each line with GridLine against looking the path up in a FootprintCache.
+void BenchArena::bench_shot_paths() {
+    const int shots = 1000000;
+
+    std::cout << "\n=== shot paths: GridLine vs FootprintCache (" << shots
+              << " railgun shots per board) ===\n";
+    std::cout << "    board   GridLine ms     cache ms   speedup   hits/misses\n";
+
+    for (int size : { 20, 40, 60 }) {
+        Rng rng(16);
+        std::vector<int> ends(4 * shots);
+        for (int& v : ends) v = rng.between(0, size - 1);
+
+        auto in_board = [&](int r, int c) { return r >= 0 && r < size && c >= 0 && c < size; };
+
+        long long line_sum = 0;
+        auto start = bench_clock::now();
+        for (int s = 0; s < shots; ++s) {
+            GridLine line(ends[4 * s], ends[4 * s + 1], ends[4 * s + 2], ends[4 * s + 3]);
+            if (line.length() == 0) continue;
+            while (true) {
+                line.advance();
+                if (!in_board(line.row(), line.col())) break;
+                line_sum += line.row() + line.col();
+            }
+        }
+        double line_ms = elapsed_ms(start);
+
+        FootprintCache cache;
+        long long cache_sum = 0;
+        start = bench_clock::now();
+        for (int s = 0; s < shots; ++s) {
+            int r0 = ends[4 * s], c0 = ends[4 * s + 1];
+            int dr = ends[4 * s + 2] - r0, dc = ends[4 * s + 3] - c0;
+            if (dr == 0 && dc == 0) continue;
+            int steps = std::max(std::abs(dr), std::abs(dc));
+            double row_increment = static_cast<double>(dr) / steps;
+            double col_increment = static_cast<double>(dc) / steps;
+            double row = r0, col = c0;
+            for (const PathCell& cell : cache.path(dr, dc, size)) {
+                row += row_increment;
+                col += col_increment;
+                int rr = cell.row(r0, row);
+                int cc = cell.col(c0, col);
+                if (!in_board(rr, cc)) break;
+                cache_sum += rr + cc;
+            }
+        }
+        double cache_ms = elapsed_ms(start);
+
+        if (line_sum != cache_sum) std::cout << "  MISMATCH between GridLine and cached paths\n";
+        bench_sink = bench_sink + line_sum + cache_sum;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(6) << size << "x" << std::left << std::setw(3) << size << std::right
+                  << std::setw(13) << line_ms << std::setw(13) << cache_ms
+                  << std::setw(9) << std::setprecision(1) << line_ms / cache_ms << "x"
+                  << std::setw(10) << cache.hits() << "/" << cache.misses() << "\n";
+    }
+}
+
+// The same 1000-round game played silently, recorded to a replay file, and
+// printed as text: what recording costs and how big the files get.
+void BenchArena::bench_replay() {
+    const int size = 40;
+    const int rounds = 1000;
+    const std::string path = "bench_replay.rwr";
+
+    // Pacers keep the game going for all 1000 rounds; a few flamethrower
+    // snipers make sure there are shots, damage and deaths to record. With
+    // `think`, the pacers spend that long on their radar results, the way a
+    // robot with any strategy at all does.
+    auto play = [&](EventSink* sink, ReplayRecorder* recorder, const std::string& file,
+                    std::chrono::microseconds think = std::chrono::microseconds(0)) {
+        Arena arena(size, size);
+        arena.set_event_sink(nullptr);
+        arena.set_seed(17);
+        arena.max_rounds = rounds;
+        arena.load_obstacles();
+
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        Rng rng(18);
+        while (bots.size() < 40) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.') continue;
+            if (bots.size() < 4)
+                bots.push_back(std::make_unique<SniperRobot>(flamethrower, size, size));
+            else if (think.count() > 0)
+                bots.push_back(std::make_unique<ThinkingRobot>(think, false));
+            else
+                bots.push_back(std::make_unique<PacingRobot>());
+            arena.add_robot(bots.back().get(), r, c);
+        }
+
+        if (recorder) {
+            recorder->open(file);
+            recorder->begin(arena);
+        }
+        arena.set_event_sink(sink);
+        arena.set_replay_recorder(recorder);
+        auto start = bench_clock::now();
+        for (int round = 0; round < rounds; ++round) arena.play_round(round);
+        double ms = elapsed_ms(start);
+        if (recorder) recorder->close();
+        return ms;
+    };
+
+    // Best of three (or more), so one noisy run doesn't decide the times.
+    double silent_ms = 1e300, replay_ms = 1e300, text_ms = 1e300;
+    std::uint64_t replay_bytes = 0;
+    std::size_t text_bytes = 0;
+    const std::string events_path = "bench_events.out";
+    const EventFormat formats[2] = { EventFormat::jsonl, EventFormat::csv };
+    double events_ms[2] = { 1e300, 1e300 };
+    double events_close_ms[2] = { 0, 0 };
+    std::uint64_t events_count[2] = { 0, 0 };
+    std::uint64_t events_bytes[2] = { 0, 0 };
+    // The recording overhead is a few percent, less than this machine's
+    // speed drifts from one game to the next, so each replay run is paired
+    // with a silent run next to it (taking turns at going first) and the
+    // overhead is the median of the pairs.
+    auto overhead = [&](int runs, std::chrono::microseconds think, double& best_silent,
+                        double& best_replay) {
+        std::vector<double> pairs;
+        for (int run = 0; run < runs; ++run) {
+            ReplayRecorder recorder;
+            double silent = 0;
+            if (run % 2 == 0) silent = play(nullptr, nullptr, path, think);
+            double replay = play(nullptr, &recorder, path, think);
+            if (run % 2 == 1) silent = play(nullptr, nullptr, path, think);
+            best_silent = std::min(best_silent, silent);
+            best_replay = std::min(best_replay, replay);
+            replay_bytes = recorder.bytes_written();
+            pairs.push_back(100.0 * (replay - silent) / silent);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs[pairs.size() / 2];
+    };
+    double replay_overhead = overhead(31, std::chrono::microseconds(0), silent_ms, replay_ms);
+    double thinking_silent_ms = 1e300, thinking_replay_ms = 1e300;
+    double thinking_overhead = overhead(9, std::chrono::microseconds(2), thinking_silent_ms,
+                                        thinking_replay_ms);
+
+    for (int run = 0; run < 3; ++run) {
+        // close() waits for whatever the writer thread hasn't written yet.
+        for (int f = 0; f < 2; ++f) {
+            EventStream events(formats[f]);
+            events.open(events_path);
+            double ms = play(&events, nullptr, path);
+            auto start = bench_clock::now();
+            events.close();
+            if (ms < events_ms[f]) {
+                events_ms[f] = ms;
+                events_close_ms[f] = elapsed_ms(start);
+            }
+            events_count[f] = events.events_written();
+            std::ifstream in(events_path, std::ios::binary | std::ios::ate);
+            events_bytes[f] = static_cast<std::uint64_t>(in.tellg());
+        }
+
+        std::ostringstream text;
+        std::streambuf* old = std::cout.rdbuf(text.rdbuf());
+        ConsoleSink console;
+        text_ms = std::min(text_ms, play(&console, nullptr, path));
+        std::cout.rdbuf(old);
+        text_bytes = text.str().size();
+    }
+
+    std::cout << "\n=== replay recording (" << size << "x" << size << ", 40 robots, "
+              << rounds << " rounds) ===\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "  no sink        " << std::setw(10) << silent_ms << " ms\n"
+              << "  replay file    " << std::setw(10) << replay_ms << " ms  ("
+              << std::showpos << std::setprecision(1)
+              << replay_overhead << std::noshowpos
+              << "%, median of pairs)  " << replay_bytes << " bytes\n"
+              << "  pacers thinking 2 us a turn: " << std::setprecision(2) << thinking_silent_ms
+              << " ms silent, " << thinking_replay_ms << " ms replay ("
+              << std::showpos << std::setprecision(1) << thinking_overhead << std::noshowpos
+              << "%, median of pairs)\n"
+              << "  text log       " << std::setw(10) << std::setprecision(2) << text_ms
+              << " ms            " << text_bytes << " bytes  (replay is "
+              << std::setprecision(1) << 100.0 * replay_bytes / text_bytes << "%)\n";
+    for (int f = 0; f < 2; ++f) {
+        std::cout << (f == 0 ? "  events jsonl   " : "  events csv     ")
+                  << std::setw(10) << std::setprecision(2) << events_ms[f] << " ms  ("
+                  << std::showpos << std::setprecision(1)
+                  << 100.0 * (events_ms[f] - silent_ms) / silent_ms << std::noshowpos
+                  << "%)  " << events_bytes[f] << " bytes, " << events_count[f]
+                  << " events, " << std::setprecision(1)
+                  << 1e6 * (events_ms[f] - silent_ms) / events_count[f] << " ns/event, "
+                  << std::setprecision(2) << events_close_ms[f] << " ms left at close\n";
+    }
+    std::remove(events_path.c_str());
+
+    // Seeking in the file just written (a keyframe every 32 rounds) and in
+    // one without keyframes, where every seek starts from the header.
+    const std::string flat_path = "bench_replay_flat.rwr";
+    ReplayRecorder flat(0);
+    play(nullptr, &flat, flat_path);
+
+    std::cout << "  seeks          to round 800    200 random seeks   records walked   file bytes\n";
+    for (const std::string& file : { path, flat_path }) {
+        ReplayPlayer player;
+        player.load(file);
+        std::uint64_t before = player.records_applied();
+        auto start = bench_clock::now();
+        player.seek(800);
+        double seek_ms = elapsed_ms(start);
+
+        Rng rng(19);
+        start = bench_clock::now();
+        for (int i = 0; i < 200; ++i) player.seek(rng.between(0, rounds));
+        double random_ms = elapsed_ms(start);
+        bench_sink = bench_sink + player.arena().robot_infos()[0].row;
+
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        std::cout << (file == path ? "  keyframes   " : "  from header ")
+                  << std::setw(12) << std::setprecision(3) << seek_ms << " ms"
+                  << std::setw(16) << std::setprecision(2) << random_ms << " ms"
+                  << std::setw(17) << player.records_applied() - before
+                  << std::setw(13) << static_cast<long long>(in.tellg()) << "\n";
+    }
+    std::remove(path.c_str());
+    std::remove(flat_path.c_str());
+}
+
+// How print_board used to stream a frame: clear the screen, then one
+// insertion per piece of every cell.
+static void stream_board_old(const std::vector<RobotInfo>& robots,
+                             const Grid<char>& board, const Grid<int>& occupancy,
+                             int rows, int cols, int round, std::ostream& out) {
+    out << "\033[H\033[J";
+    out << "=========== starting round " << round << " ===========\n\n";
+    out << "    ";
+    for (int c = 0; c < cols; ++c) {
+        if (c < 10) out << " " << c << " ";
+        else        out << c << " ";
+    }
+    out << "\n";
+    for (int r = 0; r < rows; ++r) {
+        if (r < 10) out << " ";
+        out << r << " ";
+        for (int c = 0; c < cols; ++c) {
+            int idx = occupancy(r, c) - 1;
+            if (idx != -1) {
+                const RobotInfo& info = robots[idx];
+                if (info.alive) out << "R" << info.symbol << " ";
+                else            out << "X" << info.symbol << " ";
+            } else {
+                out << " " << board(r, c) << " ";
+            }
+        }
+        out << "\n\n";
+    }
+    for (const auto& info : robots) {
+        out << info.robot->print_stats();
+        if (!info.alive) out << "  (DEAD)";
+        out << "\n";
+    }
+    out << "\n";
+}
+
+// Live-mode frames for a 60x60 game: the old clear-and-stream print
+// against building the frame once and sending only the changed cells.
+void BenchArena::bench_board_render() {
+    const int size = 60;
+    const int rounds = 200;
+    const int height = 200;   // a terminal tall enough for the whole board
+
+    Arena arena(size, size);
+    arena.set_event_sink(nullptr);
+    arena.set_seed(20);
+    arena.load_obstacles();
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    Rng rng(21);
+    while (bots.size() < 30) {
+        int r = rng.between(0, size - 1);
+        int c = rng.between(0, size - 1);
+        if (arena.get_cell_type(r, c) != '.') continue;
+        if (bots.size() < 4) bots.push_back(std::make_unique<SniperRobot>(flamethrower, size, size));
+        else                 bots.push_back(std::make_unique<PacingRobot>());
+        arena.add_robot(bots.back().get(), r, c);
+    }
+
+    double old_ms = 0, new_ms = 0;
+    std::size_t old_bytes = 0, new_bytes = 0;
+    TerminalRenderer renderer(-1);
+    std::ostringstream old_out;
+    for (int round = 0; round < rounds; ++round) {
+        arena.play_round(round);
+
+        old_out.str("");
+        auto start = bench_clock::now();
+        stream_board_old(arena.robots, arena.board, arena.occupancy,
+                         arena.rows, arena.cols, round, old_out);
+        old_ms += elapsed_ms(start);
+        old_bytes += old_out.str().size();
+
+        start = bench_clock::now();
+        const std::string& update = renderer.render(arena.board_frame(round), height);
+        new_ms += elapsed_ms(start);
+        new_bytes += update.size();
+    }
+
+    int lines = 2 * size + static_cast<int>(bots.size()) + 4;
+    std::cout << "\n=== live-mode frames (" << size << "x" << size << ", " << bots.size()
+              << " robots, " << rounds << " rounds) ===\n";
+    std::cout << std::fixed << std::setprecision(1)
+              << "  clear + stream     " << std::setw(8) << old_ms * 1000 / rounds << " us/frame  "
+              << std::setw(8) << old_bytes / rounds << " bytes/frame  ~" << lines
+              << " writes/frame on a line-buffered tty\n"
+              << "  frame + diff       " << std::setw(8) << new_ms * 1000 / rounds << " us/frame  "
+              << std::setw(8) << new_bytes / rounds << " bytes/frame  1 write/frame\n";
+}
+
+// Full-board scans over the old vector<vector<char>> board and the flat
+// Grid<char>, both row by row and column by column.
+static void bench_board_scan() {
+    const int size = 1000;
+    const int passes = 20;
+
+    NestedBoard nested(size, std::vector<char>(size, '.'));
+    Grid<char> flat(size, size, '.');
+    std::srand(99);
+    for (int i = 0; i < size * size / 20; ++i) {
+        int r = std::rand() % size;
+        int c = std::rand() % size;
+        nested[r][c] = 'M';
+        flat(r, c) = 'M';
+    }
+
+    double nested_rows = time_scan(nested, size, passes,
+        [](const NestedBoard& b, int n) { return scan_rows(b, n); });
+    double flat_rows = time_scan(flat, size, passes,
+        [](const Grid<char>& b, int n) { return scan_rows(b, n); });
+    double nested_cols = time_scan(nested, size, passes,
+        [](const NestedBoard& b, int n) { return scan_cols(b, n); });
+    double flat_cols = time_scan(flat, size, passes,
+        [](const Grid<char>& b, int n) { return scan_cols(b, n); });
+
+    std::cout << "\n=== full-board scan: vector<vector<char>> vs Grid<char> ("
+              << size << "x" << size << ", " << passes << " passes) ===\n";
+    std::cout << std::setw(14) << "order"
+              << std::setw(14) << "nested ms"
+              << std::setw(14) << "flat ms"
+              << std::setw(10) << "speedup" << "\n";
+    std::cout << std::fixed;
+    std::cout << std::setw(14) << "row-major"
+              << std::setw(14) << std::setprecision(2) << nested_rows
+              << std::setw(14) << flat_rows
+              << std::setw(9) << std::setprecision(1) << nested_rows / flat_rows << "x\n";
+    std::cout << std::setw(14) << "column-major"
+              << std::setw(14) << std::setprecision(2) << nested_cols
+              << std::setw(14) << flat_cols
+              << std::setw(9) << std::setprecision(1) << nested_cols / flat_cols << "x\n";
+}
+
+// Damage rolls: the old rand() % range against Rng::between.
+static void bench_damage_rolls() {
+    const int rolls = 20000000;
+
+    std::srand(7);
+    long long total = 0;
+    auto start = bench_clock::now();
+    for (int i = 0; i < rolls; ++i) total += 30 + std::rand() % (50 - 30 + 1);
+    double rand_ms = elapsed_ms(start);
+
+    Rng rng(7);
+    start = bench_clock::now();
+    for (int i = 0; i < rolls; ++i) total += rng.between(30, 50);
+    double rng_ms = elapsed_ms(start);
+    bench_sink = bench_sink + total;
+
+    std::cout << "\n=== damage rolls: rand() % n vs Rng::between (" << rolls << " rolls) ===\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "  rand() %        " << std::setw(10) << rand_ms << " ms\n"
+              << "  Rng::between    " << std::setw(10) << rng_ms << " ms  ("
+              << std::setprecision(1) << rand_ms / rng_ms << "x)\n";
+}
+
+// The same pacing game with phase timing off and on: off should cost
+// nothing measurable, on costs a clock read per phase. Then with a call
+// budget, where every robot callback is timed with two clock reads.
+void BenchArena::bench_phase_timing() {
+    const int size = 40;
+    const int rounds = 1000;
+
+    auto play = [&](bool timing, bool budget) {
+        Arena arena(size, size);
+        arena.set_event_sink(nullptr);
+        arena.set_seed(17);
+        arena.max_rounds = rounds;
+        arena.load_obstacles();
+
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        Rng rng(18);
+        while (bots.size() < 40) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.') continue;
+            if (bots.size() < 4) bots.push_back(std::make_unique<SniperRobot>(flamethrower, size, size));
+            else                 bots.push_back(std::make_unique<PacingRobot>());
+            arena.add_robot(bots.back().get(), r, c);
+        }
+
+        arena.set_phase_timing(timing);
+        if (budget) arena.set_call_budget(std::chrono::seconds(1));
+        auto start = bench_clock::now();
+        for (int round = 0; round < rounds; ++round) arena.play_round(round);
+        double ms = elapsed_ms(start);
+        if (timing) bench_sink = bench_sink + arena.phase_times()->of(0, Phase::radar_scan).count();
+        return ms;
+    };
+
+    double off_ms = 1e300, on_ms = 1e300, budget_ms = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        off_ms = std::min(off_ms, play(false, false));
+        on_ms = std::min(on_ms, play(true, false));
+        budget_ms = std::min(budget_ms, play(false, true));
+    }
+    const double turns = 40.0 * rounds;
+    std::cout << "\n=== phase timing and call budget (" << size << "x" << size << ", 40 robots, "
+              << rounds << " rounds, best of 5) ===\n"
+              << std::fixed << std::setprecision(2)
+              << "  plain        " << std::setw(10) << off_ms << " ms\n"
+              << "  timing on    " << std::setw(10) << on_ms << " ms  ("
+              << std::setprecision(0) << 1e6 * (on_ms - off_ms) / turns << " ns per turn)\n"
+              << "  call budget  " << std::setw(10) << std::setprecision(2) << budget_ms << " ms  ("
+              << std::setprecision(0) << 1e6 * (budget_ms - off_ms) / turns << " ns per turn)\n";
+}
+
+// What a callback to an isolated robot costs: one call through the shared
+// rings against a one-byte ping-pong over two pipes between the same two
+// processes, then the pacing game with every robot in a child process.
+void BenchArena::bench_isolation() {
+    const int calls = 20000;
+
+    std::unique_ptr<IsolatedRobot> proxy =
+        IsolatedRobot::launch([] () -> RobotBase* { return new PacingRobot(); },
+                              std::chrono::microseconds(0));
+    if (!proxy) return;
+    double ring_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto start = bench_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            int dir = 0;
+            proxy->get_radar_direction(dir);
+            bench_sink = bench_sink + dir;
+        }
+        ring_ms = std::min(ring_ms, elapsed_ms(start));
+    }
+    proxy.reset();
+
+    int to_child[2], to_parent[2];
+    if (pipe(to_child) != 0 || pipe(to_parent) != 0) return;
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(to_child[1]);
+        close(to_parent[0]);
+        char byte;
+        while (read(to_child[0], &byte, 1) == 1 && write(to_parent[1], &byte, 1) == 1) {}
+        _exit(0);
+    }
+    double pipe_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto start = bench_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            char byte = static_cast<char>(i);
+            if (write(to_child[1], &byte, 1) != 1 || read(to_parent[0], &byte, 1) != 1) return;
+            bench_sink = bench_sink + byte;
+        }
+        pipe_ms = std::min(pipe_ms, elapsed_ms(start));
+    }
+    close(to_child[1]);
+    waitpid(pid, nullptr, 0);
+    close(to_child[0]);
+    close(to_parent[0]);
+    close(to_parent[1]);
+
+    // The same echo over a pair of bare rings, for the handoff alone
+    // without a robot call's messages around it.
+    struct Rings {
+        SharedRing<std::uint32_t, 16> to_child, to_parent;
+    };
+    void* memory = mmap(nullptr, sizeof(Rings), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return;
+    Rings* rings = new (memory) Rings();
+    std::cout.flush();
+    pid = fork();
+    if (pid == 0) {
+        std::uint32_t value = 0;
+        while (value != ~0u) {
+            while (!rings->to_child.try_pop(value)) rings->to_child.wait_for_item(nullptr);
+            while (!rings->to_parent.try_push(value)) rings->to_parent.wait_for_room(nullptr);
+        }
+        _exit(0);
+    }
+    double bare_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto start = bench_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            std::uint32_t value = static_cast<std::uint32_t>(i);
+            while (!rings->to_child.try_push(value)) rings->to_child.wait_for_room(nullptr);
+            while (!rings->to_parent.try_pop(value)) rings->to_parent.wait_for_item(nullptr);
+            bench_sink = bench_sink + value;
+        }
+        bare_ms = std::min(bare_ms, elapsed_ms(start));
+    }
+    while (!rings->to_child.try_push(~0u)) rings->to_child.wait_for_room(nullptr);
+    waitpid(pid, nullptr, 0);
+    munmap(memory, sizeof(Rings));
+
+    const int size = 40;
+    const int rounds = 200;
+    auto play = [&](bool isolated) {
+        Arena arena(size, size);
+        arena.set_event_sink(nullptr);
+        arena.set_seed(17);
+        arena.max_rounds = rounds;
+        arena.load_obstacles();
+
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        Rng rng(18);
+        while (bots.size() < 40) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.' || arena.find_robot_at(r, c) != -1) continue;
+            if (isolated) {
+                bots.push_back(IsolatedRobot::launch([] () -> RobotBase* { return new PacingRobot(); },
+                                                     std::chrono::microseconds(0)));
+            } else {
+                bots.push_back(std::make_unique<PacingRobot>());
+            }
+            arena.add_robot(bots.back().get(), r, c);
+        }
+
+        auto start = bench_clock::now();
+        for (int round = 0; round < rounds; ++round) arena.play_round(round);
+        return elapsed_ms(start);
+    };
+    double direct_ms = play(false);
+    double isolated_ms = play(true);
+
+    const double turns = 40.0 * rounds;
+    std::cout << "\n=== isolated robots (" << calls << " calls, best of 3) ===\n"
+              << std::fixed << std::setprecision(2)
+              << "  shared rings " << std::setw(10) << ring_ms << " ms  ("
+              << 1e3 * ring_ms / calls << " us per round trip)\n"
+              << "  bare rings   " << std::setw(10) << bare_ms << " ms  ("
+              << 1e3 * bare_ms / calls << " us per round trip)\n"
+              << "  pipes        " << std::setw(10) << pipe_ms << " ms  ("
+              << 1e3 * pipe_ms / calls << " us per round trip)\n"
+              << "  game, 40 pacers x " << rounds << " rounds: " << direct_ms << " ms in process, "
+              << isolated_ms << " ms isolated (" << std::setprecision(1)
+              << 1e3 * (isolated_ms - direct_ms) / turns << " us per turn)\n";
+}
+
+// 32 robots that each think for 200 us a turn, played one at a time and
+// then deciding side by side on 1, 2, 4 and hardware_concurrency threads.
+// Spinning robots only go faster with cores to spread over; sleeping ones
+// overlap on any machine.
+void BenchArena::bench_simultaneous() {
+    const int size = 64;
+    const int rounds = 50;
+    const int count = 32;
+
+    auto play = [&](bool sleeps, bool simultaneous, unsigned int threads) {
+        Arena arena(size, size);
+        arena.set_event_sink(nullptr);
+        arena.set_seed(17);
+        arena.max_rounds = rounds;
+        arena.load_obstacles();
+
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        Rng rng(18);
+        while (bots.size() < count) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.' || arena.find_robot_at(r, c) != -1) continue;
+            bots.push_back(std::make_unique<ThinkingRobot>(std::chrono::microseconds(200), sleeps));
+            arena.add_robot(bots.back().get(), r, c);
+        }
+
+        arena.set_simultaneous(simultaneous, threads);
+        auto start = bench_clock::now();
+        for (int round = 0; round < rounds; ++round) arena.play_round(round);
+        return elapsed_ms(start);
+    };
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> thread_counts = { 1, 2, 4 };
+    if (cores > 4) thread_counts.push_back(cores);
+
+    std::cout << "\n=== simultaneous turns (" << size << "x" << size << ", " << count
+              << " robots thinking 200 us, " << rounds << " rounds, " << cores << " cores) ===\n"
+              << std::fixed << std::setprecision(2);
+    for (bool sleeps : { false, true }) {
+        double one_ms = play(sleeps, false, 0);
+        std::cout << (sleeps ? "  sleeping" : "  spinning") << "  in turn       "
+                  << std::setw(10) << one_ms << " ms\n";
+        for (unsigned int threads : thread_counts) {
+            double ms = play(sleeps, true, threads);
+            std::cout << "            " << std::setw(2) << threads << " thread"
+                      << (threads == 1 ? " " : "s") << "    " << std::setw(10) << ms << " ms  ("
+                      << std::setprecision(1) << one_ms / ms << "x)\n" << std::setprecision(2);
+        }
+    }
+}
+
+// A tournament-shaped load on 4 threads: 24 games of 16 robots that sleep
+// 100 us a turn to think, most over in 4 rounds and a few running 60. The
+// shared-queue ThreadPool can only hand out whole games, so the long ones
+// finish on their own; on the TaskScheduler games decide their turns as
+// jobs on the same workers, and idle workers steal those. Then 200000
+// empty jobs, for what each costs to queue and run.
+void BenchArena::bench_scheduler() {
+    const int threads = 4;
+    const int games = 24;
+    const int size = 32;
+    const int count = 16;
+
+    auto play = [&](int game, TaskScheduler* scheduler) {
+        Arena arena(size, size);
+        arena.set_event_sink(nullptr);
+        arena.set_seed(17 + game);
+        arena.max_rounds = game % 8 == 0 ? 60 : 4;
+        arena.load_obstacles();
+
+        std::vector<std::unique_ptr<RobotBase>> bots;
+        Rng rng(18 + game);
+        while (bots.size() < count) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.' || arena.find_robot_at(r, c) != -1) continue;
+            bots.push_back(std::make_unique<ThinkingRobot>(std::chrono::microseconds(100), true));
+            arena.add_robot(bots.back().get(), r, c);
+        }
+        arena.set_simultaneous(true, 1);
+        arena.set_scheduler(scheduler);
+        arena.run();
+        bench_sink = bench_sink + arena.rounds_played();
+    };
+
+    double pool_ms, stealing_ms;
+    std::vector<WorkerStats> usage;
+    {
+        auto start = bench_clock::now();
+        ThreadPool pool(threads);
+        for (int game = 0; game < games; ++game) pool.submit([&, game] { play(game, nullptr); });
+        pool.wait_idle();
+        pool_ms = elapsed_ms(start);
+    }
+    {
+        auto start = bench_clock::now();
+        TaskScheduler scheduler(threads);
+        for (int game = 0; game < games; ++game) {
+            scheduler.submit([&, game] { play(game, &scheduler); });
+        }
+        scheduler.wait_idle();
+        stealing_ms = elapsed_ms(start);
+        usage = scheduler.worker_stats();
+    }
+
+    const int jobs = 200000;
+    std::atomic<long long> counted{0};
+    double pool_job_ms, stealing_job_ms;
+    {
+        ThreadPool pool(threads);
+        auto start = bench_clock::now();
+        for (int i = 0; i < jobs; ++i) pool.submit([&] { counted++; });
+        pool.wait_idle();
+        pool_job_ms = elapsed_ms(start);
+    }
+    {
+        TaskScheduler scheduler(threads);
+        auto start = bench_clock::now();
+        for (int i = 0; i < jobs; ++i) scheduler.submit([&] { counted++; });
+        scheduler.wait_idle();
+        stealing_job_ms = elapsed_ms(start);
+    }
+    bench_sink = bench_sink + counted.load();
+
+    std::cout << "\n=== work-stealing scheduler vs shared queue (" << threads << " threads, "
+              << games << " games of " << count << " robots, 3 of 60 rounds, the rest 4) ===\n"
+              << std::fixed << std::setprecision(2)
+              << "  shared queue, whole games " << std::setw(10) << pool_ms << " ms\n"
+              << "  work stealing, turn jobs  " << std::setw(10) << stealing_ms << " ms  ("
+              << std::setprecision(1) << pool_ms / stealing_ms << "x)\n";
+    print_worker_stats(std::cout, usage);
+    std::cout << std::setprecision(2)
+              << "  " << jobs << " empty jobs: shared queue " << pool_job_ms << " ms, work stealing "
+              << stealing_job_ms << " ms\n";
+}
+
+// A 4096x4096 board with 5% obstacles: made at random, saved as a map,
+// then loaded back, 8 robots dropped on it and one round played. Loading
+// maps the file and reads it through once for the checksum; nothing is
+// parsed. The file is in the page cache after saving, as a map that gets
+// played often would be.
+void BenchArena::bench_map_load() {
+    const int size = 4096;
+    const std::string path = "bench_map.rwm";
+
+    auto start = bench_clock::now();
+    Arena generated(size, size);
+    generated.set_event_sink(nullptr);
+    generated.set_seed(23);
+    generated.num_mounds = size * size / 40;
+    generated.num_pits = size * size / 80;
+    generated.num_flames = size * size / 80;
+    generated.load_obstacles();
+    double random_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    if (!generated.save_map(path)) return;
+    double save_ms = elapsed_ms(start);
+
+    std::vector<std::unique_ptr<RobotBase>> bots;
+    double load_ms = 1e300, ready_ms = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        start = bench_clock::now();
+        Arena arena;
+        arena.set_event_sink(nullptr);
+        if (!arena.load_map(path)) return;
+        load_ms = std::min(load_ms, elapsed_ms(start));
+
+        bots.clear();
+        Rng rng(24);
+        while (bots.size() < 8) {
+            int r = rng.between(0, size - 1);
+            int c = rng.between(0, size - 1);
+            if (arena.get_cell_type(r, c) != '.') continue;
+            bots.push_back(std::make_unique<PacingRobot>());
+            arena.add_robot(bots.back().get(), r, c);
+        }
+        arena.play_round(0);
+        ready_ms = std::min(ready_ms, elapsed_ms(start));
+    }
+    std::remove(path.c_str());
+
+    std::cout << "\n=== map files (" << size << "x" << size << ", 5% obstacles, best of 5) ===\n"
+              << std::fixed << std::setprecision(2)
+              << "  random board      " << std::setw(10) << random_ms << " ms\n"
+              << "  save as map       " << std::setw(10) << save_ms << " ms\n"
+              << "  load map          " << std::setw(10) << load_ms << " ms\n"
+              << "  + 8 robots, round " << std::setw(10) << ready_ms << " ms\n";
+}
+
+void BenchArena::bench_placement() {
+    const int size = 1000;
+    const int cells = size * size;
+
+    // Rejection sampling, as load_obstacles placed them before the shuffle:
+    // draw any cell, try again if it is taken.
+    auto place_old = [](Arena& arena, Rng& rng, int count) {
+        for (int placed = 0; placed < count; ) {
+            int r = rng.between(0, arena.rows - 1);
+            int c = rng.between(0, arena.cols - 1);
+            if (arena.board(r, c) == '.') {
+                arena.board(r, c) = 'M';
+                arena.update_cell(r, c);
+                placed++;
+            }
+        }
+    };
+
+    std::cout << "\n=== obstacle placement (" << size << "x" << size << ", best of 3) ===\n"
+              << "  density  rejection     shuffle\n";
+    for (int percent : { 10, 50, 90, 99, 100 }) {
+        int count = static_cast<int>(static_cast<long long>(cells) * percent / 100);
+        double old_ms = 1e300, new_ms = 1e300;
+        for (int run = 0; run < 3; ++run) {
+            Arena arena(size, size);
+            arena.set_event_sink(nullptr);
+            Rng rng(31);
+            auto start = bench_clock::now();
+            // At 100% the last cell takes a million draws on its own.
+            if (percent < 100) place_old(arena, rng, count);
+            old_ms = std::min(old_ms, elapsed_ms(start));
+
+            Arena shuffled(size, size);
+            shuffled.set_event_sink(nullptr);
+            shuffled.set_seed(31);
+            shuffled.num_mounds = count;
+            shuffled.num_pits = 0;
+            shuffled.num_flames = 0;
+            start = bench_clock::now();
+            shuffled.load_obstacles();
+            new_ms = std::min(new_ms, elapsed_ms(start));
+        }
+        std::cout << std::fixed << std::setprecision(1)
+                  << "  " << std::setw(5) << percent << "%  ";
+        if (percent < 100) std::cout << std::setw(9) << old_ms << " ms";
+        else               std::cout << std::setw(12) << "-";
+        std::cout << std::setw(9) << new_ms << " ms\n";
+    }
+}
+
+int main() {
+    // Before any bench starts a thread: isolated robots are forked from it.
+    IsolatedRobot::start_launcher();
+
+    BenchArena bench;
+    bench.bench_robot_lookup();
+    bench.bench_radar_scan();
+    bench.bench_cell_planes();
+    bench.bench_turn_allocations();
+    bench.bench_line_paths();
+    bench.bench_shot_paths();
+    bench.bench_replay();
+    bench.bench_board_render();
+    bench.bench_phase_timing();
+    bench.bench_isolation();
+    bench.bench_simultaneous();
+    bench.bench_scheduler();
+    bench.bench_map_load();
+    bench.bench_placement();
+    bench_board_scan();
+    bench_damage_rolls();
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include "TestArena.h"
 #include "Arena.h"
+#include "IsolatedRobot.h"
 #include "RobotBase.h"
 #include <iostream>
 #include <vector>
@@ -10,6 +11,9 @@
 int main() {
     TestArena tester;
 
+    // Before any test starts a thread: isolated robots are forked from it.
+    IsolatedRobot::start_launcher();
+
     // Test RobotBase creation
     std::cout << "\n=== Testing RobotBase Creation ===\n";
     tester.test_robot_creation();
@@ -19,10 +23,34 @@ int main() {
     tester.test_initialize_board();
     tester.test_handle_move();
     tester.test_handle_collision();
+    tester.test_occupancy_grid();
+    tester.test_grid_line();
+    tester.test_footprint_cache();
+    tester.test_seeded_arena();
+    tester.test_replay_recorder();
+    tester.test_replay_player();
+    tester.test_terminal_renderer();
+    tester.test_event_stream();
+    tester.test_phase_timing();
+    tester.test_call_budget();
+    tester.test_isolated_robots();
+    tester.test_turn_robots();
+    tester.test_simultaneous_turns();
+    tester.test_task_scheduler();
+    tester.test_map_files();
+    tester.test_placement();
+    tester.test_sweeps();
+    tester.test_grid_bounds();
+    tester.test_silent_sink();
+    tester.test_tournament_tally();
+    tester.test_budget_command_line();
+    tester.test_simultaneous_command_line();
 
     //test radar
     tester.test_radar();
     tester.test_radar_local();
+    tester.test_radar_engine();
+    tester.test_cell_planes();
 
     // Test BadRobot with all weapon configurations
     std::cout << "\n=== Testing Weapons ===\n";